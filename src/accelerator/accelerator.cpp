@@ -24,13 +24,13 @@ struct accelerator::impl
     {
     }
 
-    std::unique_ptr<core::image_mixer> create_image_mixer(int channel_id)
+    std::unique_ptr<core::image_mixer> create_image_mixer(int channel_id, core::color_depth depth)
     {
         if (!ogl_device_) {
             ogl_device_.reset(new ogl::device());
         }
 
-        return std::make_unique<ogl::image_mixer>(spl::make_shared_ptr(ogl_device_), channel_id);
+        return std::make_unique<ogl::image_mixer>(spl::make_shared_ptr(ogl_device_), channel_id, depth);
     }
 };
 
@@ -41,9 +41,9 @@ accelerator::accelerator(const std::wstring& path)
 
 accelerator::~accelerator() {}
 
-std::unique_ptr<core::image_mixer> accelerator::create_image_mixer(int channel_id)
+std::unique_ptr<core::image_mixer> accelerator::create_image_mixer(int channel_id, core::color_depth depth)
 {
-    return impl_->create_image_mixer(channel_id);
+    return impl_->create_image_mixer(channel_id, depth);
 }
 
 }} // namespace caspar::accelerator
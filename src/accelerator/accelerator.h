@@ -1,5 +1,7 @@
 #pragma once
 
+#include <core/frame/pixel_format.h>
+
 #include <memory>
 #include <string>
 
@@ -14,7 +16,8 @@ class accelerator
 
     accelerator& operator=(accelerator&) = delete;
 
-    std::unique_ptr<core::image_mixer> create_image_mixer(int channel_id);
+    std::unique_ptr<core::image_mixer> create_image_mixer(int               channel_id,
+                                                          core::color_depth depth = core::color_depth::eight);
 
   private:
     struct impl;
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "blend.h"
+#include "blend_kernel.h"
+
+#include "../util/simd.h"
+
+#include <tbb/parallel_for.h>
+
+namespace caspar { namespace accelerator { namespace cpu {
+
+namespace detail {
+
+bool has_avx2()
+{
+    static const bool value = [] {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) {
+            return false;
+        }
+        __cpuid(info, 1);
+        const auto os_avx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+        __cpuidex(info, 7, 0);
+        return os_avx && (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+#endif
+    }();
+    return value;
+}
+
+} // namespace detail
+
+void blend(std::uint8_t*       dest,
+           const std::uint8_t* source,
+           const std::uint8_t* local_key,
+           const std::uint8_t* layer_key,
+           std::size_t         count,
+           core::blend_mode    mode,
+           cpu::keyer          keyer,
+           float               opacity)
+{
+    const auto additive = keyer == cpu::keyer::additive;
+
+    if (detail::has_avx2()) {
+        detail::blend_avx2(dest, source, local_key, layer_key, count, mode, additive, opacity);
+    } else {
+        detail::blend_span<vec_sse>(dest, source, local_key, layer_key, count, mode, additive, opacity);
+    }
+}
+
+void blend_key(std::uint8_t* key, const std::uint8_t* source, std::size_t count)
+{
+    if (detail::has_avx2()) {
+        detail::blend_key_avx2(key, source, count);
+    } else {
+        detail::blend_key_span<vec_sse>(key, source, count);
+    }
+}
+
+void blend(std::uint8_t*       dest,
+           const std::uint8_t* source,
+           const std::uint8_t* local_key,
+           const std::uint8_t* layer_key,
+           int                 width,
+           int                 height,
+           core::blend_mode    mode,
+           cpu::keyer          keyer,
+           float               opacity)
+{
+    tbb::parallel_for(tbb::blocked_range<int>(0, height, 16), [&](const tbb::blocked_range<int>& r) {
+        const auto offset = static_cast<std::size_t>(r.begin()) * width;
+        const auto count  = static_cast<std::size_t>(r.size()) * width;
+
+        blend(dest + offset * 4,
+              source + offset * 4,
+              local_key ? local_key + offset : nullptr,
+              layer_key ? layer_key + offset : nullptr,
+              count,
+              mode,
+              keyer,
+              opacity);
+    });
+}
+
+void blend_key(std::uint8_t* key, const std::uint8_t* source, int width, int height)
+{
+    tbb::parallel_for(tbb::blocked_range<int>(0, height, 16), [&](const tbb::blocked_range<int>& r) {
+        const auto offset = static_cast<std::size_t>(r.begin()) * width;
+        blend_key(key + offset, source + offset * 4, static_cast<std::size_t>(r.size()) * width);
+    });
+}
+
+}}} // namespace caspar::accelerator::cpu
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <core/mixer/image/blend_modes.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace caspar { namespace accelerator { namespace cpu {
+
+enum class keyer
+{
+    linear = 0,
+    additive,
+};
+
+// Composites count premultiplied BGRA source pixels onto dest the way the image shader does. The source is scaled
+// by the optional 8 bit local and layer keys and by opacity, combined with dest using mode and then keyed on top
+// of it. Runs with AVX2 when the CPU supports it and SSE4.1 otherwise.
+void blend(std::uint8_t*       dest,
+           const std::uint8_t* source,
+           const std::uint8_t* local_key,
+           const std::uint8_t* layer_key,
+           std::size_t         count,
+           core::blend_mode    mode    = core::blend_mode::normal,
+           cpu::keyer          keyer   = cpu::keyer::linear,
+           float               opacity = 1.0f);
+
+// Composites the red channel of count premultiplied BGRA source pixels onto an 8 bit key, as drawing an is_key
+// item does.
+void blend_key(std::uint8_t* key, const std::uint8_t* source, std::size_t count);
+
+// Image variants of the above for tightly packed width x height buffers, processed in parallel row bands.
+void blend(std::uint8_t*       dest,
+           const std::uint8_t* source,
+           const std::uint8_t* local_key,
+           const std::uint8_t* layer_key,
+           int                 width,
+           int                 height,
+           core::blend_mode    mode,
+           cpu::keyer          keyer,
+           float               opacity);
+void blend_key(std::uint8_t* key, const std::uint8_t* source, int width, int height);
+
+}}} // namespace caspar::accelerator::cpu
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ */
+// Compiled for AVX2 with a target pragma rather than per file flags, so that the precompiled header stays valid.
+// blend.cpp only calls into here after checking the CPU.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+#include "blend_kernel.h"
+
+#include <immintrin.h>
+
+namespace caspar { namespace accelerator { namespace cpu { namespace detail {
+
+// Eight pixels per vector, one channel per register.
+struct vec_avx2
+{
+    static const int width = 8;
+
+    __m256 v;
+
+    vec_avx2() = default;
+    vec_avx2(__m256 v)
+        : v(v)
+    {
+    }
+    explicit vec_avx2(float x)
+        : v(_mm256_set1_ps(x))
+    {
+    }
+
+    static void load_bgra(const std::uint8_t* src, vec_avx2& b, vec_avx2& g, vec_avx2& r, vec_avx2& a)
+    {
+        const auto scale = _mm256_set1_ps(1.0f / 255.0f);
+        const auto mask  = _mm256_set1_epi32(0xFF);
+        const auto v     = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+
+        b = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(v, mask)), scale);
+        g = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(v, 8), mask)), scale);
+        r = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(v, 16), mask)), scale);
+        a = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(v, 24)), scale);
+    }
+
+    static void store_bgra(std::uint8_t* dest, vec_avx2 b, vec_avx2 g, vec_avx2 r, vec_avx2 a)
+    {
+        const auto v = _mm256_or_si256(_mm256_or_si256(to_int(b), _mm256_slli_epi32(to_int(g), 8)),
+                                       _mm256_or_si256(_mm256_slli_epi32(to_int(r), 16), _mm256_slli_epi32(to_int(a), 24)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest), v);
+    }
+
+    static vec_avx2 load_key(const std::uint8_t* src)
+    {
+        const auto v = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src)));
+        return _mm256_mul_ps(_mm256_cvtepi32_ps(v), _mm256_set1_ps(1.0f / 255.0f));
+    }
+
+    static void store_key(std::uint8_t* dest, vec_avx2 k)
+    {
+        const auto v     = to_int(k);
+        const auto words = _mm_packs_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dest), _mm_packus_epi16(words, words));
+    }
+
+    static __m256i to_int(vec_avx2 x)
+    {
+        const auto clamped = _mm256_min_ps(_mm256_max_ps(x.v, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+        return _mm256_cvtps_epi32(_mm256_mul_ps(clamped, _mm256_set1_ps(255.0f)));
+    }
+};
+
+inline vec_avx2 operator+(vec_avx2 a, vec_avx2 b) { return _mm256_add_ps(a.v, b.v); }
+inline vec_avx2 operator-(vec_avx2 a, vec_avx2 b) { return _mm256_sub_ps(a.v, b.v); }
+inline vec_avx2 operator*(vec_avx2 a, vec_avx2 b) { return _mm256_mul_ps(a.v, b.v); }
+inline vec_avx2 operator/(vec_avx2 a, vec_avx2 b) { return _mm256_div_ps(a.v, b.v); }
+inline vec_avx2 operator<(vec_avx2 a, vec_avx2 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+inline vec_avx2 operator>(vec_avx2 a, vec_avx2 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ); }
+inline vec_avx2 operator==(vec_avx2 a, vec_avx2 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ); }
+inline vec_avx2 min(vec_avx2 a, vec_avx2 b) { return _mm256_min_ps(a.v, b.v); }
+inline vec_avx2 max(vec_avx2 a, vec_avx2 b) { return _mm256_max_ps(a.v, b.v); }
+inline vec_avx2 abs(vec_avx2 a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v); }
+inline vec_avx2 select(vec_avx2 mask, vec_avx2 a, vec_avx2 b) { return _mm256_blendv_ps(b.v, a.v, mask.v); }
+
+void blend_avx2(std::uint8_t*       dest,
+                const std::uint8_t* source,
+                const std::uint8_t* local_key,
+                const std::uint8_t* layer_key,
+                std::size_t         count,
+                core::blend_mode    mode,
+                bool                additive,
+                float               opacity)
+{
+    blend_span<vec_avx2>(dest, source, local_key, layer_key, count, mode, additive, opacity);
+}
+
+void blend_key_avx2(std::uint8_t* key, const std::uint8_t* source, std::size_t count)
+{
+    blend_key_span<vec_avx2>(key, source, count);
+}
+
+}}}} // namespace caspar::accelerator::cpu::detail
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
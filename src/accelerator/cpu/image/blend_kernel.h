@@ -0,0 +1,382 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <core/mixer/image/blend_modes.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Shared by the SSE and AVX2 translation units. Everything is templated on the vector type so that the code
+// generated for different instruction sets never collides at link time.
+
+namespace caspar { namespace accelerator { namespace cpu { namespace detail {
+
+bool has_avx2();
+
+void blend_avx2(std::uint8_t*       dest,
+                const std::uint8_t* source,
+                const std::uint8_t* local_key,
+                const std::uint8_t* layer_key,
+                std::size_t         count,
+                core::blend_mode    mode,
+                bool                additive,
+                float               opacity);
+void blend_key_avx2(std::uint8_t* key, const std::uint8_t* source, std::size_t count);
+
+template <typename V>
+V overlay(V base, V blend)
+{
+    const V one(1.0f);
+    const V two(2.0f);
+    return select(base < V(0.5f), two * base * blend, one - two * (one - base) * (one - blend));
+}
+
+template <typename V>
+V color_dodge(V base, V blend)
+{
+    const V one(1.0f);
+    return select(blend == one, blend, min(base / (one - blend), one));
+}
+
+template <typename V>
+V color_burn(V base, V blend)
+{
+    const V one(1.0f);
+    const V zero(0.0f);
+    return select(blend == zero, blend, max(one - (one - base) / blend, zero));
+}
+
+template <typename V>
+V vivid_light(V base, V blend)
+{
+    const V half(0.5f);
+    const V two(2.0f);
+    return select(blend < half, color_burn(base, two * blend), color_dodge(base, two * (blend - half)));
+}
+
+template <typename V>
+V reflect(V base, V blend)
+{
+    const V one(1.0f);
+    return select(blend == one, blend, min(base * base / (one - blend), one));
+}
+
+// Separable modes, blend_modes.h order. Mirrors blending_glsl.h, including soft_light being disabled there.
+template <typename V>
+V blend_channel(core::blend_mode mode, V base, V blend)
+{
+    const V zero(0.0f);
+    const V half(0.5f);
+    const V one(1.0f);
+    const V two(2.0f);
+
+    switch (mode) {
+        case core::blend_mode::lighten:
+            return max(blend, base);
+        case core::blend_mode::darken:
+            return min(blend, base);
+        case core::blend_mode::multiply:
+            return base * blend;
+        case core::blend_mode::average:
+            return (base + blend) * half;
+        case core::blend_mode::add:
+        case core::blend_mode::linear_dodge:
+            return min(base + blend, one);
+        case core::blend_mode::subtract:
+        case core::blend_mode::linear_burn:
+            return max(base + blend - one, zero);
+        case core::blend_mode::difference:
+            return abs(base - blend);
+        case core::blend_mode::negation:
+            return one - abs(one - base - blend);
+        case core::blend_mode::exclusion:
+            return base + blend - two * base * blend;
+        case core::blend_mode::screen:
+            return one - (one - base) * (one - blend);
+        case core::blend_mode::overlay:
+            return overlay(base, blend);
+        case core::blend_mode::hard_light:
+            return overlay(blend, base);
+        case core::blend_mode::color_dodge:
+            return color_dodge(base, blend);
+        case core::blend_mode::color_burn:
+            return color_burn(base, blend);
+        case core::blend_mode::linear_light:
+            return select(blend < half, max(base + two * blend - one, zero), min(base + two * (blend - half), one));
+        case core::blend_mode::vivid_light:
+            return vivid_light(base, blend);
+        case core::blend_mode::pin_light:
+            return select(blend < half, min(base, two * blend), max(base, two * (blend - half)));
+        case core::blend_mode::hard_mix:
+            return select(vivid_light(base, blend) < half, zero, one);
+        case core::blend_mode::reflect:
+            return reflect(base, blend);
+        case core::blend_mode::glow:
+            return reflect(blend, base);
+        case core::blend_mode::phoenix:
+            return min(base, blend) - max(base, blend) + one;
+        default:
+            return blend;
+    }
+}
+
+template <typename V>
+void rgb_to_hsl(V r, V g, V b, V& h, V& s, V& l)
+{
+    const V zero(0.0f);
+    const V half(0.5f);
+    const V one(1.0f);
+    const V two(2.0f);
+    const V sixth(1.0f / 6.0f);
+
+    const auto lo    = min(min(r, g), b);
+    const auto hi    = max(max(r, g), b);
+    const auto delta = hi - lo;
+    const auto gray  = delta == zero;
+
+    l = (hi + lo) * half;
+    s = select(gray, zero, select(l < half, delta / (hi + lo), delta / (two - hi - lo)));
+
+    const auto delta_r = ((hi - r) * sixth + delta * half) / delta;
+    const auto delta_g = ((hi - g) * sixth + delta * half) / delta;
+    const auto delta_b = ((hi - b) * sixth + delta * half) / delta;
+
+    h = select(r == hi,
+               delta_b - delta_g,
+               select(g == hi, V(1.0f / 3.0f) + delta_r - delta_b, V(2.0f / 3.0f) + delta_g - delta_r));
+    h = select(h < zero, h + one, select(h > one, h - one, h));
+    h = select(gray, zero, h);
+}
+
+template <typename V>
+V hue_to_rgb(V f1, V f2, V hue)
+{
+    const V zero(0.0f);
+    const V one(1.0f);
+    const V two(2.0f);
+    const V three(3.0f);
+    const V six(6.0f);
+
+    hue = select(hue < zero, hue + one, select(hue > one, hue - one, hue));
+
+    return select(six * hue < one,
+                  f1 + (f2 - f1) * six * hue,
+                  select(two * hue < one,
+                         f2,
+                         select(three * hue < two, f1 + (f2 - f1) * (V(2.0f / 3.0f) - hue) * six, f1)));
+}
+
+template <typename V>
+void hsl_to_rgb(V h, V s, V l, V& r, V& g, V& b)
+{
+    const V zero(0.0f);
+    const V half(0.5f);
+    const V one(1.0f);
+    const V two(2.0f);
+    const V third(1.0f / 3.0f);
+
+    const auto f2 = select(l < half, l * (one + s), (l + s) - (s * l));
+    const auto f1 = two * l - f2;
+    const auto gray = s == zero;
+
+    r = select(gray, l, hue_to_rgb(f1, f2, h + third));
+    g = select(gray, l, hue_to_rgb(f1, f2, h));
+    b = select(gray, l, hue_to_rgb(f1, f2, h - third));
+}
+
+// Replaces the unpremultiplied fore color with the blend of it onto base.
+template <typename V>
+void blend_color(core::blend_mode mode, V& r, V& g, V& b, V base_r, V base_g, V base_b)
+{
+    if (mode < core::blend_mode::contrast) {
+        r = blend_channel(mode, base_r, r);
+        g = blend_channel(mode, base_g, g);
+        b = blend_channel(mode, base_b, b);
+        return;
+    }
+
+    V base_h, base_s, base_l;
+    V fore_h, fore_s, fore_l;
+    rgb_to_hsl(base_r, base_g, base_b, base_h, base_s, base_l);
+    rgb_to_hsl(r, g, b, fore_h, fore_s, fore_l);
+
+    // blend_modes.h calls the hue mode contrast.
+    switch (mode) {
+        case core::blend_mode::contrast:
+            hsl_to_rgb(fore_h, base_s, base_l, r, g, b);
+            break;
+        case core::blend_mode::saturation:
+            hsl_to_rgb(base_h, fore_s, base_l, r, g, b);
+            break;
+        case core::blend_mode::color:
+            hsl_to_rgb(fore_h, fore_s, base_l, r, g, b);
+            break;
+        case core::blend_mode::luminosity:
+            hsl_to_rgb(base_h, base_s, fore_l, r, g, b);
+            break;
+        default:
+            break;
+    }
+}
+
+template <typename V>
+void blend_pixels(std::uint8_t*       dest,
+                  const std::uint8_t* source,
+                  const std::uint8_t* local_key,
+                  const std::uint8_t* layer_key,
+                  core::blend_mode    mode,
+                  bool                additive,
+                  float               opacity)
+{
+    V fore_b, fore_g, fore_r, fore_a;
+    V::load_bgra(source, fore_b, fore_g, fore_r, fore_a);
+
+    auto scale = V(opacity);
+    if (local_key) {
+        scale = scale * V::load_key(local_key);
+    }
+    if (layer_key) {
+        scale = scale * V::load_key(layer_key);
+    }
+
+    fore_b = fore_b * scale;
+    fore_g = fore_g * scale;
+    fore_r = fore_r * scale;
+    fore_a = fore_a * scale;
+
+    V back_b, back_g, back_r, back_a;
+    V::load_bgra(dest, back_b, back_g, back_r, back_a);
+
+    if (mode != core::blend_mode::normal && mode != core::blend_mode::soft_light && mode < core::blend_mode::mix) {
+        const V epsilon(0.0000001f);
+
+        const auto back_div = back_a + epsilon;
+        const auto fore_div = fore_a + epsilon;
+
+        auto r = fore_r / fore_div;
+        auto g = fore_g / fore_div;
+        auto b = fore_b / fore_div;
+
+        blend_color(mode, r, g, b, back_r / back_div, back_g / back_div, back_b / back_div);
+
+        fore_r = r * fore_a;
+        fore_g = g * fore_a;
+        fore_b = b * fore_a;
+    }
+
+    if (!additive) {
+        const auto inverse = V(1.0f) - fore_a;
+        back_b             = back_b * inverse;
+        back_g             = back_g * inverse;
+        back_r             = back_r * inverse;
+        back_a             = back_a * inverse;
+    }
+
+    V::store_bgra(dest, fore_b + back_b, fore_g + back_g, fore_r + back_r, fore_a + back_a);
+}
+
+template <typename V>
+void blend_key_pixels(std::uint8_t* key, const std::uint8_t* source)
+{
+    V b, g, r, a;
+    V::load_bgra(source, b, g, r, a);
+    V::store_key(key, r + (V(1.0f) - a) * V::load_key(key));
+}
+
+template <typename V>
+void blend_span(std::uint8_t*       dest,
+                const std::uint8_t* source,
+                const std::uint8_t* local_key,
+                const std::uint8_t* layer_key,
+                std::size_t         count,
+                core::blend_mode    mode,
+                bool                additive,
+                float               opacity)
+{
+    const std::size_t width = V::width;
+
+    std::size_t x = 0;
+    for (; x + width <= count; x += width) {
+        blend_pixels<V>(dest + x * 4,
+                        source + x * 4,
+                        local_key ? local_key + x : nullptr,
+                        layer_key ? layer_key + x : nullptr,
+                        mode,
+                        additive,
+                        opacity);
+    }
+
+    if (x < count) {
+        const auto rest = count - x;
+
+        std::uint8_t dest_tail[V::width * 4]   = {};
+        std::uint8_t source_tail[V::width * 4] = {};
+        std::uint8_t local_tail[V::width]      = {};
+        std::uint8_t layer_tail[V::width]      = {};
+
+        std::memcpy(dest_tail, dest + x * 4, rest * 4);
+        std::memcpy(source_tail, source + x * 4, rest * 4);
+        if (local_key) {
+            std::memcpy(local_tail, local_key + x, rest);
+        }
+        if (layer_key) {
+            std::memcpy(layer_tail, layer_key + x, rest);
+        }
+
+        blend_pixels<V>(dest_tail,
+                        source_tail,
+                        local_key ? local_tail : nullptr,
+                        layer_key ? layer_tail : nullptr,
+                        mode,
+                        additive,
+                        opacity);
+
+        std::memcpy(dest + x * 4, dest_tail, rest * 4);
+    }
+}
+
+template <typename V>
+void blend_key_span(std::uint8_t* key, const std::uint8_t* source, std::size_t count)
+{
+    const std::size_t width = V::width;
+
+    std::size_t x = 0;
+    for (; x + width <= count; x += width) {
+        blend_key_pixels<V>(key + x, source + x * 4);
+    }
+
+    if (x < count) {
+        const auto rest = count - x;
+
+        std::uint8_t key_tail[V::width]        = {};
+        std::uint8_t source_tail[V::width * 4] = {};
+
+        std::memcpy(key_tail, key + x, rest);
+        std::memcpy(source_tail, source + x * 4, rest * 4);
+
+        blend_key_pixels<V>(key_tail, source_tail);
+
+        std::memcpy(key + x, key_tail, rest);
+    }
+}
+
+}}}} // namespace caspar::accelerator::cpu::detail
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "chroma_key.h"
+
+#include "../util/simd.h"
+
+#include <tbb/parallel_for.h>
+
+namespace caspar { namespace accelerator { namespace cpu {
+
+namespace {
+
+struct chroma_params
+{
+    vec_sse target_hue;
+    vec_sse hue_width;
+    vec_sse min_saturation;
+    vec_sse min_brightness;
+    vec_sse softness;
+    vec_sse spill_suppress;
+    vec_sse spill_suppress_saturation;
+    bool    show_mask;
+
+    explicit chroma_params(const core::chroma& chroma)
+        : target_hue(static_cast<float>(chroma.target_hue / 360.0))
+        , hue_width(static_cast<float>(chroma.hue_width))
+        , min_saturation(static_cast<float>(chroma.min_saturation))
+        , min_brightness(static_cast<float>(chroma.min_brightness))
+        , softness(static_cast<float>(chroma.softness))
+        , spill_suppress(static_cast<float>(chroma.spill_suppress / 360.0))
+        , spill_suppress_saturation(static_cast<float>(chroma.spill_suppress_saturation))
+        , show_mask(chroma.show_mask)
+    {
+    }
+};
+
+void rgb_to_hsv(vec_sse r, vec_sse g, vec_sse b, vec_sse& h, vec_sse& s, vec_sse& v)
+{
+    const vec_sse zero(0.0f);
+
+    // Branchless form of rgb2hsv in blending_glsl.h.
+    const auto g_ge_b = g >= b;
+    const auto p_x    = select(g_ge_b, g, b);
+    const auto p_y    = select(g_ge_b, b, g);
+    const auto p_z    = select(g_ge_b, zero, vec_sse(2.0f / 3.0f));
+    const auto p_w    = select(g_ge_b, vec_sse(-1.0f / 3.0f), vec_sse(-1.0f));
+
+    const auto r_ge_p = r >= p_x;
+    const auto q_x    = select(r_ge_p, r, p_x);
+    const auto q_y    = p_y;
+    const auto q_z    = select(r_ge_p, p_w, p_z);
+    const auto q_w    = select(r_ge_p, p_x, r);
+
+    const auto d = q_x - min(q_w, q_y);
+    const vec_sse e(1.0e-10f);
+
+    h = abs(q_z + (q_w - q_y) / (vec_sse(6.0f) * d + e));
+    s = d / (q_x + e);
+    v = q_x;
+}
+
+void hsv_to_rgb(vec_sse h, vec_sse s, vec_sse v, vec_sse& r, vec_sse& g, vec_sse& b)
+{
+    const vec_sse zero(0.0f);
+    const vec_sse one(1.0f);
+    const vec_sse three(3.0f);
+    const vec_sse six(6.0f);
+
+    auto channel = [&](vec_sse offset) {
+        const auto x = h + offset;
+        const auto p = abs((x - floor(x)) * six - three);
+        return v * (one + (min(max(p - one, zero), one) - one) * s);
+    };
+
+    r = channel(zero);
+    g = channel(vec_sse(2.0f / 3.0f));
+    b = channel(vec_sse(1.0f / 3.0f));
+}
+
+vec_sse angle_diff(vec_sse a, vec_sse b)
+{
+    const vec_sse half(0.5f);
+    return half - abs(abs(a - b) - half);
+}
+
+vec_sse angle_diff_directional(vec_sse a, vec_sse b)
+{
+    const vec_sse half(0.5f);
+    const vec_sse one(1.0f);
+
+    const auto diff = a - b;
+    return select(diff < vec_sse(-0.5f), diff + one, select(diff > half, diff - one, diff));
+}
+
+void chroma_key_pixels(std::uint8_t* pixels, const chroma_params& params)
+{
+    const vec_sse zero(0.0f);
+    const vec_sse one(1.0f);
+    const vec_sse two(2.0f);
+    const vec_sse three(3.0f);
+
+    vec_sse b, g, r, a;
+    vec_sse::load_bgra(pixels, b, g, r, a);
+
+    const auto inverse = one / select(a > zero, a, one);
+
+    vec_sse h, s, v;
+    rgb_to_hsv(r * inverse, g * inverse, b * inverse, h, s, v);
+
+    // ColorDistance and alpha_map.
+    const auto hue_score    = angle_diff(h, params.target_hue) * two - params.hue_width;
+    const auto sat_score    = min(zero, params.min_saturation - s);
+    const auto bright_score = min(zero, params.min_brightness - v);
+    const auto distance     = zero - hue_score * max(bright_score, sat_score);
+    const auto d            = distance * vec_sse(-2.0f) + one;
+
+    const auto t     = min(max((d - one) / max(params.softness, vec_sse(1.0e-6f)), zero), one);
+    const auto alpha = one - t * t * (three - two * t);
+
+    if (params.show_mask) {
+        const auto mask = alpha * a;
+        vec_sse::store_bgra(pixels, mask, mask, mask, one);
+        return;
+    }
+
+    // supress_spill.
+    const auto diff     = angle_diff_directional(h, params.target_hue);
+    const auto spill    = abs(diff) / params.spill_suppress;
+    const auto suppress = spill < one;
+
+    h = select(suppress,
+               select(diff < zero, params.target_hue - params.spill_suppress, params.target_hue + params.spill_suppress),
+               h);
+    s = select(suppress, s * min(one, spill + params.spill_suppress_saturation), s);
+
+    hsv_to_rgb(h, s, v, r, g, b);
+
+    const auto scale = alpha * a;
+    vec_sse::store_bgra(pixels, b * scale, g * scale, r * scale, scale);
+}
+
+} // namespace
+
+void chroma_key(std::uint8_t* pixels, std::size_t count, const core::chroma& chroma)
+{
+    const chroma_params params(chroma);
+
+    std::size_t x = 0;
+    for (; x + vec_sse::width <= count; x += vec_sse::width) {
+        chroma_key_pixels(pixels + x * 4, params);
+    }
+
+    if (x < count) {
+        std::uint8_t tail[vec_sse::width * 4] = {};
+        std::memcpy(tail, pixels + x * 4, (count - x) * 4);
+        chroma_key_pixels(tail, params);
+        std::memcpy(pixels + x * 4, tail, (count - x) * 4);
+    }
+}
+
+void chroma_key(std::uint8_t* image, int width, int height, const core::chroma& chroma)
+{
+    tbb::parallel_for(tbb::blocked_range<int>(0, height, 16), [&](const tbb::blocked_range<int>& r) {
+        const auto offset = static_cast<std::size_t>(r.begin()) * width;
+        chroma_key(image + offset * 4, static_cast<std::size_t>(r.size()) * width, chroma);
+    });
+}
+
+}}} // namespace caspar::accelerator::cpu
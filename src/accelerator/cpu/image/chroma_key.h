@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <core/frame/frame_transform.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace caspar { namespace accelerator { namespace cpu {
+
+// Chroma keys and spill suppresses count premultiplied BGRA pixels in place. Parameters have the same meaning as
+// in the image shader, with show_mask replacing the image by its key. Unlike the shader, the source alpha is kept.
+void chroma_key(std::uint8_t* pixels, std::size_t count, const core::chroma& chroma);
+
+// Tightly packed width x height image, processed in parallel row bands.
+void chroma_key(std::uint8_t* image, int width, int height, const core::chroma& chroma);
+
+}}} // namespace caspar::accelerator::cpu
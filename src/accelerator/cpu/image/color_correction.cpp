@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "color_correction.h"
+
+#include "../util/simd.h"
+
+#include <common/except.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace caspar { namespace accelerator { namespace cpu {
+
+namespace {
+
+const double epsilon = 0.001;
+
+bool has_levels(const core::levels& levels)
+{
+    return levels.min_input > epsilon || levels.max_input < 1.0 - epsilon || levels.min_output > epsilon ||
+           levels.max_output < 1.0 - epsilon || std::abs(levels.gamma - 1.0) > epsilon;
+}
+
+bool equal(const core::levels& lhs, const core::levels& rhs)
+{
+    return lhs.min_input == rhs.min_input && lhs.max_input == rhs.max_input && lhs.gamma == rhs.gamma &&
+           lhs.min_output == rhs.min_output && lhs.max_output == rhs.max_output;
+}
+
+// LevelsControl followed by the brightness and contrast parts of ContrastSaturationBrightness.
+double correct(double x, const core::levels& levels, bool apply_levels, double brightness, double contrast)
+{
+    if (apply_levels) {
+        x = std::min(std::max(x - levels.min_input, 0.0) / (levels.max_input - levels.min_input), 1.0);
+        x = std::pow(x, 1.0 / levels.gamma);
+        x = levels.min_output + (levels.max_output - levels.min_output) * x;
+    }
+
+    x *= brightness;
+    return 0.5 + (x - 0.5) * contrast;
+}
+
+template <typename T>
+void apply_table(T* pixels, std::size_t count, const std::vector<std::uint16_t>& table, int max)
+{
+    for (std::size_t n = 0; n < count; ++n) {
+        const auto pixel = pixels + n * 4;
+        const auto alpha = static_cast<std::int64_t>(pixel[3]);
+
+        if (alpha == max) {
+            pixel[0] = static_cast<T>(table[pixel[0]]);
+            pixel[1] = static_cast<T>(table[pixel[1]]);
+            pixel[2] = static_cast<T>(table[pixel[2]]);
+        } else if (alpha > 0) {
+            // The table works on straight colors.
+            for (int c = 0; c < 3; ++c) {
+                const auto straight  = std::min<std::int64_t>(max, (pixel[c] * max + alpha / 2) / alpha);
+                const auto corrected = static_cast<std::int64_t>(table[straight]);
+                pixel[c]             = static_cast<T>((corrected * alpha + max / 2) / max);
+            }
+        }
+    }
+}
+
+} // namespace
+
+void color_correction::update(const core::image_transform& transform, bool is_hd, int bit_depth)
+{
+    if (bit_depth < 8 || bit_depth > 16) {
+        CASPAR_THROW_EXCEPTION(invalid_argument() << msg_info("Unsupported bit depth."));
+    }
+
+    const auto apply_levels = has_levels(transform.levels);
+    const auto apply_bc =
+        std::abs(transform.brightness - 1.0) > epsilon || std::abs(transform.contrast - 1.0) > epsilon;
+
+    const auto changed = bit_depth != bit_depth_ || !equal(transform.levels, levels_) ||
+                         transform.brightness != brightness_ || transform.contrast != contrast_;
+
+    if (changed) {
+        levels_     = transform.levels;
+        brightness_ = transform.brightness;
+        contrast_   = transform.contrast;
+        bit_depth_  = bit_depth;
+
+        table_enabled_ = apply_levels || apply_bc;
+
+        if (table_enabled_) {
+            const auto max = (1 << bit_depth) - 1;
+
+            table_.resize(max + 1);
+            for (int n = 0; n <= max; ++n) {
+                const auto x = correct(static_cast<double>(n) / max, levels_, apply_levels, brightness_, contrast_);
+                table_[n]    = static_cast<std::uint16_t>(std::lround(std::min(std::max(x, 0.0), 1.0) * max));
+            }
+        } else {
+            table_.clear();
+        }
+    }
+
+    saturation_         = static_cast<float>(transform.saturation);
+    saturation_enabled_ = std::abs(transform.saturation - 1.0) > epsilon;
+
+    // Same weights as the shader's LumCoeff.
+    luma_[0] = is_hd ? 0.0722f : 0.114f;
+    luma_[1] = is_hd ? 0.7152f : 0.587f;
+    luma_[2] = is_hd ? 0.2126f : 0.299f;
+}
+
+void color_correction::apply(std::uint8_t* pixels, std::size_t count) const
+{
+    if (bit_depth_ != 8) {
+        CASPAR_THROW_EXCEPTION(invalid_operation() << msg_info("Table was built for another bit depth."));
+    }
+
+    if (table_enabled_) {
+        apply_table(pixels, count, table_, 255);
+    }
+
+    if (!saturation_enabled_) {
+        return;
+    }
+
+    // Saturation is linear, so premultiplied colors can be used as is.
+    const vec_sse weight_b(luma_[0]);
+    const vec_sse weight_g(luma_[1]);
+    const vec_sse weight_r(luma_[2]);
+    const vec_sse saturation(saturation_);
+
+    auto saturate = [&](std::uint8_t* p) {
+        vec_sse b, g, r, a;
+        vec_sse::load_bgra(p, b, g, r, a);
+
+        const auto intensity = b * weight_b + g * weight_g + r * weight_r;
+        vec_sse::store_bgra(p,
+                            intensity + (b - intensity) * saturation,
+                            intensity + (g - intensity) * saturation,
+                            intensity + (r - intensity) * saturation,
+                            a);
+    };
+
+    std::size_t x = 0;
+    for (; x + vec_sse::width <= count; x += vec_sse::width) {
+        saturate(pixels + x * 4);
+    }
+
+    if (x < count) {
+        std::uint8_t tail[vec_sse::width * 4] = {};
+        std::memcpy(tail, pixels + x * 4, (count - x) * 4);
+        saturate(tail);
+        std::memcpy(pixels + x * 4, tail, (count - x) * 4);
+    }
+}
+
+void color_correction::apply(std::uint16_t* pixels, std::size_t count) const
+{
+    if (bit_depth_ <= 8) {
+        CASPAR_THROW_EXCEPTION(invalid_operation() << msg_info("Table was built for another bit depth."));
+    }
+
+    const auto max = (1 << bit_depth_) - 1;
+
+    if (table_enabled_) {
+        apply_table(pixels, count, table_, max);
+    }
+
+    if (!saturation_enabled_) {
+        return;
+    }
+
+    for (std::size_t n = 0; n < count; ++n) {
+        const auto pixel     = pixels + n * 4;
+        const auto intensity = pixel[0] * luma_[0] + pixel[1] * luma_[1] + pixel[2] * luma_[2];
+
+        for (int c = 0; c < 3; ++c) {
+            const auto value = std::min(std::max(intensity + (pixel[c] - intensity) * saturation_, 0.0f),
+                                        static_cast<float>(max));
+            pixel[c]         = static_cast<std::uint16_t>(std::lround(value));
+        }
+    }
+}
+
+}}} // namespace caspar::accelerator::cpu
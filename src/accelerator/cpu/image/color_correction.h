@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <core/frame/frame_transform.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace caspar { namespace accelerator { namespace cpu {
+
+// Levels, brightness, saturation and contrast of an image_transform, evaluated as in the image shader. Levels,
+// brightness and contrast are folded into one per-channel lookup table and saturation is applied afterwards,
+// which is equivalent since the luma weights sum to one.
+class color_correction final
+{
+  public:
+    // Rebuilds the table only if the levels, brightness, contrast or bit depth changed since the last call.
+    void update(const core::image_transform& transform, bool is_hd, int bit_depth = 8);
+
+    // False when the transform leaves colors unchanged.
+    bool enabled() const { return table_enabled_ || saturation_enabled_; }
+
+    // Corrects count premultiplied BGRA pixels in place.
+    void apply(std::uint8_t* pixels, std::size_t count) const;
+
+    // As above for 16 bit containers holding bit_depth bit values.
+    void apply(std::uint16_t* pixels, std::size_t count) const;
+
+  private:
+    core::levels               levels_;
+    double                     brightness_ = 1.0;
+    double                     contrast_   = 1.0;
+    int                        bit_depth_  = 0;
+    std::vector<std::uint16_t> table_;
+    bool                       table_enabled_ = false;
+
+    float saturation_         = 1.0f;
+    bool  saturation_enabled_ = false;
+    float luma_[3]            = {0.0f, 0.0f, 0.0f};
+};
+
+}}} // namespace caspar::accelerator::cpu
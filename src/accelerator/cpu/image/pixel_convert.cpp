@@ -0,0 +1,446 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "pixel_convert.h"
+
+#include <common/except.h>
+#include <common/premultiply.h>
+
+#include <tbb/parallel_for.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <tmmintrin.h>
+#endif
+
+#include <cmath>
+#include <cstring>
+
+namespace caspar { namespace accelerator { namespace cpu {
+
+namespace {
+
+// Y'CbCr to R'G'B' matrix in 3.13 fixed point, scaled for the signal range.
+struct ycbcr_coefficients
+{
+    int y_offset;
+    int y;
+    int cr_r;
+    int cb_g;
+    int cr_g;
+    int cb_b;
+};
+
+ycbcr_coefficients get_coefficients(color_space space, bool full_range)
+{
+    double kr = 0.2126;
+    double kb = 0.0722;
+
+    if (space == color_space::bt601) {
+        kr = 0.299;
+        kb = 0.114;
+    } else if (space == color_space::bt2020) {
+        kr = 0.2627;
+        kb = 0.0593;
+    }
+
+    const auto kg      = 1.0 - kr - kb;
+    const auto y_scale = full_range ? 1.0 : 255.0 / 219.0;
+    const auto c_scale = full_range ? 1.0 : 255.0 / 224.0;
+    const auto one     = static_cast<double>(1 << 13);
+
+    ycbcr_coefficients c;
+    c.y_offset = full_range ? 0 : 16;
+    c.y        = static_cast<int>(std::lround(y_scale * one));
+    c.cr_r     = static_cast<int>(std::lround(2.0 * (1.0 - kr) * c_scale * one));
+    c.cb_g     = static_cast<int>(std::lround(-2.0 * kb * (1.0 - kb) / kg * c_scale * one));
+    c.cr_g     = static_cast<int>(std::lround(-2.0 * kr * (1.0 - kr) / kg * c_scale * one));
+    c.cb_b     = static_cast<int>(std::lround(2.0 * (1.0 - kb) * c_scale * one));
+    return c;
+}
+
+struct source_plane
+{
+    const std::uint8_t* data;
+    int                 linesize;
+    int                 x_factor;
+    int                 y_factor;
+};
+
+std::uint8_t clamp_u8(int value) { return static_cast<std::uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value)); }
+
+__m128i pair_epi16(int lo, int hi)
+{
+    return _mm_set1_epi32(static_cast<int>((static_cast<std::uint32_t>(hi) << 16) | static_cast<std::uint16_t>(lo)));
+}
+
+__m128i load_expanded(const std::uint8_t* src, int factor)
+{
+    if (factor == 1) {
+        return _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src));
+    }
+
+    if (factor == 2) {
+        std::int32_t value;
+        std::memcpy(&value, src, sizeof(value));
+        const auto v = _mm_cvtsi32_si128(value);
+        return _mm_unpacklo_epi8(v, v);
+    }
+
+    std::int16_t value;
+    std::memcpy(&value, src, sizeof(value));
+    auto v = _mm_cvtsi32_si128(value);
+    v      = _mm_unpacklo_epi8(v, v);
+    return _mm_unpacklo_epi16(v, v);
+}
+
+void ycbcr_row(std::uint8_t*             dest,
+               const source_plane*       planes,
+               bool                      has_alpha,
+               int                       y,
+               int                       width,
+               const ycbcr_coefficients& c)
+{
+    const auto luma  = planes[0].data + y * planes[0].linesize;
+    const auto cb    = planes[1].data + y / planes[1].y_factor * planes[1].linesize;
+    const auto cr    = planes[2].data + y / planes[2].y_factor * planes[2].linesize;
+    const auto alpha = has_alpha ? planes[3].data + y / planes[3].y_factor * planes[3].linesize : nullptr;
+
+    const auto cx = planes[1].x_factor;
+    const auto ax = has_alpha ? planes[3].x_factor : 1;
+
+    int x = 0;
+
+    if ((cx == 1 || cx == 2 || cx == 4) && planes[2].x_factor == cx && ax == 1) {
+        const auto zero     = _mm_setzero_si128();
+        const auto max      = _mm_set1_epi16(255);
+        const auto y_offset = _mm_set1_epi16(static_cast<short>(c.y_offset));
+        const auto c_offset = _mm_set1_epi16(128);
+        const auto round    = _mm_set1_epi32(1 << 12);
+        const auto coef_r   = pair_epi16(c.y, c.cr_r);
+        const auto coef_g1  = pair_epi16(c.y, c.cb_g);
+        const auto coef_g2  = pair_epi16(c.cr_g, 0);
+        const auto coef_b   = pair_epi16(c.y, c.cb_b);
+
+        auto channel = [&](__m128i lo, __m128i hi) {
+            lo = _mm_srai_epi32(_mm_add_epi32(lo, round), 13);
+            hi = _mm_srai_epi32(_mm_add_epi32(hi, round), 13);
+            return _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(lo, hi), zero), max);
+        };
+
+        for (; x + 8 <= width; x += 8) {
+            const auto y16  = _mm_sub_epi16(_mm_unpacklo_epi8(load_expanded(luma + x, 1), zero), y_offset);
+            const auto cb16 = _mm_sub_epi16(_mm_unpacklo_epi8(load_expanded(cb + x / cx, cx), zero), c_offset);
+            const auto cr16 = _mm_sub_epi16(_mm_unpacklo_epi8(load_expanded(cr + x / cx, cx), zero), c_offset);
+
+            const auto y_cb = std::make_pair(_mm_unpacklo_epi16(y16, cb16), _mm_unpackhi_epi16(y16, cb16));
+            const auto y_cr = std::make_pair(_mm_unpacklo_epi16(y16, cr16), _mm_unpackhi_epi16(y16, cr16));
+            const auto cr_0 = std::make_pair(_mm_unpacklo_epi16(cr16, zero), _mm_unpackhi_epi16(cr16, zero));
+
+            auto r = channel(_mm_madd_epi16(y_cr.first, coef_r), _mm_madd_epi16(y_cr.second, coef_r));
+            auto g = channel(_mm_add_epi32(_mm_madd_epi16(y_cb.first, coef_g1), _mm_madd_epi16(cr_0.first, coef_g2)),
+                             _mm_add_epi32(_mm_madd_epi16(y_cb.second, coef_g1), _mm_madd_epi16(cr_0.second, coef_g2)));
+            auto b = channel(_mm_madd_epi16(y_cb.first, coef_b), _mm_madd_epi16(y_cb.second, coef_b));
+            auto a = max;
+
+            if (alpha) {
+                a = _mm_unpacklo_epi8(load_expanded(alpha + x, 1), zero);
+                r = premultiply_epi16(r, a);
+                g = premultiply_epi16(g, a);
+                b = premultiply_epi16(b, a);
+            }
+
+            const auto bg = _mm_unpacklo_epi8(_mm_packus_epi16(b, zero), _mm_packus_epi16(g, zero));
+            const auto ra = _mm_unpacklo_epi8(_mm_packus_epi16(r, zero), _mm_packus_epi16(a, zero));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + x * 4), _mm_unpacklo_epi16(bg, ra));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + x * 4 + 16), _mm_unpackhi_epi16(bg, ra));
+        }
+    }
+
+    for (; x < width; ++x) {
+        const auto l   = (luma[x] - c.y_offset) * c.y + (1 << 12);
+        const auto u   = cb[x / cx] - 128;
+        const auto v   = cr[x / planes[2].x_factor] - 128;
+        const auto a   = alpha ? alpha[x / ax] : 255;
+        const auto out = dest + x * 4;
+
+        out[0] = static_cast<std::uint8_t>(premultiply(clamp_u8((l + u * c.cb_b) >> 13), a));
+        out[1] = static_cast<std::uint8_t>(premultiply(clamp_u8((l + u * c.cb_g + v * c.cr_g) >> 13), a));
+        out[2] = static_cast<std::uint8_t>(premultiply(clamp_u8((l + v * c.cr_r) >> 13), a));
+        out[3] = static_cast<std::uint8_t>(a);
+    }
+}
+
+// Gray and limited range luma.
+void gray_row(std::uint8_t* dest, const std::uint8_t* src, int width, bool expand_range)
+{
+    const auto scale = static_cast<int>(std::lround(255.0 / 219.0 * (1 << 13)));
+
+    int x = 0;
+
+    const auto zero   = _mm_setzero_si128();
+    const auto alpha  = _mm_set1_epi32(0xFF000000);
+    const auto offset = _mm_set1_epi16(16);
+    const auto coef   = pair_epi16(scale, 1 << 12);
+    const auto one    = _mm_set1_epi16(1);
+
+    for (; x + 16 <= width; x += 16) {
+        auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+
+        if (expand_range) {
+            const auto lo = _mm_sub_epi16(_mm_unpacklo_epi8(v, zero), offset);
+            const auto hi = _mm_sub_epi16(_mm_unpackhi_epi8(v, zero), offset);
+
+            const auto lo32 = std::make_pair(_mm_srai_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(lo, one), coef), 13),
+                                             _mm_srai_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(lo, one), coef), 13));
+            const auto hi32 = std::make_pair(_mm_srai_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(hi, one), coef), 13),
+                                             _mm_srai_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(hi, one), coef), 13));
+
+            v = _mm_packus_epi16(_mm_packs_epi32(lo32.first, lo32.second), _mm_packs_epi32(hi32.first, hi32.second));
+        }
+
+        for (int n = 0; n < 4; ++n) {
+            const auto i    = static_cast<char>(n * 4);
+            const auto mask = _mm_setr_epi8(
+                i, i, i, -1, i + 1, i + 1, i + 1, -1, i + 2, i + 2, i + 2, -1, i + 3, i + 3, i + 3, -1);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + (x + n * 4) * 4),
+                             _mm_or_si128(_mm_shuffle_epi8(v, mask), alpha));
+        }
+    }
+
+    for (; x < width; ++x) {
+        const auto v = expand_range ? clamp_u8(((src[x] - 16) * scale + (1 << 12)) >> 13) : src[x];
+
+        dest[x * 4 + 0] = v;
+        dest[x * 4 + 1] = v;
+        dest[x * 4 + 2] = v;
+        dest[x * 4 + 3] = 255;
+    }
+}
+
+// Byte positions of b, g, r and a in the source pixel, a < 0 means opaque.
+void packed_row(std::uint8_t* dest, const std::uint8_t* src, int width, int stride, int b, int g, int r, int a)
+{
+    int x = 0;
+
+    if (stride == 4) {
+        const auto mask = _mm_setr_epi8(static_cast<char>(b),
+                                        static_cast<char>(g),
+                                        static_cast<char>(r),
+                                        static_cast<char>(a),
+                                        static_cast<char>(b + 4),
+                                        static_cast<char>(g + 4),
+                                        static_cast<char>(r + 4),
+                                        static_cast<char>(a + 4),
+                                        static_cast<char>(b + 8),
+                                        static_cast<char>(g + 8),
+                                        static_cast<char>(r + 8),
+                                        static_cast<char>(a + 8),
+                                        static_cast<char>(b + 12),
+                                        static_cast<char>(g + 12),
+                                        static_cast<char>(r + 12),
+                                        static_cast<char>(a + 12));
+
+        for (; x + 4 <= width; x += 4) {
+            const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 4));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + x * 4), _mm_shuffle_epi8(v, mask));
+        }
+    } else if (stride == 3) {
+        const auto alpha = _mm_set1_epi32(0xFF000000);
+        const auto mask  = _mm_setr_epi8(static_cast<char>(b),
+                                        static_cast<char>(g),
+                                        static_cast<char>(r),
+                                        -1,
+                                        static_cast<char>(b + 3),
+                                        static_cast<char>(g + 3),
+                                        static_cast<char>(r + 3),
+                                        -1,
+                                        static_cast<char>(b + 6),
+                                        static_cast<char>(g + 6),
+                                        static_cast<char>(r + 6),
+                                        -1,
+                                        static_cast<char>(b + 9),
+                                        static_cast<char>(g + 9),
+                                        static_cast<char>(r + 9),
+                                        -1);
+
+        // Each load reads 16 bytes of which 12 are used.
+        for (; x + 6 <= width; x += 4) {
+            const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 3));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + x * 4), _mm_or_si128(_mm_shuffle_epi8(v, mask), alpha));
+        }
+    }
+
+    for (; x < width; ++x) {
+        const auto in  = src + x * stride;
+        const auto out = dest + x * 4;
+
+        out[0] = in[b];
+        out[1] = in[g];
+        out[2] = in[r];
+        out[3] = a < 0 ? 255 : in[a];
+    }
+}
+
+// Rounded v * 255 / 65535.
+std::uint8_t narrow_sample(std::uint16_t v) { return static_cast<std::uint8_t>((v * 255u + 32767u) / 65535u); }
+
+} // namespace
+
+color_space default_color_space(const core::pixel_format_desc& desc)
+{
+    return !desc.planes.empty() && desc.planes.at(0).height > 700 ? color_space::bt709 : color_space::bt601;
+}
+
+void to_bgra(std::uint8_t*                           dest,
+             const core::pixel_format_desc&          desc,
+             const std::vector<const std::uint8_t*>& planes,
+             color_space                             space,
+             bool                                    full_range)
+{
+    if (desc.planes.empty() || planes.size() < desc.planes.size()) {
+        CASPAR_THROW_EXCEPTION(invalid_argument() << msg_info("Missing image planes."));
+    }
+
+    if (desc.depth == core::color_depth::sixteen) {
+        // Rounds every sample to 8 bit and converts those, the output is 8 bit BGRA either way.
+        auto narrow_desc  = desc;
+        narrow_desc.depth = core::color_depth::eight;
+
+        std::vector<std::vector<std::uint8_t>> narrow(desc.planes.size());
+        std::vector<const std::uint8_t*>       narrow_planes;
+        for (std::size_t n = 0; n < desc.planes.size(); ++n) {
+            const auto& plane = desc.planes.at(n);
+            if (plane.stride % 2 != 0) {
+                CASPAR_THROW_EXCEPTION(invalid_argument() << msg_info("Invalid stride for 16 bit plane."));
+            }
+
+            narrow_desc.planes.at(n) = core::pixel_format_desc::plane(plane.width, plane.height, plane.stride / 2);
+
+            const auto samples = plane.width * plane.stride / 2;
+            narrow.at(n).resize(static_cast<std::size_t>(samples) * plane.height);
+
+            const auto src = planes.at(n);
+            const auto dst = narrow.at(n).data();
+            tbb::parallel_for(tbb::blocked_range<int>(0, plane.height), [&](const tbb::blocked_range<int>& r) {
+                for (auto y = r.begin(); y != r.end(); ++y) {
+                    const auto row = reinterpret_cast<const std::uint16_t*>(src + y * plane.linesize);
+                    for (int x = 0; x < samples; ++x) {
+                        dst[y * samples + x] = narrow_sample(row[x]);
+                    }
+                }
+            });
+            narrow_planes.push_back(dst);
+        }
+
+        to_bgra(dest, narrow_desc, narrow_planes, space, full_range);
+        return;
+    }
+
+    const auto width  = desc.planes.at(0).width;
+    const auto height = desc.planes.at(0).height;
+
+    std::vector<source_plane> sources;
+    for (std::size_t n = 0; n < desc.planes.size(); ++n) {
+        const auto& plane = desc.planes.at(n);
+        if (plane.width < 1 || plane.height < 1) {
+            CASPAR_THROW_EXCEPTION(invalid_argument() << msg_info("Invalid plane dimensions."));
+        }
+
+        source_plane source;
+        source.data     = planes.at(n);
+        source.linesize = plane.linesize;
+        source.x_factor = (width + plane.width - 1) / plane.width;
+        source.y_factor = (height + plane.height - 1) / plane.height;
+        sources.push_back(source);
+    }
+
+    const auto format = desc.format;
+    const auto c      = get_coefficients(space, full_range);
+
+    if ((format == core::pixel_format::ycbcr && sources.size() < 3) ||
+        (format == core::pixel_format::ycbcra && sources.size() < 4)) {
+        CASPAR_THROW_EXCEPTION(invalid_argument() << msg_info("Missing image planes."));
+    }
+
+    tbb::parallel_for(tbb::blocked_range<int>(0, height), [&](const tbb::blocked_range<int>& r) {
+        for (auto y = r.begin(); y != r.end(); ++y) {
+            const auto out = dest + static_cast<std::size_t>(y) * width * 4;
+            const auto src = sources[0].data + y * sources[0].linesize;
+
+            switch (format) {
+                case core::pixel_format::gray:
+                    gray_row(out, src, width, false);
+                    break;
+                case core::pixel_format::luma:
+                    gray_row(out, src, width, true);
+                    break;
+                case core::pixel_format::bgra:
+                    std::memcpy(out, src, width * 4);
+                    break;
+                case core::pixel_format::rgba:
+                    packed_row(out, src, width, 4, 2, 1, 0, 3);
+                    break;
+                case core::pixel_format::argb:
+                    packed_row(out, src, width, 4, 3, 2, 1, 0);
+                    break;
+                case core::pixel_format::abgr:
+                    packed_row(out, src, width, 4, 1, 2, 3, 0);
+                    break;
+                case core::pixel_format::bgr:
+                    packed_row(out, src, width, 3, 0, 1, 2, -1);
+                    break;
+                case core::pixel_format::rgb:
+                    packed_row(out, src, width, 3, 2, 1, 0, -1);
+                    break;
+                case core::pixel_format::ycbcr:
+                    ycbcr_row(out, sources.data(), false, y, width, c);
+                    break;
+                case core::pixel_format::ycbcra:
+                    ycbcr_row(out, sources.data(), true, y, width, c);
+                    break;
+                default:
+                    std::memset(out, 0, width * 4);
+                    break;
+            }
+        }
+    });
+}
+
+array<const std::uint8_t> to_bgra(const core::const_frame& frame, color_space space, bool full_range)
+{
+    const auto& desc = frame.pixel_format_desc();
+
+    std::vector<const std::uint8_t*> planes;
+    for (int n = 0; n < static_cast<int>(desc.planes.size()); ++n) {
+        planes.push_back(frame.image_data(n).data());
+    }
+
+    array<std::uint8_t> dest(static_cast<std::size_t>(desc.planes.at(0).width) * desc.planes.at(0).height * 4);
+    to_bgra(dest.data(), desc, planes, space, full_range);
+    return array<const std::uint8_t>(std::move(dest));
+}
+
+array<const std::uint8_t> to_bgra(const core::const_frame& frame)
+{
+    return to_bgra(frame, default_color_space(frame.pixel_format_desc()));
+}
+
+}}} // namespace caspar::accelerator::cpu
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <common/array.h>
+
+#include <core/frame/frame.h>
+#include <core/frame/pixel_format.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace caspar { namespace accelerator { namespace cpu {
+
+enum class color_space
+{
+    bt601,
+    bt709,
+    bt2020,
+};
+
+// Same choice as the is_hd switch in the image shader.
+color_space default_color_space(const core::pixel_format_desc& desc);
+
+// Converts an image in any core::pixel_format to premultiplied BGRA. Chroma and alpha planes may be subsampled by
+// any integer factor, 4:2:2, 4:2:0, 4:1:1 and 4:1:0 have SSSE3 paths. dest must hold width * height * 4 bytes of
+// the first plane and is written with no padding between rows. Sixteen bit images are rounded to 8 bit first.
+void to_bgra(std::uint8_t*                           dest,
+             const core::pixel_format_desc&          desc,
+             const std::vector<const std::uint8_t*>& planes,
+             color_space                             space,
+             bool                                    full_range = false);
+
+array<const std::uint8_t> to_bgra(const core::const_frame& frame, color_space space, bool full_range = false);
+array<const std::uint8_t> to_bgra(const core::const_frame& frame);
+
+}}} // namespace caspar::accelerator::cpu
@@ -0,0 +1,450 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "resample.h"
+
+#include "../util/simd.h"
+
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace caspar { namespace accelerator { namespace cpu {
+
+namespace {
+
+typedef std::array<std::array<double, 3>, 3> matrix3;
+
+// Maps the unit square onto the quad (x[n], y[n]), corners in ul, ur, lr, ll order. Heckbert, "Fundamentals of
+// Texture Mapping and Image Warping".
+matrix3 square_to_quad(const double x[4], const double y[4])
+{
+    const auto dx1 = x[1] - x[2];
+    const auto dx2 = x[3] - x[2];
+    const auto dx3 = x[0] - x[1] + x[2] - x[3];
+    const auto dy1 = y[1] - y[2];
+    const auto dy2 = y[3] - y[2];
+    const auto dy3 = y[0] - y[1] + y[2] - y[3];
+
+    double g = 0.0;
+    double h = 0.0;
+
+    if (std::abs(dx3) > 1e-12 || std::abs(dy3) > 1e-12) {
+        const auto det = dx1 * dy2 - dx2 * dy1;
+        if (std::abs(det) > 1e-12) {
+            g = (dx3 * dy2 - dx2 * dy3) / det;
+            h = (dx1 * dy3 - dx3 * dy1) / det;
+        }
+    }
+
+    return {{{x[1] - x[0] + g * x[1], x[3] - x[0] + h * x[3], x[0]},
+             {y[1] - y[0] + g * y[1], y[3] - y[0] + h * y[3], y[0]},
+             {g, h, 1.0}}};
+}
+
+bool invert(const matrix3& m, matrix3& result)
+{
+    const auto c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+    const auto c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+    const auto c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+    const auto det = m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02;
+
+    if (std::abs(det) < 1e-12) {
+        return false;
+    }
+
+    result[0] = {{c00, m[0][2] * m[2][1] - m[0][1] * m[2][2], m[0][1] * m[1][2] - m[0][2] * m[1][1]}};
+    result[1] = {{c01, m[0][0] * m[2][2] - m[0][2] * m[2][0], m[0][2] * m[1][0] - m[0][0] * m[1][2]}};
+    result[2] = {{c02, m[0][1] * m[2][0] - m[0][0] * m[2][1], m[0][0] * m[1][1] - m[0][1] * m[1][0]}};
+
+    for (auto& row : result) {
+        for (auto& value : row) {
+            value /= det;
+        }
+    }
+    return true;
+}
+
+matrix3 multiply(const matrix3& a, const matrix3& b)
+{
+    matrix3 result;
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            result[r][c] = a[r][0] * b[0][c] + a[r][1] * b[1][c] + a[r][2] * b[2][c];
+        }
+    }
+    return result;
+}
+
+// Vertex transform of image_kernel::draw.
+std::vector<core::frame_geometry::coord>
+transform_coords(const core::image_transform& transform, const core::frame_geometry& geometry, double aspect)
+{
+    auto coords = geometry.data();
+
+    const auto is_default_geometry = coords == core::frame_geometry::get_default().data();
+    const auto f_p                 = transform.fill_translation;
+    const auto f_s                 = transform.fill_scale;
+    const auto angle               = transform.angle;
+    const auto anchor              = transform.anchor;
+    const auto crop                = transform.crop;
+
+    auto pers = transform.perspective;
+    pers.ur[0] -= 1.0;
+    pers.lr[0] -= 1.0;
+    pers.lr[1] -= 1.0;
+    pers.ll[1] -= 1.0;
+    const std::array<std::array<double, 2>, 4> pers_corners = {{pers.ul, pers.ur, pers.lr, pers.ll}};
+
+    int corner = 0;
+    for (auto& coord : coords) {
+        if (is_default_geometry) {
+            coord.vertex_x  = std::min(std::max(coord.vertex_x, crop.ul[0]), crop.lr[0]);
+            coord.vertex_y  = std::min(std::max(coord.vertex_y, crop.ul[1]), crop.lr[1]);
+            coord.texture_x = std::min(std::max(coord.texture_x, crop.ul[0]), crop.lr[0]);
+            coord.texture_y = std::min(std::max(coord.texture_y, crop.ul[1]), crop.lr[1]);
+
+            coord.vertex_x += pers_corners[corner][0];
+            coord.vertex_y += pers_corners[corner][1];
+        }
+
+        const auto orig_x = (coord.vertex_x - anchor[0]) * f_s[0];
+        const auto orig_y = (coord.vertex_y - anchor[1]) * f_s[1] / aspect;
+        coord.vertex_x    = orig_x * std::cos(angle) - orig_y * std::sin(angle) + f_p[0];
+        coord.vertex_y    = (orig_x * std::sin(angle) + orig_y * std::cos(angle)) * aspect + f_p[1];
+
+        if (++corner == 4) {
+            corner = 0;
+        }
+    }
+
+    return coords;
+}
+
+// Same early-out as image_kernel::draw.
+bool is_outside_screen(const std::vector<core::frame_geometry::coord>& coords)
+{
+    typedef const core::frame_geometry::coord& coord;
+
+    return std::all_of(coords.begin(), coords.end(), [](coord c) { return c.vertex_x < 0.0; }) ||
+           std::all_of(coords.begin(), coords.end(), [](coord c) { return c.vertex_x > 1.0; }) ||
+           std::all_of(coords.begin(), coords.end(), [](coord c) { return c.vertex_y < 0.0; }) ||
+           std::all_of(coords.begin(), coords.end(), [](coord c) { return c.vertex_y > 1.0; });
+}
+
+struct source_image
+{
+    const std::uint8_t* data;
+    int                 width;
+    int                 height;
+
+    std::uint32_t pixel(int x, int y) const
+    {
+        x = std::min(std::max(x, 0), width - 1);
+        y = std::min(std::max(y, 0), height - 1);
+
+        std::uint32_t value;
+        std::memcpy(&value, data + (static_cast<std::size_t>(y) * width + x) * 4, sizeof(value));
+        return value;
+    }
+};
+
+// u and v are in source pixels with texel centers at whole numbers. Weights are 8 bit fixed point.
+void sample_bilinear(const source_image& src, double u, double v, std::uint8_t* out)
+{
+    // Offset by one pixel so that truncation floors everything down to the clamped border.
+    const auto fu = static_cast<int>((u + 1.0) * 256.0);
+    const auto fv = static_cast<int>((v + 1.0) * 256.0);
+    const auto x  = (fu >> 8) - 1;
+    const auto y  = (fv >> 8) - 1;
+    const auto wx = static_cast<short>(fu & 255);
+    const auto wy = static_cast<short>(fv & 255);
+
+    __m128i rows;
+    if (x >= 0 && y >= 0 && x < src.width - 1 && y < src.height - 1) {
+        const auto row = src.data + (static_cast<std::size_t>(y) * src.width + x) * 4;
+        rows           = _mm_unpacklo_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row)),
+                                  _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + src.width * 4)));
+    } else {
+        rows = _mm_setr_epi32(static_cast<int>(src.pixel(x, y)),
+                              static_cast<int>(src.pixel(x + 1, y)),
+                              static_cast<int>(src.pixel(x, y + 1)),
+                              static_cast<int>(src.pixel(x + 1, y + 1)));
+    }
+
+    const auto zero  = _mm_setzero_si128();
+    const auto round = _mm_set1_epi16(128);
+
+    // Vertical, then horizontal, each rounded back to 8 bits.
+    const auto top    = _mm_mullo_epi16(_mm_unpacklo_epi8(rows, zero), _mm_set1_epi16(static_cast<short>(256 - wy)));
+    const auto bottom = _mm_mullo_epi16(_mm_unpackhi_epi8(rows, zero), _mm_set1_epi16(wy));
+    const auto column = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(top, bottom), round), 8);
+
+    const auto weights = _mm_unpacklo_epi64(_mm_set1_epi16(static_cast<short>(256 - wx)), _mm_set1_epi16(wx));
+    const auto m       = _mm_mullo_epi16(column, weights);
+    const auto result  = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(m, _mm_srli_si128(m, 8)), round), 8);
+
+    const auto value = _mm_cvtsi128_si32(_mm_packus_epi16(result, zero));
+    std::memcpy(out, &value, sizeof(value));
+}
+
+// Cubic B-spline weights, as cubic() in the image shader.
+void cubic_weights(double t, float weights[4])
+{
+    const auto n0 = 1.0 - t;
+    const auto n1 = 2.0 - t;
+    const auto n2 = 3.0 - t;
+    const auto s0 = n0 * n0 * n0;
+    const auto s1 = n1 * n1 * n1;
+    const auto s2 = n2 * n2 * n2;
+    const auto x  = s0;
+    const auto y  = s1 - 4.0 * s0;
+    const auto z  = s2 - 4.0 * s1 + 6.0 * s0;
+    const auto w  = 6.0 - x - y - z;
+
+    weights[0] = static_cast<float>(x / 6.0);
+    weights[1] = static_cast<float>(y / 6.0);
+    weights[2] = static_cast<float>(z / 6.0);
+    weights[3] = static_cast<float>(w / 6.0);
+}
+
+void sample_bicubic(const source_image& src, double u, double v, std::uint8_t* out)
+{
+    const auto fu = std::floor(u);
+    const auto fv = std::floor(v);
+    const auto x  = static_cast<int>(fu);
+    const auto y  = static_cast<int>(fv);
+
+    float wx[4];
+    float wy[4];
+    cubic_weights(u - fu, wx);
+    cubic_weights(v - fv, wy);
+
+    auto sum = _mm_setzero_ps();
+    for (int j = 0; j < 4; ++j) {
+        auto row = _mm_setzero_ps();
+        for (int i = 0; i < 4; ++i) {
+            const auto pixel = _mm_cvtsi32_si128(static_cast<int>(src.pixel(x - 1 + i, y - 1 + j)));
+            const auto value = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(pixel));
+            row              = _mm_add_ps(row, _mm_mul_ps(value, _mm_set1_ps(wx[i])));
+        }
+        sum = _mm_add_ps(sum, _mm_mul_ps(row, _mm_set1_ps(wy[j])));
+    }
+
+    const auto clamped = _mm_min_ps(_mm_max_ps(sum, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+    const auto ints    = _mm_cvtps_epi32(clamped);
+    const auto value   = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(ints, ints), ints));
+    std::memcpy(out, &value, sizeof(value));
+}
+
+bool is_integer(double value) { return std::abs(value - std::round(value)) < 1e-6; }
+
+// Samples every pixel of area whose center maps inside the unit square. Affine mappings are expected to be normalised
+// so that their homogeneous coordinate is 1 and need no divisions.
+template <void (*Sample)(const source_image&, double, double, std::uint8_t*), bool Affine>
+void rasterise(std::uint8_t*       dest,
+               int                 dest_width,
+               const region&       area,
+               const matrix3&      to_unit,
+               const matrix3&      to_source,
+               const source_image& src)
+{
+    tbb::parallel_for(tbb::blocked_range<int>(area.y, area.y + area.height, 8), [&](const tbb::blocked_range<int>& r) {
+        for (auto y = r.begin(); y != r.end(); ++y) {
+            const auto px = area.x + 0.5;
+            const auto py = y + 0.5;
+
+            // Homogeneous unit square and source coordinates, stepped along the row.
+            auto s = to_unit[0][0] * px + to_unit[0][1] * py + to_unit[0][2];
+            auto t = to_unit[1][0] * px + to_unit[1][1] * py + to_unit[1][2];
+            auto q = to_unit[2][0] * px + to_unit[2][1] * py + to_unit[2][2];
+            auto u = to_source[0][0] * px + to_source[0][1] * py + to_source[0][2] - 0.5;
+            auto v = to_source[1][0] * px + to_source[1][1] * py + to_source[1][2] - 0.5;
+            auto w = to_source[2][0] * px + to_source[2][1] * py + to_source[2][2];
+
+            auto out = dest + (static_cast<std::size_t>(y) * dest_width + area.x) * 4;
+
+            for (auto x = 0; x < area.width; ++x, out += 4) {
+                if (Affine) {
+                    if (s >= 0.0 && s <= 1.0 && t >= 0.0 && t <= 1.0) {
+                        Sample(src, u, v, out);
+                    }
+                } else {
+                    const auto inv_q = 1.0 / q;
+                    const auto us    = s * inv_q;
+                    const auto ut    = t * inv_q;
+
+                    if (us >= 0.0 && us <= 1.0 && ut >= 0.0 && ut <= 1.0) {
+                        // The texel center offset is applied after the division.
+                        const auto inv_w = 1.0 / w;
+                        Sample(src, (u + 0.5) * inv_w - 0.5, (v + 0.5) * inv_w - 0.5, out);
+                    }
+
+                    q += to_unit[2][0];
+                    w += to_source[2][0];
+                }
+
+                s += to_unit[0][0];
+                t += to_unit[1][0];
+                u += to_source[0][0];
+                v += to_source[1][0];
+            }
+        }
+    });
+}
+
+template <void (*Sample)(const source_image&, double, double, std::uint8_t*)>
+void rasterise(std::uint8_t*       dest,
+               int                 dest_width,
+               const region&       area,
+               matrix3             to_unit,
+               matrix3             to_source,
+               const source_image& src)
+{
+    const auto affine =
+        to_unit[2][0] == 0.0 && to_unit[2][1] == 0.0 && to_source[2][0] == 0.0 && to_source[2][1] == 0.0;
+
+    if (!affine) {
+        rasterise<Sample, false>(dest, dest_width, area, to_unit, to_source, src);
+        return;
+    }
+
+    for (auto m : {&to_unit, &to_source}) {
+        const auto scale = 1.0 / (*m)[2][2];
+        for (auto& row : *m) {
+            for (auto& value : row) {
+                value *= scale;
+            }
+        }
+    }
+
+    rasterise<Sample, true>(dest, dest_width, area, to_unit, to_source, src);
+}
+
+} // namespace
+
+region resample(std::uint8_t*                dest,
+                int                          dest_width,
+                int                          dest_height,
+                const std::uint8_t*          source,
+                int                          source_width,
+                int                          source_height,
+                const core::image_transform& transform,
+                const core::frame_geometry&  geometry,
+                double                       aspect_ratio,
+                resample_filter              filter)
+{
+    const auto coords = transform_coords(transform, geometry, aspect_ratio);
+
+    if (coords.size() != 4 || is_outside_screen(coords) || source_width < 1 || source_height < 1) {
+        return region();
+    }
+
+    // Scissor, as set up by image_kernel::draw.
+    auto clip_x0 = 0;
+    auto clip_y0 = 0;
+    auto clip_x1 = dest_width;
+    auto clip_y1 = dest_height;
+
+    const auto& m_p = transform.clip_translation;
+    const auto& m_s = transform.clip_scale;
+
+    bool scissor = m_p[0] > std::numeric_limits<double>::epsilon() || m_p[1] > std::numeric_limits<double>::epsilon() ||
+                   m_s[0] < (1.0 - std::numeric_limits<double>::epsilon()) ||
+                   m_s[1] < (1.0 - std::numeric_limits<double>::epsilon());
+
+    if (scissor) {
+        const auto x = static_cast<int>(m_p[0] * dest_width);
+        const auto y = static_cast<int>(m_p[1] * dest_height);
+
+        clip_x0 = std::max(clip_x0, x);
+        clip_y0 = std::max(clip_y0, y);
+        clip_x1 = std::min(clip_x1, x + std::max(0, static_cast<int>(m_s[0] * dest_width)));
+        clip_y1 = std::min(clip_y1, y + std::max(0, static_cast<int>(m_s[1] * dest_height)));
+    }
+
+    double vx[4], vy[4], tx[4], ty[4];
+    for (int n = 0; n < 4; ++n) {
+        vx[n] = coords[n].vertex_x * dest_width;
+        vy[n] = coords[n].vertex_y * dest_height;
+        tx[n] = coords[n].texture_x * source_width;
+        ty[n] = coords[n].texture_y * source_height;
+    }
+
+    // Pixels are drawn when their center is inside the quad.
+    region result;
+    result.x      = std::max(clip_x0, static_cast<int>(std::ceil(*std::min_element(vx, vx + 4) - 0.5)));
+    result.y      = std::max(clip_y0, static_cast<int>(std::ceil(*std::min_element(vy, vy + 4) - 0.5)));
+    result.width  = std::min(clip_x1, static_cast<int>(std::ceil(*std::max_element(vx, vx + 4) - 0.5))) - result.x;
+    result.height = std::min(clip_y1, static_cast<int>(std::ceil(*std::max_element(vy, vy + 4) - 0.5))) - result.y;
+
+    matrix3 to_unit;
+    if (result.empty() || !invert(square_to_quad(vx, vy), to_unit)) {
+        return region();
+    }
+
+    const auto to_texture = square_to_quad(tx, ty);
+    const auto to_source  = multiply(to_texture, to_unit);
+
+    const source_image src = {source, source_width, source_height};
+
+    // Whole pixel translation of an upright, unscaled quad.
+    const auto w = to_source[2][2];
+    if (std::abs(to_source[2][0]) < 1e-9 && std::abs(to_source[2][1]) < 1e-9 &&
+        std::abs(to_source[0][0] / w - 1.0) < 1e-9 && std::abs(to_source[0][1] / w) < 1e-9 &&
+        std::abs(to_source[1][0] / w) < 1e-9 && std::abs(to_source[1][1] / w - 1.0) < 1e-9 &&
+        is_integer(to_source[0][2] / w) && is_integer(to_source[1][2] / w)) {
+        const auto dx = static_cast<int>(std::round(to_source[0][2] / w));
+        const auto dy = static_cast<int>(std::round(to_source[1][2] / w));
+
+        result.x      = std::max(result.x, -dx);
+        result.y      = std::max(result.y, -dy);
+        result.width  = std::min(result.x + result.width, source_width - dx) - result.x;
+        result.height = std::min(result.y + result.height, source_height - dy) - result.y;
+
+        if (result.empty()) {
+            return region();
+        }
+
+        const auto rows = tbb::blocked_range<int>(result.y, result.y + result.height);
+        tbb::parallel_for(rows, [&](const tbb::blocked_range<int>& r) {
+            for (auto y = r.begin(); y != r.end(); ++y) {
+                std::memcpy(dest + (static_cast<std::size_t>(y) * dest_width + result.x) * 4,
+                            source + (static_cast<std::size_t>(y + dy) * source_width + result.x + dx) * 4,
+                            static_cast<std::size_t>(result.width) * 4);
+            }
+        });
+
+        return result;
+    }
+
+    if (filter == resample_filter::bicubic) {
+        rasterise<sample_bicubic>(dest, dest_width, result, to_unit, to_source, src);
+    } else {
+        rasterise<sample_bilinear>(dest, dest_width, result, to_unit, to_source, src);
+    }
+
+    return result;
+}
+
+}}} // namespace caspar::accelerator::cpu
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <core/frame/frame_transform.h>
+#include <core/frame/geometry.h>
+
+#include <cstdint>
+
+namespace caspar { namespace accelerator { namespace cpu {
+
+enum class resample_filter
+{
+    bilinear = 0,
+    bicubic, // Same B-spline as the image shader.
+};
+
+struct region final
+{
+    int x      = 0;
+    int y      = 0;
+    int width  = 0;
+    int height = 0;
+
+    bool empty() const { return width <= 0 || height <= 0; }
+};
+
+// Draws a premultiplied BGRA source into dest, placed by the fill, anchor, angle, crop, perspective and clip of
+// transform and by geometry, the way image_kernel::draw places its quad. Pixels outside the quad are left
+// untouched. Returns the region that may have been written, which is empty when the item is entirely off screen.
+// Pure translations by whole pixels are copied without resampling.
+region resample(std::uint8_t*                dest,
+                int                          dest_width,
+                int                          dest_height,
+                const std::uint8_t*          source,
+                int                          source_width,
+                int                          source_height,
+                const core::image_transform& transform,
+                const core::frame_geometry&  geometry,
+                double                       aspect_ratio,
+                resample_filter              filter = resample_filter::bilinear);
+
+}}} // namespace caspar::accelerator::cpu
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <smmintrin.h>
+#endif
+
+#include <cstdint>
+#include <cstring>
+
+namespace caspar { namespace accelerator { namespace cpu {
+
+// Four pixels per vector, one channel per register. Requires SSE4.1.
+struct vec_sse
+{
+    static const int width = 4;
+
+    __m128 v;
+
+    vec_sse() = default;
+    vec_sse(__m128 v)
+        : v(v)
+    {
+    }
+    explicit vec_sse(float x)
+        : v(_mm_set1_ps(x))
+    {
+    }
+
+    static void load_bgra(const std::uint8_t* src, vec_sse& b, vec_sse& g, vec_sse& r, vec_sse& a)
+    {
+        const auto scale = _mm_set1_ps(1.0f / 255.0f);
+        const auto mask  = _mm_set1_epi32(0xFF);
+        const auto v     = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+
+        b = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(v, mask)), scale);
+        g = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 8), mask)), scale);
+        r = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 16), mask)), scale);
+        a = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(v, 24)), scale);
+    }
+
+    static void store_bgra(std::uint8_t* dest, vec_sse b, vec_sse g, vec_sse r, vec_sse a)
+    {
+        const auto v = _mm_or_si128(_mm_or_si128(to_int(b), _mm_slli_epi32(to_int(g), 8)),
+                                    _mm_or_si128(_mm_slli_epi32(to_int(r), 16), _mm_slli_epi32(to_int(a), 24)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), v);
+    }
+
+    static vec_sse load_key(const std::uint8_t* src)
+    {
+        std::int32_t value;
+        std::memcpy(&value, src, sizeof(value));
+        return _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(value))), _mm_set1_ps(1.0f / 255.0f));
+    }
+
+    static void store_key(std::uint8_t* dest, vec_sse k)
+    {
+        const auto v     = to_int(k);
+        const auto value = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(v, v), v));
+        std::memcpy(dest, &value, sizeof(value));
+    }
+
+    // Clamps to [0, 1] and rounds to 8 bit.
+    static __m128i to_int(vec_sse x)
+    {
+        const auto clamped = _mm_min_ps(_mm_max_ps(x.v, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+        return _mm_cvtps_epi32(_mm_mul_ps(clamped, _mm_set1_ps(255.0f)));
+    }
+};
+
+inline vec_sse operator+(vec_sse a, vec_sse b) { return _mm_add_ps(a.v, b.v); }
+inline vec_sse operator-(vec_sse a, vec_sse b) { return _mm_sub_ps(a.v, b.v); }
+inline vec_sse operator*(vec_sse a, vec_sse b) { return _mm_mul_ps(a.v, b.v); }
+inline vec_sse operator/(vec_sse a, vec_sse b) { return _mm_div_ps(a.v, b.v); }
+inline vec_sse operator<(vec_sse a, vec_sse b) { return _mm_cmplt_ps(a.v, b.v); }
+inline vec_sse operator>(vec_sse a, vec_sse b) { return _mm_cmpgt_ps(a.v, b.v); }
+inline vec_sse operator>=(vec_sse a, vec_sse b) { return _mm_cmpge_ps(a.v, b.v); }
+inline vec_sse operator==(vec_sse a, vec_sse b) { return _mm_cmpeq_ps(a.v, b.v); }
+inline vec_sse min(vec_sse a, vec_sse b) { return _mm_min_ps(a.v, b.v); }
+inline vec_sse max(vec_sse a, vec_sse b) { return _mm_max_ps(a.v, b.v); }
+inline vec_sse abs(vec_sse a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v); }
+inline vec_sse floor(vec_sse a) { return _mm_floor_ps(a.v); }
+inline vec_sse select(vec_sse mask, vec_sse a, vec_sse b) { return _mm_blendv_ps(b.v, a.v, mask.v); }
+
+}}} // namespace caspar::accelerator::cpu
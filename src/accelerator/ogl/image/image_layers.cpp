@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "image_layers.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace caspar { namespace accelerator { namespace ogl {
+
+bool operator==(const item& lhs, const item& rhs)
+{
+    return lhs.frame == rhs.frame && lhs.transform == rhs.transform && lhs.geometry.type() == rhs.geometry.type() &&
+           lhs.geometry.data() == rhs.geometry.data();
+}
+
+bool operator==(const layer& lhs, const layer& rhs)
+{
+    return lhs.blend_mode == rhs.blend_mode && lhs.items == rhs.items && lhs.sublayers == rhs.sublayers;
+}
+
+bool has_key(const layer& layer)
+{
+    return std::any_of(
+        layer.items.begin(), layer.items.end(), [](const item& item) { return item.transform.is_key; });
+}
+
+bool is_cacheable(const layer& layer)
+{
+    return layer.blend_mode == core::blend_mode::normal && !has_key(layer) &&
+           std::all_of(layer.sublayers.begin(), layer.sublayers.end(), is_cacheable);
+}
+
+int count_items(const layer& layer)
+{
+    auto count = static_cast<int>(layer.items.size());
+    for (auto& sublayer : layer.sublayers) {
+        count += count_items(sublayer);
+    }
+    return count;
+}
+
+std::vector<bool> static_layers(const std::vector<layer>& layers, const std::vector<layer>& previous)
+{
+    std::vector<bool> result(layers.size(), false);
+    for (std::size_t n = 0; n < layers.size() && n < previous.size(); ++n) {
+        result[n] = is_cacheable(layers[n]) && layers[n] == previous[n] && (n == 0 || !has_key(layers[n - 1]));
+    }
+    return result;
+}
+
+std::vector<layer_run> layer_runs(const std::vector<layer>& layers, const std::vector<bool>& is_static)
+{
+    std::vector<layer_run> result;
+
+    for (std::size_t n = 0; n < layers.size();) {
+        auto end   = n;
+        auto items = 0;
+        while (end < layers.size() && is_static[end]) {
+            items += count_items(layers[end]);
+            ++end;
+        }
+
+        // A single item gains nothing from an intermediate texture.
+        if (items < 2) {
+            result.push_back(layer_run{n, n + 1, false});
+            ++n;
+        } else {
+            result.push_back(layer_run{n, end, true});
+            n = end;
+        }
+    }
+
+    return result;
+}
+
+bool is_opaque(const core::pixel_format_desc& desc)
+{
+    switch (desc.format) {
+        case core::pixel_format::gray:
+        case core::pixel_format::ycbcr:
+        case core::pixel_format::luma:
+        case core::pixel_format::bgr:
+        case core::pixel_format::rgb:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool covers_screen(const item& item)
+{
+    static const double epsilon = 0.000001;
+
+    const auto& transform = item.transform;
+
+    if (!is_opaque(item.pix_desc) || transform.opacity < 1.0 - epsilon || transform.is_key || transform.is_mix ||
+        transform.chroma.enable || std::abs(transform.angle) > epsilon) {
+        return false;
+    }
+
+    if (transform.crop.ul != core::rectangle().ul || transform.crop.lr != core::rectangle().lr ||
+        transform.perspective.ul != core::corners().ul || transform.perspective.ur != core::corners().ur ||
+        transform.perspective.lr != core::corners().lr || transform.perspective.ll != core::corners().ll ||
+        item.geometry.data() != core::frame_geometry::get_default().data()) {
+        return false;
+    }
+
+    for (int n = 0; n < 2; ++n) {
+        const auto clip_begin = transform.clip_translation[n];
+        const auto clip_end   = transform.clip_translation[n] + transform.clip_scale[n];
+        const auto fill_begin = (0.0 - transform.anchor[n]) * transform.fill_scale[n] + transform.fill_translation[n];
+        const auto fill_end   = (1.0 - transform.anchor[n]) * transform.fill_scale[n] + transform.fill_translation[n];
+
+        if (clip_begin > epsilon || clip_end < 1.0 - epsilon || std::min(fill_begin, fill_end) > epsilon ||
+            std::max(fill_begin, fill_end) < 1.0 - epsilon) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int cull(std::vector<layer>& layers)
+{
+    for (auto n = static_cast<int>(layers.size()) - 1; n >= 0; --n) {
+        auto& layer = layers[n];
+
+        if (layer.blend_mode != core::blend_mode::normal || (n > 0 && has_key(layers[n - 1]))) {
+            continue;
+        }
+
+        // Items after a key are masked by it.
+        auto unkeyed_end = std::find_if(
+            layer.items.begin(), layer.items.end(), [](const item& item) { return item.transform.is_key; });
+        auto cover = std::find_if(std::make_reverse_iterator(unkeyed_end), layer.items.rend(), covers_screen);
+
+        if (cover == layer.items.rend()) {
+            continue;
+        }
+
+        auto first = std::prev(cover.base());
+        auto count = static_cast<int>(first - layer.items.begin());
+        for (auto& sublayer : layer.sublayers) {
+            count += count_items(sublayer);
+        }
+        for (auto it = layers.begin(); it != layers.begin() + n; ++it) {
+            count += count_items(*it);
+        }
+
+        layer.sublayers.clear();
+        layer.items.erase(layer.items.begin(), first);
+        layers.erase(layers.begin(), layers.begin() + n);
+
+        return count;
+    }
+
+    return 0;
+}
+
+bool same_image(const std::vector<layer>&       layers,
+                const core::video_format_desc& format_desc,
+                const std::vector<layer>&       previous_layers,
+                const core::video_format_desc& previous_format_desc)
+{
+    return format_desc == previous_format_desc && layers == previous_layers;
+}
+
+}}} // namespace caspar::accelerator::ogl
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <core/frame/frame.h>
+#include <core/frame/frame_transform.h>
+#include <core/frame/geometry.h>
+#include <core/frame/pixel_format.h>
+#include <core/mixer/image/blend_modes.h>
+#include <core/video_format.h>
+
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace caspar { namespace accelerator { namespace ogl {
+
+// The layer tree the image mixer collects every tick, and the decisions on it that don't need the GPU.
+
+typedef std::shared_future<std::shared_ptr<class texture>> future_texture;
+
+struct item
+{
+    core::pixel_format_desc     pix_desc = core::pixel_format::invalid;
+    std::vector<future_texture> textures;
+    core::image_transform       transform;
+    core::frame_geometry        geometry = core::frame_geometry::get_default();
+    core::const_frame           frame;
+};
+
+// Same frame, transform and geometry, textures are not compared.
+bool operator==(const item& lhs, const item& rhs);
+
+struct layer
+{
+    std::vector<layer> sublayers;
+    std::vector<item>  items;
+    core::blend_mode   blend_mode;
+
+    layer(core::blend_mode blend_mode)
+        : blend_mode(blend_mode)
+    {
+    }
+};
+
+bool operator==(const layer& lhs, const layer& rhs);
+
+bool has_key(const layer& layer);
+
+// Layers that neither use a blend mode nor produce a key only ever draw "over" the target, so a run of them can be
+// flattened once and composited as a single texture.
+bool is_cacheable(const layer& layer);
+
+int count_items(const layer& layer);
+
+// Top level layers that are cacheable, equal to the layer at the same index in previous and not keyed by the layer
+// before them.
+std::vector<bool> static_layers(const std::vector<layer>& layers, const std::vector<layer>& previous);
+
+// Top level layers [begin, end) drawn in one go. A cached run is flattened into a texture that is reused for as long
+// as the run stays the same.
+struct layer_run
+{
+    std::size_t begin;
+    std::size_t end;
+    bool        cached;
+};
+
+// Every stretch of static layers holding at least two items is a cached run, all other layers are drawn one by one.
+std::vector<layer_run> layer_runs(const std::vector<layer>& layers, const std::vector<bool>& is_static);
+
+bool is_opaque(const core::pixel_format_desc& desc);
+
+// Whether item replaces everything drawn before it, i.e. an opaque frame filling the whole screen.
+bool covers_screen(const item& item);
+
+// Drops everything that is drawn before the topmost item covering the screen. Returns the number of items dropped.
+int cull(std::vector<layer>& layers);
+
+// Whether a tick draws the same image as the previous one, i.e. the same culled layers in the same format.
+bool same_image(const std::vector<layer>&       layers,
+                const core::video_format_desc& format_desc,
+                const std::vector<layer>&       previous_layers,
+                const core::video_format_desc& previous_format_desc);
+
+}}} // namespace caspar::accelerator::ogl
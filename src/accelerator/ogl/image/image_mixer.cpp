@@ -21,6 +21,7 @@
 #include "image_mixer.h"
 
 #include "image_kernel.h"
+#include "image_layers.h"
 
 #include "../util/buffer.h"
 #include "../util/device.h"
@@ -35,6 +36,7 @@
 #include <core/frame/frame_transform.h>
 #include <core/frame/geometry.h>
 #include <core/frame/pixel_format.h>
+#include <core/monitor/monitor.h>
 #include <core/video_format.h>
 
 #include <GL/glew.h>
@@ -46,58 +48,140 @@
 
 namespace caspar { namespace accelerator { namespace ogl {
 
-typedef std::shared_future<std::shared_ptr<texture>> future_texture;
-
-struct item
-{
-    core::pixel_format_desc     pix_desc = core::pixel_format::invalid;
-    std::vector<future_texture> textures;
-    core::image_transform       transform;
-    core::frame_geometry        geometry = core::frame_geometry::get_default();
-};
-
-struct layer
+// Cached runs of the last frame drawn, the hits and misses are decided on the mixer thread before drawing.
+struct cache_stats
 {
-    std::vector<layer> sublayers;
-    std::vector<item>  items;
-    core::blend_mode   blend_mode;
-
-    layer(core::blend_mode blend_mode)
-        : blend_mode(blend_mode)
-    {
-    }
+    int          hits         = 0;
+    int          misses       = 0;
+    int          entries      = 0;
+    std::int64_t total_hits   = 0;
+    std::int64_t total_misses = 0;
 };
 
 class image_renderer
 {
     spl::shared_ptr<device> ogl_;
     image_kernel            kernel_;
+    const core::color_depth depth_;
+
+    // Only used on the mixer thread.
+    std::vector<layer>              previous_layers_;
+    std::vector<std::vector<layer>> cached_runs_;
+    cache_stats                     stats_;
+
+    // Only used on the OGL thread, the image of every run in cached_runs_.
+    std::vector<std::shared_ptr<texture>> cached_images_;
+
+    // Returned for frames without layers, sized to the format. Frames still holding a previous one keep it alive.
+    std::shared_ptr<const std::vector<std::uint8_t>> empty_;
 
   public:
-    image_renderer(const spl::shared_ptr<device>& ogl)
+    image_renderer(const spl::shared_ptr<device>& ogl, core::color_depth depth)
         : ogl_(ogl)
         , kernel_(ogl_)
+        , depth_(depth)
     {
     }
 
+    const cache_stats& stats() const { return stats_; }
+
     std::future<array<const std::uint8_t>> operator()(std::vector<layer>             layers,
                                                       const core::video_format_desc& format_desc)
     {
         if (layers.empty()) { // Bypass GPU with empty frame.
-            static const std::vector<uint8_t> buffer(4096 * 4096 * 4, 0);
-            return make_ready_future(array<const std::uint8_t>(buffer.data(), format_desc.size, true));
+            const auto size = format_desc.size * core::bytes_per_sample(depth_);
+            if (!empty_ || empty_->size() != size) {
+                empty_ = std::make_shared<const std::vector<std::uint8_t>>(size, 0);
+            }
+            return make_ready_future(array<const std::uint8_t>(empty_->data(), empty_->size(), empty_));
         }
 
+        // Runs of top level layers that are identical to the previous frame, i.e. same frames, transforms and
+        // geometry, are composited from a texture that is only redrawn when the run changes. Every cached run refers
+        // to the index of its image in the previous frame's cache, or -1 when it is drawn anew.
+        auto runs        = layer_runs(layers, static_layers(layers, previous_layers_));
+        previous_layers_ = layers;
+
+        std::vector<std::vector<layer>> cached_runs;
+        std::vector<int>                sources;
+
+        stats_.hits   = 0;
+        stats_.misses = 0;
+
+        for (const auto& range : runs) {
+            if (!range.cached) {
+                continue;
+            }
+
+            std::vector<layer> run(layers.begin() + range.begin, layers.begin() + range.end);
+
+            auto it = std::find(cached_runs_.begin(), cached_runs_.end(), run);
+            if (it != cached_runs_.end()) {
+                sources.push_back(static_cast<int>(it - cached_runs_.begin()));
+                ++stats_.hits;
+            } else {
+                sources.push_back(-1);
+                ++stats_.misses;
+            }
+
+            cached_runs.push_back(std::move(run));
+        }
+
+        cached_runs_ = std::move(cached_runs);
+
+        stats_.entries = static_cast<int>(cached_runs_.size());
+        stats_.total_hits += stats_.hits;
+        stats_.total_misses += stats_.misses;
+
         return flatten(ogl_->dispatch_async([=]() mutable -> std::shared_future<array<const std::uint8_t>> {
-            auto target_texture = ogl_->create_texture(format_desc.width, format_desc.height, 4);
+            auto target_texture = ogl_->create_texture(format_desc.width, format_desc.height, 4, depth_);
 
-            draw(target_texture, std::move(layers), format_desc);
+            draw_cached(target_texture, std::move(layers), runs, sources, format_desc);
 
             return ogl_->copy_async(target_texture);
         }));
     }
 
   private:
+    void draw_cached(std::shared_ptr<texture>&      target_texture,
+                     std::vector<layer>             layers,
+                     const std::vector<layer_run>&  runs,
+                     const std::vector<int>&        sources,
+                     const core::video_format_desc& format_desc)
+    {
+        std::vector<std::shared_ptr<texture>> cached_images;
+        std::shared_ptr<texture>              layer_key_texture;
+
+        for (const auto& range : runs) {
+            if (!range.cached) {
+                draw(target_texture, layers[range.begin].sublayers, format_desc);
+                draw(target_texture, std::move(layers[range.begin]), layer_key_texture, format_desc);
+                continue;
+            }
+
+            const auto source = sources[cached_images.size()];
+
+            std::shared_ptr<texture> run_texture;
+            // A failed draw may have left fewer images than the mixer thread expects.
+            if (source >= 0 && source < static_cast<int>(cached_images_.size())) {
+                run_texture = cached_images_[source];
+            } else {
+                run_texture = ogl_->create_texture(target_texture->width(), target_texture->height(), 4, depth_);
+                draw(run_texture,
+                     std::vector<layer>(std::make_move_iterator(layers.begin() + range.begin),
+                                        std::make_move_iterator(layers.begin() + range.end)),
+                     format_desc);
+            }
+
+            draw(target_texture, std::shared_ptr<texture>(run_texture), core::blend_mode::normal);
+            cached_images.push_back(std::move(run_texture));
+
+            layer_key_texture = nullptr;
+        }
+
+        cached_images_ = std::move(cached_images);
+    }
+
     void draw(std::shared_ptr<texture>&      target_texture,
               std::vector<layer>             layers,
               const core::video_format_desc& format_desc)
@@ -122,7 +206,7 @@ class image_renderer
         std::shared_ptr<texture> local_mix_texture;
 
         if (layer.blend_mode != core::blend_mode::normal) {
-            auto layer_texture = ogl_->create_texture(target_texture->width(), target_texture->height(), 4);
+            auto layer_texture = ogl_->create_texture(target_texture->width(), target_texture->height(), 4, depth_);
 
             for (auto& item : layer.items)
                 draw(layer_texture,
@@ -169,9 +253,9 @@ class image_renderer
         }
 
         if (item.transform.is_key) {
-            local_key_texture = local_key_texture
-                                    ? local_key_texture
-                                    : ogl_->create_texture(target_texture->width(), target_texture->height(), 1);
+            local_key_texture =
+                local_key_texture ? local_key_texture
+                                  : ogl_->create_texture(target_texture->width(), target_texture->height(), 1, depth_);
 
             draw_params.background = local_key_texture;
             draw_params.local_key  = nullptr;
@@ -179,9 +263,9 @@ class image_renderer
 
             kernel_.draw(std::move(draw_params));
         } else if (item.transform.is_mix) {
-            local_mix_texture = local_mix_texture
-                                    ? local_mix_texture
-                                    : ogl_->create_texture(target_texture->width(), target_texture->height(), 4);
+            local_mix_texture =
+                local_mix_texture ? local_mix_texture
+                                  : ogl_->create_texture(target_texture->width(), target_texture->height(), 4, depth_);
 
             draw_params.background = local_mix_texture;
             draw_params.local_key  = std::move(local_key_texture);
@@ -226,19 +310,29 @@ struct image_mixer::impl
     : public core::frame_factory
     , public std::enable_shared_from_this<impl>
 {
-    spl::shared_ptr<device>            ogl_;
-    image_renderer                     renderer_;
-    std::vector<core::image_transform> transform_stack_;
-    std::vector<layer>                 layers_; // layer/stream/items
-    std::vector<layer*>                layer_stack_;
+    spl::shared_ptr<device>                       ogl_;
+    core::monitor::state                          state_;
+    image_renderer                                renderer_;
+    std::vector<core::image_transform>            transform_stack_;
+    std::vector<layer>                            layers_; // layer/stream/items
+    std::vector<layer*>                           layer_stack_;
+    std::vector<layer>                            previous_layers_;
+    core::video_format_desc                       previous_format_desc_;
+    std::shared_future<array<const std::uint8_t>> previous_image_;
+    std::int64_t                                  reused_ = 0;
+    const core::color_depth                       depth_;
 
   public:
-    impl(const spl::shared_ptr<device>& ogl, int channel_id)
+    impl(const spl::shared_ptr<device>& ogl, int channel_id, core::color_depth depth)
         : ogl_(ogl)
-        , renderer_(ogl)
+        , renderer_(ogl, depth)
         , transform_stack_(1)
+        , depth_(depth)
     {
-        CASPAR_LOG(info) << L"Initialized OpenGL Accelerated GPU Image Mixer for channel " << channel_id;
+        CASPAR_LOG(info) << L"Initialized OpenGL Accelerated GPU Image Mixer for channel " << channel_id << L" ("
+                         << static_cast<int>(depth) << L" bit)";
+
+        state_["depth"] = static_cast<int>(depth);
     }
 
     void push(const core::frame_transform& transform)
@@ -272,21 +366,38 @@ struct image_mixer::impl
         item.pix_desc  = frame.pixel_format_desc();
         item.transform = transform_stack_.back();
         item.geometry  = frame.geometry();
+        item.frame     = frame;
 
+        // Frames without textures are uploaded in render, once it is known that they are visible.
         auto textures_ptr = boost::any_cast<std::shared_ptr<std::vector<future_texture>>>(frame.opaque());
 
         if (textures_ptr) {
             item.textures = *textures_ptr;
-        } else {
+        }
+
+        layer_stack_.back()->items.push_back(item);
+    }
+
+    void upload(layer& layer)
+    {
+        for (auto& sublayer : layer.sublayers) {
+            upload(sublayer);
+        }
+
+        for (auto& item : layer.items) {
+            if (!item.textures.empty()) {
+                continue;
+            }
+
+            const auto bytes = core::bytes_per_sample(item.pix_desc.depth);
             for (int n = 0; n < static_cast<int>(item.pix_desc.planes.size()); ++n) {
-                item.textures.emplace_back(ogl_->copy_async(frame.image_data(n),
+                item.textures.emplace_back(ogl_->copy_async(item.frame.image_data(n),
                                                             item.pix_desc.planes[n].width,
                                                             item.pix_desc.planes[n].height,
-                                                            item.pix_desc.planes[n].stride));
+                                                            item.pix_desc.planes[n].stride / bytes,
+                                                            item.pix_desc.depth));
             }
         }
-
-        layer_stack_.back()->items.push_back(item);
     }
 
     void pop()
@@ -297,9 +408,38 @@ struct image_mixer::impl
 
     std::future<array<const std::uint8_t>> render(const core::video_format_desc& format_desc)
     {
-        return renderer_(std::move(layers_), format_desc);
+        state_["culled"] = cull(layers_);
+
+        // Same frames with the same transforms as the previous tick, hand out the previous image again.
+        if (previous_image_.valid() && same_image(layers_, format_desc, previous_layers_, previous_format_desc_)) {
+            layers_.clear();
+            state_["reused"] = ++reused_;
+            return std::async(std::launch::deferred, [image = previous_image_] { return image.get(); });
+        }
+
+        for (auto& layer : layers_) {
+            upload(layer);
+        }
+
+        previous_layers_      = layers_;
+        previous_format_desc_ = format_desc;
+        previous_image_       = renderer_(std::move(layers_), format_desc).share();
+
+        const auto& stats        = renderer_.stats();
+        state_["cache/hits"]     = stats.hits;
+        state_["cache/misses"]   = stats.misses;
+        state_["cache/entries"]  = stats.entries;
+        state_["cache/hit-rate"] = stats.total_hits + stats.total_misses > 0
+                                       ? static_cast<double>(stats.total_hits) / (stats.total_hits + stats.total_misses)
+                                       : 0.0;
+
+        return std::async(std::launch::deferred, [image = previous_image_] { return image.get(); });
     }
 
+    const core::monitor::state& state() const { return state_; }
+
+    core::color_depth depth() const { return depth_; }
+
     core::mutable_frame create_frame(const void* tag, const core::pixel_format_desc& desc) override
     {
         std::vector<array<std::uint8_t>> image_data;
@@ -319,17 +459,21 @@ struct image_mixer::impl
                     return boost::any{};
                 }
                 std::vector<future_texture> textures;
+                const auto                  bytes = core::bytes_per_sample(desc.depth);
                 for (int n = 0; n < static_cast<int>(desc.planes.size()); ++n) {
-                    textures.emplace_back(self->ogl_->copy_async(
-                        image_data[n], desc.planes[n].width, desc.planes[n].height, desc.planes[n].stride));
+                    textures.emplace_back(self->ogl_->copy_async(image_data[n],
+                                                                 desc.planes[n].width,
+                                                                 desc.planes[n].height,
+                                                                 desc.planes[n].stride / bytes,
+                                                                 desc.depth));
                 }
                 return std::make_shared<decltype(textures)>(std::move(textures));
             });
     }
 };
 
-image_mixer::image_mixer(const spl::shared_ptr<device>& ogl, int channel_id)
-    : impl_(std::make_unique<impl>(ogl, channel_id))
+image_mixer::image_mixer(const spl::shared_ptr<device>& ogl, int channel_id, core::color_depth depth)
+    : impl_(std::make_unique<impl>(ogl, channel_id, depth))
 {
 }
 image_mixer::~image_mixer() {}
@@ -344,5 +488,7 @@ core::mutable_frame image_mixer::create_frame(const void* tag, const core::pixel
 {
     return impl_->create_frame(tag, desc);
 }
+const core::monitor::state& image_mixer::state() const { return impl_->state(); }
+core::color_depth           image_mixer::depth() const { return impl_->depth(); }
 
 }}} // namespace caspar::accelerator::ogl
@@ -38,7 +38,7 @@ namespace caspar { namespace accelerator { namespace ogl {
 class image_mixer final : public core::image_mixer
 {
   public:
-    image_mixer(const spl::shared_ptr<class device>& ogl, int channel_id);
+    image_mixer(const spl::shared_ptr<class device>& ogl, int channel_id, core::color_depth depth);
     image_mixer(const image_mixer&) = delete;
 
     ~image_mixer();
@@ -47,6 +47,8 @@ class image_mixer final : public core::image_mixer
 
     std::future<array<const std::uint8_t>> operator()(const core::video_format_desc& format_desc) override;
     core::mutable_frame                    create_frame(const void* tag, const core::pixel_format_desc& desc) override;
+    const core::monitor::state&            state() const override;
+    core::color_depth                      depth() const override;
 
     // core::image_mixer
 
@@ -57,7 +57,7 @@ struct device::impl : public std::enable_shared_from_this<impl>
 
     sf::Context device_;
 
-    std::array<tbb::concurrent_unordered_map<size_t, texture_queue_t>, 4> device_pools_;
+    std::array<tbb::concurrent_unordered_map<size_t, texture_queue_t>, 8> device_pools_;
     std::array<tbb::concurrent_unordered_map<size_t, buffer_queue_t>, 2>  host_pools_;
 
     typedef tbb::concurrent_bounded_queue<std::shared_ptr<buffer>> sync_queue_t;
@@ -158,17 +158,20 @@ struct device::impl : public std::enable_shared_from_this<impl>
 
     std::wstring version() { return version_; }
 
-    std::shared_ptr<texture> create_texture(int width, int height, int stride, bool clear)
+    std::shared_ptr<texture> create_texture(int width, int height, int stride, core::color_depth depth, bool clear)
     {
         CASPAR_VERIFY(stride > 0 && stride < 5);
         CASPAR_VERIFY(width > 0 && height > 0);
 
+        // 16 bit textures are pooled after the 8 bit ones.
+        auto index = stride - 1 + (depth == core::color_depth::sixteen ? 4 : 0);
+
         // TODO (perf) Shared pool.
-        auto pool = &device_pools_[stride - 1][((width << 16) & 0xFFFF0000) | (height & 0x0000FFFF)];
+        auto pool = &device_pools_[index][((width << 16) & 0xFFFF0000) | (height & 0x0000FFFF)];
 
         std::shared_ptr<texture> tex;
         if (!pool->try_pop(tex)) {
-            tex = std::make_shared<texture>(width, height, stride);
+            tex = std::make_shared<texture>(width, height, stride, depth);
         }
 
         if (clear) {
@@ -207,7 +210,7 @@ struct device::impl : public std::enable_shared_from_this<impl>
     }
 
     std::future<std::shared_ptr<texture>>
-    copy_async(const array<const uint8_t>& source, int width, int height, int stride)
+    copy_async(const array<const uint8_t>& source, int width, int height, int stride, core::color_depth depth)
     {
         return dispatch_async([=] {
             std::shared_ptr<buffer> buf;
@@ -221,7 +224,7 @@ struct device::impl : public std::enable_shared_from_this<impl>
                 std::memcpy(buf->data(), source.data(), source.size());
             }
 
-            auto tex = create_texture(width, height, stride, false);
+            auto tex = create_texture(width, height, stride, depth, false);
             tex->copy_from(*buf);
             // TODO (perf) save tex on source
             return tex;
@@ -274,15 +277,18 @@ device::device()
 {
 }
 device::~device() {}
-std::shared_ptr<texture> device::create_texture(int width, int height, int stride)
+std::shared_ptr<texture> device::create_texture(int width, int height, int stride, core::color_depth depth)
 {
-    return impl_->create_texture(width, height, stride, true);
+    return impl_->create_texture(width, height, stride, depth, true);
 }
 array<uint8_t> device::create_array(int size) { return impl_->create_array(size); }
-std::future<std::shared_ptr<texture>>
-device::copy_async(const array<const uint8_t>& source, int width, int height, int stride)
+std::future<std::shared_ptr<texture>> device::copy_async(const array<const uint8_t>& source,
+                                                         int                         width,
+                                                         int                         height,
+                                                         int                         stride,
+                                                         core::color_depth           depth)
 {
-    return impl_->copy_async(source, width, height, stride);
+    return impl_->copy_async(source, width, height, stride, depth);
 }
 std::future<array<const uint8_t>> device::copy_async(const std::shared_ptr<texture>& source)
 {
@@ -23,6 +23,8 @@
 
 #include <common/array.h>
 
+#include <core/frame/pixel_format.h>
+
 #include <functional>
 #include <future>
 
@@ -38,12 +40,18 @@ class device final : public std::enable_shared_from_this<device>
 
     device& operator=(const device&) = delete;
 
-    std::shared_ptr<class texture> create_texture(int width, int height, int stride);
+    std::shared_ptr<class texture> create_texture(int               width,
+                                                  int               height,
+                                                  int               stride,
+                                                  core::color_depth depth = core::color_depth::eight);
     array<uint8_t>                 create_array(int size);
 
-    std::future<std::shared_ptr<class texture>>
-                                      copy_async(const array<const uint8_t>& source, int width, int height, int stride);
-    std::future<array<const uint8_t>> copy_async(const std::shared_ptr<class texture>& source);
+    std::future<std::shared_ptr<class texture>> copy_async(const array<const uint8_t>& source,
+                                                           int                         width,
+                                                           int                         height,
+                                                           int                         stride,
+                                                           core::color_depth depth = core::color_depth::eight);
+    std::future<array<const uint8_t>>           copy_async(const std::shared_ptr<class texture>& source);
 
     template <typename Func>
     auto dispatch_async(Func&& func)
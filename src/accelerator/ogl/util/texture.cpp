@@ -31,28 +31,37 @@ namespace caspar { namespace accelerator { namespace ogl {
 static GLenum FORMAT[]          = {0, GL_RED, GL_RG, GL_BGR, GL_BGRA};
 static GLenum INTERNAL_FORMAT[] = {0, GL_R8, GL_RG8, GL_RGB8, GL_RGBA8};
 static GLenum TYPE[] = {0, GL_UNSIGNED_BYTE, GL_UNSIGNED_BYTE, GL_UNSIGNED_BYTE, GL_UNSIGNED_INT_8_8_8_8_REV};
+static GLenum INTERNAL_FORMAT16[] = {0, GL_R16, GL_RG16, GL_RGB16, GL_RGBA16};
+static GLenum TYPE16[]            = {0, GL_UNSIGNED_SHORT, GL_UNSIGNED_SHORT, GL_UNSIGNED_SHORT, GL_UNSIGNED_SHORT};
 
 struct texture::impl : boost::noncopyable
 {
-    GLuint  id_     = 0;
-    GLsizei width_  = 0;
-    GLsizei height_ = 0;
-    GLsizei stride_ = 0;
-    GLsizei size_   = 0;
+    GLuint            id_     = 0;
+    GLsizei           width_  = 0;
+    GLsizei           height_ = 0;
+    GLsizei           stride_ = 0;
+    core::color_depth depth_  = core::color_depth::eight;
+    GLsizei           size_   = 0;
+    GLenum            type_   = 0;
 
   public:
-    impl(int width, int height, int stride)
+    impl(int width, int height, int stride, core::color_depth depth)
         : width_(width)
         , height_(height)
         , stride_(stride)
-        , size_(width * height * stride)
+        , depth_(depth)
+        , size_(width * height * stride * core::bytes_per_sample(depth))
+        , type_(depth == core::color_depth::sixteen ? TYPE16[stride] : TYPE[stride])
     {
+        auto internal_format =
+            depth_ == core::color_depth::sixteen ? INTERNAL_FORMAT16[stride_] : INTERNAL_FORMAT[stride_];
+
         GL(glCreateTextures(GL_TEXTURE_2D, 1, &id_));
         GL(glTextureParameteri(id_, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
         GL(glTextureParameteri(id_, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
         GL(glTextureParameteri(id_, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
         GL(glTextureParameteri(id_, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
-        GL(glTextureStorage2D(id_, 1, INTERNAL_FORMAT[stride_], width_, height_));
+        GL(glTextureStorage2D(id_, 1, internal_format, width_, height_));
     }
 
     ~impl() { glDeleteTextures(1, &id_); }
@@ -69,26 +78,26 @@ struct texture::impl : boost::noncopyable
 
     void attach() { GL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + 0, GL_TEXTURE_2D, id_, 0)); }
 
-    void clear() { GL(glClearTexImage(id_, 0, FORMAT[stride_], TYPE[stride_], nullptr)); }
+    void clear() { GL(glClearTexImage(id_, 0, FORMAT[stride_], type_, nullptr)); }
 
     void copy_from(buffer& src)
     {
         src.bind();
         // TODO (fix) This fails on weird dimensions.
-        GL(glTextureSubImage2D(id_, 0, 0, 0, width_, height_, FORMAT[stride_], TYPE[stride_], nullptr));
+        GL(glTextureSubImage2D(id_, 0, 0, 0, width_, height_, FORMAT[stride_], type_, nullptr));
         src.unbind();
     }
 
     void copy_to(buffer& dst)
     {
         dst.bind();
-        GL(glGetTextureImage(id_, 0, FORMAT[stride_], TYPE[stride_], size_, nullptr));
+        GL(glGetTextureImage(id_, 0, FORMAT[stride_], type_, size_, nullptr));
         dst.unbind();
     }
 };
 
-texture::texture(int width, int height, int stride)
-    : impl_(new impl(width, height, stride))
+texture::texture(int width, int height, int stride, core::color_depth depth)
+    : impl_(new impl(width, height, stride, depth))
 {
 }
 texture::texture(texture&& other)
@@ -107,10 +116,11 @@ void texture::attach() { impl_->attach(); }
 void texture::clear() { impl_->clear(); }
 void texture::copy_from(buffer& source) { impl_->copy_from(source); }
 void texture::copy_to(buffer& dest) { impl_->copy_to(dest); }
-int  texture::width() const { return impl_->width_; }
-int  texture::height() const { return impl_->height_; }
-int  texture::stride() const { return impl_->stride_; }
-int  texture::size() const { return impl_->width_ * impl_->height_ * impl_->stride_; }
-int  texture::id() const { return impl_->id_; }
+int               texture::width() const { return impl_->width_; }
+int               texture::height() const { return impl_->height_; }
+int               texture::stride() const { return impl_->stride_; }
+core::color_depth texture::depth() const { return impl_->depth_; }
+int               texture::size() const { return impl_->size_; }
+int               texture::id() const { return impl_->id_; }
 
 }}} // namespace caspar::accelerator::ogl
@@ -21,6 +21,8 @@
 
 #pragma once
 
+#include <core/frame/pixel_format.h>
+
 #include <memory>
 
 namespace caspar { namespace accelerator { namespace ogl {
@@ -28,7 +30,7 @@ namespace caspar { namespace accelerator { namespace ogl {
 class texture final
 {
   public:
-    texture(int width, int height, int stride);
+    texture(int width, int height, int stride, core::color_depth depth = core::color_depth::eight);
     texture(const texture&) = delete;
     texture(texture&& other);
     ~texture();
@@ -46,9 +48,10 @@ class texture final
 
     int width() const;
     int height() const;
-    int stride() const;
-    int size() const;
-    int id() const;
+    int               stride() const;
+    core::color_depth depth() const;
+    int               size() const;
+    int               id() const;
 
   private:
     struct impl;
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <emmintrin.h>
+#endif
+
+namespace caspar {
+
+// Rounded c * a / 255, exact for all 8 bit inputs.
+inline int premultiply(int c, int a)
+{
+    const auto t = c * a + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+// premultiply on eight 16 bit lanes holding 8 bit values.
+inline __m128i premultiply_epi16(__m128i c, __m128i a)
+{
+    const auto t = _mm_add_epi16(_mm_mullo_epi16(c, a), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+} // namespace caspar
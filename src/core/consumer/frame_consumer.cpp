@@ -23,6 +23,8 @@
 
 #include "frame_consumer.h"
 
+#include "null/null_consumer.h"
+
 #include <common/except.h>
 #include <common/future.h>
 
@@ -50,6 +52,8 @@ struct frame_consumer_registry::impl
 frame_consumer_registry::frame_consumer_registry()
     : impl_(new impl())
 {
+    register_consumer_factory(L"Null Consumer", create_null_consumer);
+    register_preconfigured_consumer_factory(L"null", create_preconfigured_null_consumer);
 }
 
 void frame_consumer_registry::register_consumer_factory(const std::wstring& name, const consumer_factory_t& factory)
@@ -125,6 +129,11 @@ class destroy_consumer_proxy : public frame_consumer
     bool                  has_synchronization_clock() const override { return consumer_->has_synchronization_clock(); }
     int                   index() const override { return consumer_->index(); }
     const monitor::state& state() const override { return consumer_->state(); }
+    bool                  supports_color_depth(color_depth depth) const override
+    {
+        return consumer_->supports_color_depth(depth);
+    }
+    bool supports_audio_only() const override { return consumer_->supports_audio_only(); }
 };
 
 class print_consumer_proxy : public frame_consumer
@@ -156,6 +165,11 @@ class print_consumer_proxy : public frame_consumer
     bool                  has_synchronization_clock() const override { return consumer_->has_synchronization_clock(); }
     int                   index() const override { return consumer_->index(); }
     const monitor::state& state() const override { return consumer_->state(); }
+    bool                  supports_color_depth(color_depth depth) const override
+    {
+        return consumer_->supports_color_depth(depth);
+    }
+    bool supports_audio_only() const override { return consumer_->supports_audio_only(); }
 };
 
 spl::shared_ptr<core::frame_consumer>
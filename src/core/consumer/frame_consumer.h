@@ -21,6 +21,7 @@
 
 #pragma once
 
+#include "../frame/pixel_format.h"
 #include "../fwd.h"
 #include "../monitor/monitor.h"
 
@@ -60,6 +61,12 @@ class frame_consumer
     virtual std::wstring name() const  = 0;
     virtual bool         has_synchronization_clock() const { return false; }
     virtual int          index() const = 0;
+
+    // Consumers that return false for the channel's depth are sent an 8 bit copy of each frame.
+    virtual bool supports_color_depth(color_depth depth) const { return depth == color_depth::eight; }
+
+    // Consumers that return false are sent a black image along with the audio of an audio-only channel.
+    virtual bool supports_audio_only() const { return false; }
 };
 
 typedef std::function<spl::shared_ptr<frame_consumer>(const std::vector<std::wstring>&,
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../../StdAfx.h"
+
+#include "null_consumer.h"
+
+#include "../frame_consumer.h"
+
+#include "../../frame/frame.h"
+#include "../../frame/pixel_format.h"
+#include "../../video_format.h"
+
+#include <common/array.h>
+#include <common/diagnostics/graph.h>
+#include <common/future.h>
+#include <common/param.h>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace caspar { namespace core {
+
+namespace {
+
+const std::uint64_t prime64_1 = 0x9E3779B185EBCA87ULL;
+const std::uint64_t prime64_2 = 0xC2B2AE3D27D4EB4FULL;
+const std::uint64_t prime64_3 = 0x165667B19E3779F9ULL;
+const std::uint64_t prime64_4 = 0x85EBCA77C2B2AE63ULL;
+const std::uint64_t prime64_5 = 0x27D4EB2F165667C5ULL;
+
+std::uint64_t rotl64(std::uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+std::uint64_t read64(const std::uint8_t* p)
+{
+    std::uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+std::uint32_t read32(const std::uint8_t* p)
+{
+    std::uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+std::uint64_t xxh64_round(std::uint64_t acc, std::uint64_t input)
+{
+    acc += input * prime64_2;
+    acc = rotl64(acc, 31);
+    return acc * prime64_1;
+}
+
+std::uint64_t xxh64_merge(std::uint64_t acc, std::uint64_t value)
+{
+    acc ^= xxh64_round(0, value);
+    return acc * prime64_1 + prime64_4;
+}
+
+} // namespace
+
+std::uint64_t xxh64(const void* data, std::size_t size, std::uint64_t seed)
+{
+    auto       p   = reinterpret_cast<const std::uint8_t*>(data);
+    const auto end = p + size;
+
+    std::uint64_t h;
+
+    if (size >= 32) {
+        auto v1 = seed + prime64_1 + prime64_2;
+        auto v2 = seed + prime64_2;
+        auto v3 = seed;
+        auto v4 = seed - prime64_1;
+
+        for (; p + 32 <= end; p += 32) {
+            v1 = xxh64_round(v1, read64(p));
+            v2 = xxh64_round(v2, read64(p + 8));
+            v3 = xxh64_round(v3, read64(p + 16));
+            v4 = xxh64_round(v4, read64(p + 24));
+        }
+
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxh64_merge(h, v1);
+        h = xxh64_merge(h, v2);
+        h = xxh64_merge(h, v3);
+        h = xxh64_merge(h, v4);
+    } else {
+        h = seed + prime64_5;
+    }
+
+    h += static_cast<std::uint64_t>(size);
+
+    for (; p + 8 <= end; p += 8) {
+        h ^= xxh64_round(0, read64(p));
+        h = rotl64(h, 27) * prime64_1 + prime64_4;
+    }
+
+    if (p + 4 <= end) {
+        h ^= static_cast<std::uint64_t>(read32(p)) * prime64_1;
+        h = rotl64(h, 23) * prime64_2 + prime64_3;
+        p += 4;
+    }
+
+    for (; p < end; ++p) {
+        h ^= *p * prime64_5;
+        h = rotl64(h, 11) * prime64_1;
+    }
+
+    h ^= h >> 33;
+    h *= prime64_2;
+    h ^= h >> 29;
+    h *= prime64_3;
+    h ^= h >> 32;
+
+    return h;
+}
+
+namespace {
+
+std::string to_hex(std::uint64_t value)
+{
+    char str[17];
+    std::snprintf(str, sizeof(str), "%016llx", static_cast<unsigned long long>(value));
+    return str;
+}
+
+} // namespace
+
+struct null_consumer : public frame_consumer
+{
+    typedef std::chrono::high_resolution_clock clock;
+
+    const bool checksum_;
+    const bool freerun_;
+
+    monitor::state                      state_;
+    spl::shared_ptr<diagnostics::graph> graph_;
+    video_format_desc                   format_desc_;
+    int                                 channel_index_ = -1;
+
+    std::int64_t      frame_number_ = 0;
+    clock::time_point last_arrival_;
+    clock::time_point window_start_;
+    int               window_frames_ = 0;
+    double            fps_           = 0.0;
+    double            jitter_        = 0.0;
+    std::uint64_t     stream_hash_   = 0;
+
+  public:
+    null_consumer(bool checksum, bool freerun)
+        : checksum_(checksum)
+        , freerun_(freerun)
+    {
+        graph_->set_color("frame-time", diagnostics::color(0.5f, 1.0f, 0.2f));
+        graph_->set_color("jitter", diagnostics::color(1.0f, 0.5f, 0.0f));
+        diagnostics::register_graph(graph_);
+    }
+
+    // frame_consumer
+
+    void initialize(const video_format_desc& format_desc, int channel_index) override
+    {
+        format_desc_   = format_desc;
+        channel_index_ = channel_index;
+        frame_number_  = 0;
+        window_frames_ = 0;
+        fps_           = 0.0;
+        jitter_        = 0.0;
+        stream_hash_   = 0;
+        last_arrival_  = clock::time_point();
+
+        graph_->set_text(print());
+    }
+
+    std::future<bool> send(const_frame frame) override
+    {
+        const auto now = clock::now();
+
+        if (last_arrival_ != clock::time_point()) {
+            const auto interval = std::chrono::duration<double>(now - last_arrival_).count();
+            const auto expected = 1.0 / format_desc_.fps;
+
+            // Smoothed deviation from the nominal frame duration, in the manner of RFC 3550.
+            jitter_ += (std::abs(interval - expected) - jitter_) / 16.0;
+
+            graph_->set_value("frame-time", interval * format_desc_.fps * 0.5);
+            graph_->set_value("jitter", jitter_ * format_desc_.fps);
+        } else {
+            window_start_ = now;
+        }
+        last_arrival_ = now;
+
+        window_frames_ += 1;
+        const auto window = std::chrono::duration<double>(now - window_start_).count();
+        if (window >= 1.0) {
+            fps_           = (window_frames_ - 1) / window;
+            window_start_  = now;
+            window_frames_ = 1;
+        }
+
+        state_["null/frame"]  = frame_number_++;
+        state_["null/fps"]    = fps_;
+        state_["null/jitter"] = jitter_;
+
+        if (checksum_) {
+            std::uint64_t image_hash = 0;
+            for (int n = 0; n < static_cast<int>(frame.pixel_format_desc().planes.size()); ++n) {
+                image_hash = xxh64(frame.image_data(n).data(), frame.image_data(n).size(), image_hash);
+            }
+
+            const auto& audio      = frame.audio_data();
+            const auto  audio_hash = xxh64(audio.data(), audio.size() * sizeof(audio.data()[0]), 0);
+
+            const std::uint64_t hashes[] = {stream_hash_, image_hash, audio_hash};
+            stream_hash_                 = xxh64(hashes, sizeof(hashes), 0);
+
+            state_["null/checksum/image"]  = to_hex(image_hash);
+            state_["null/checksum/audio"]  = to_hex(audio_hash);
+            state_["null/checksum/stream"] = to_hex(stream_hash_);
+        }
+
+        return make_ready_future(true);
+    }
+
+    std::wstring print() const override
+    {
+        return L"null[" + boost::lexical_cast<std::wstring>(channel_index_) + L"|" + format_desc_.name + L"]";
+    }
+
+    std::wstring name() const override { return L"null"; }
+
+    int index() const override { return 1000; }
+
+    // Claiming the clock keeps the output from pacing the channel, which then runs as fast as it can.
+    bool has_synchronization_clock() const override { return freerun_; }
+
+    // Frames are only hashed, so they are taken at the channel's depth rather than converted to 8 bit first.
+    bool supports_color_depth(color_depth) const override { return true; }
+
+    // Nothing is drawn, so audio-only channels skip the black image.
+    bool supports_audio_only() const override { return true; }
+
+    const monitor::state& state() const override { return state_; }
+};
+
+spl::shared_ptr<frame_consumer> create_null_consumer(const std::vector<std::wstring>&            params,
+                                                     std::vector<spl::shared_ptr<video_channel>> channels)
+{
+    if (params.size() < 1 || !boost::iequals(params.at(0), L"NULL")) {
+        return frame_consumer::empty();
+    }
+
+    return spl::make_shared<null_consumer>(contains_param(L"CHECKSUM", params), contains_param(L"FREERUN", params));
+}
+
+spl::shared_ptr<frame_consumer>
+create_preconfigured_null_consumer(const boost::property_tree::wptree&         ptree,
+                                   std::vector<spl::shared_ptr<video_channel>> channels)
+{
+    return spl::make_shared<null_consumer>(ptree.get(L"checksum", false), ptree.get(L"freerun", false));
+}
+
+}} // namespace caspar::core
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "../../fwd.h"
+
+#include <common/memory.h>
+
+#include <boost/property_tree/ptree_fwd.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace caspar { namespace core {
+
+// Accepts frames without doing any I/O. Reports throughput, arrival jitter and, with CHECKSUM, an
+// xxHash64 of the image and audio of every frame. The channel runs at its frame rate unless FREERUN is given, then
+// the NULL consumer is the channel's clock and frames are produced as fast as the channel can.
+spl::shared_ptr<frame_consumer> create_null_consumer(const std::vector<std::wstring>&            params,
+                                                     std::vector<spl::shared_ptr<video_channel>> channels);
+spl::shared_ptr<frame_consumer>
+create_preconfigured_null_consumer(const boost::property_tree::wptree&         ptree,
+                                   std::vector<spl::shared_ptr<video_channel>> channels);
+
+// XXH64, as specified by https://github.com/Cyan4973/xxHash. Assumes a little endian host.
+std::uint64_t xxh64(const void* data, std::size_t size, std::uint64_t seed);
+
+}} // namespace caspar::core
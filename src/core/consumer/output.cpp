@@ -22,7 +22,11 @@
 
 #include "frame_consumer.h"
 
+#include "../frame/audio_delay.h"
+#include "../frame/audio_matrix.h"
 #include "../frame/frame.h"
+#include "../frame/frame_conversion.h"
+#include "../frame/pixel_format.h"
 #include "../monitor/monitor.h"
 #include "../video_format.h"
 
@@ -32,26 +36,166 @@
 
 #include <boost/optional.hpp>
 
+#include <algorithm>
 #include <chrono>
+#include <iterator>
 #include <map>
+#include <memory>
 #include <thread>
+#include <vector>
 
 namespace caspar { namespace core {
 
 typedef decltype(std::chrono::high_resolution_clock::now()) time_point_t;
 
+const_frame to_bgra8(const const_frame& frame)
+{
+    const auto width  = static_cast<int>(frame.width());
+    const auto height = static_cast<int>(frame.height());
+
+    auto desc = pixel_format_desc(pixel_format::bgra);
+    desc.planes.push_back(pixel_format_desc::plane(width, height, 4));
+
+    std::vector<array<const std::uint8_t>> image_data;
+    image_data.push_back(bgra8(frame));
+
+    return const_frame(std::move(image_data), frame.audio_data(), desc);
+}
+
+// Sample buffers for frames built on the tick, reused once no frame holds on to them any more.
+class audio_buffers
+{
+  public:
+    typedef std::shared_ptr<std::vector<int32_t>> buffer_ptr;
+
+    buffer_ptr operator()(std::size_t size)
+    {
+        // Only the pool refers to a buffer that no frame uses, nothing else can start to use it meanwhile.
+        auto it =
+            std::find_if(buffers_.begin(), buffers_.end(), [](const buffer_ptr& b) { return b.use_count() == 1; });
+        if (it == buffers_.end()) {
+            buffers_.push_back(std::make_shared<std::vector<int32_t>>());
+            it = buffers_.end() - 1;
+        }
+        (*it)->resize(size);
+        return *it;
+    }
+
+    void reserve(std::size_t count, std::size_t size)
+    {
+        while (buffers_.size() < count) {
+            buffers_.push_back(std::make_shared<std::vector<int32_t>>());
+            buffers_.back()->reserve(size);
+        }
+    }
+
+  private:
+    std::vector<buffer_ptr> buffers_;
+};
+
+const_frame route_audio(const const_frame& frame, const audio_matrix& matrix, audio_buffers& buffers)
+{
+    const auto& audio  = frame.audio_data();
+    auto        routed = buffers(audio.size());
+    matrix.apply(audio.data(), routed->data(), audio.size() / matrix.channels());
+
+    std::vector<array<const std::uint8_t>> image_data;
+    for (std::size_t n = 0; n < frame.pixel_format_desc().planes.size(); ++n) {
+        image_data.push_back(frame.image_data(n));
+    }
+
+    return const_frame(std::move(image_data),
+                       array<const int32_t>(routed->data(), routed->size(), routed),
+                       frame.pixel_format_desc());
+}
+
+const_frame with_image(const const_frame& frame, const array<const std::uint8_t>& image, int width, int height)
+{
+    auto desc = pixel_format_desc(pixel_format::bgra);
+    desc.planes.push_back(pixel_format_desc::plane(width, height, 4));
+
+    std::vector<array<const std::uint8_t>> image_data;
+    image_data.push_back(image);
+
+    return const_frame(std::move(image_data), frame.audio_data(), desc);
+}
+
+// Delays the audio sent to a consumer. Early audio holds the consumer's images back for whole frames. Everything is
+// allocated when the delay is set, frames can't be changed so their audio is copied into buffers that are reused once
+// no consumer holds on to them any more.
+struct output_delay
+{
+    int                      delay = 0;
+    audio_delay<int32_t>     audio;
+    std::vector<const_frame> frames;
+    std::size_t              pos = 0;
+    audio_buffers            buffers;
+
+    output_delay(int delay, const video_format_desc& format_desc)
+        : delay(delay)
+    {
+        auto split = split_audio_delay(delay, format_desc);
+        audio      = audio_delay<int32_t>(format_desc.audio_channels, split.audio_samples);
+        frames.resize(split.video_frames);
+
+        buffers.reserve(3,
+                        static_cast<std::size_t>(
+                            *std::max_element(format_desc.audio_cadence.begin(), format_desc.audio_cadence.end()) *
+                            format_desc.audio_channels));
+    }
+
+    const_frame operator()(const const_frame& frame)
+    {
+        auto image = frame;
+        if (!frames.empty()) {
+            std::swap(image, frames[pos]);
+            pos = (pos + 1) % frames.size();
+            if (!image) {
+                image = frame;
+            }
+        }
+
+        const auto& input   = frame.audio_data();
+        auto        samples = buffers(input.size());
+        std::copy(input.begin(), input.end(), samples->begin());
+        audio.process(samples->data(), samples->size());
+
+        std::vector<array<const std::uint8_t>> image_data;
+        for (std::size_t n = 0; n < image.pixel_format_desc().planes.size(); ++n) {
+            image_data.push_back(image.image_data(n));
+        }
+
+        return const_frame(std::move(image_data),
+                           array<const int32_t>(samples->data(), samples->size(), samples),
+                           image.pixel_format_desc());
+    }
+};
+
 struct output::impl
 {
     monitor::state                      state_;
     spl::shared_ptr<diagnostics::graph> graph_;
     const int                           channel_index_;
-    video_format_desc                   format_desc_;
+
+    // Only written on the tick, under consumers_mutex_ which other threads hold to read it.
+    video_format_desc format_desc_;
 
     std::mutex                                     consumers_mutex_;
     std::map<int, spl::shared_ptr<frame_consumer>> consumers_;
+    std::map<int, audio_matrix>                    matrices_;
+    std::map<int, int>                             delays_; // Sample frames.
+    bool                                           delays_changed_ = false;
+
+    // The delays in effect, only rebuilt on the tick when delays_ or the format changed.
+    std::map<int, std::shared_ptr<output_delay>> tick_delays_;
+
+    // Routed audio of every consumer with a matrix, only used on the tick.
+    std::map<int, audio_buffers> routed_;
 
     boost::optional<time_point_t> time_;
 
+    array<const std::uint8_t> black_;
+
   public:
     impl(spl::shared_ptr<diagnostics::graph> graph, const video_format_desc& format_desc, int channel_index)
         : graph_(std::move(graph))
@@ -64,9 +208,8 @@ struct output::impl
     {
         remove(index);
 
-        consumer->initialize(format_desc_, channel_index_);
-
         std::lock_guard<std::mutex> lock(consumers_mutex_);
+        consumer->initialize(format_desc_, channel_index_);
         consumers_.emplace(index, std::move(consumer));
     }
 
@@ -79,6 +222,31 @@ struct output::impl
         if (it != consumers_.end()) {
             consumers_.erase(it);
         }
+        matrices_.erase(index);
+        if (delays_.erase(index) > 0) {
+            delays_changed_ = true;
+        }
+    }
+
+    void set_audio_matrix(int index, audio_matrix matrix)
+    {
+        std::lock_guard<std::mutex> lock(consumers_mutex_);
+        if (matrix.empty()) {
+            matrices_.erase(index);
+        } else {
+            matrices_[index] = std::move(matrix);
+        }
+    }
+
+    void set_audio_delay(int index, int delay)
+    {
+        std::lock_guard<std::mutex> lock(consumers_mutex_);
+        if (delay == 0) {
+            delays_.erase(index);
+        } else {
+            delays_[index] = delay;
+        }
+        delays_changed_ = true;
     }
 
     void remove(const spl::shared_ptr<frame_consumer>& consumer) { remove(consumer->index()); }
@@ -89,7 +257,10 @@ struct output::impl
             return;
         }
 
-        if (input_frame.size() != format_desc_.size) {
+        const auto depth      = input_frame.pixel_format_desc().depth;
+        const auto audio_only = input_frame.size() == 0;
+
+        if (!audio_only && input_frame.size() != format_desc_.size * bytes_per_sample(depth)) {
             CASPAR_LOG(warning) << print() << L" Invalid input frame size.";
             return;
         }
@@ -109,45 +280,95 @@ struct output::impl
             }
             format_desc_ = format_desc;
             time_        = boost::none;
+            tick_delays_.clear();
+            delays_changed_ = true;
             return;
         }
 
-        decltype(consumers_) consumers;
+        decltype(consumers_)               consumers;
+        decltype(matrices_)                matrices;
+        boost::optional<decltype(delays_)> delays;
         {
             std::lock_guard<std::mutex> lock(consumers_mutex_);
             consumers = consumers_;
+            matrices  = matrices_;
+            if (delays_changed_) {
+                delays          = delays_;
+                delays_changed_ = false;
+            }
+        }
+
+        if (delays) {
+            update_delays(*delays);
         }
 
         std::map<int, std::future<bool>> futures;
 
-        for (auto it = consumers_.begin(); it != consumers_.end();) {
+        // Consumers that don't handle the channel's depth share one 8 bit copy of the frame.
+        boost::optional<const_frame> frame8;
+
+        for (auto it = consumers.begin(); it != consumers.end();) {
             try {
-                futures.emplace(it->first, it->second->send(input_frame));
+                auto frame = input_frame;
+                if (audio_only) {
+                    if (!it->second->supports_audio_only()) {
+                        if (black_.size() != format_desc_.size) {
+                            black_ = array<const std::uint8_t>(std::vector<std::uint8_t>(format_desc_.size, 0));
+                        }
+                        frame = with_image(input_frame, black_, format_desc_.width, format_desc_.height);
+                    }
+                } else if (!it->second->supports_color_depth(depth)) {
+                    if (!frame8) {
+                        frame8 = to_bgra8(input_frame);
+                    }
+                    frame = *frame8;
+                }
+
+                auto matrix = matrices.find(it->first);
+                if (matrix != matrices.end() && matrix->second.channels() == format_desc_.audio_channels) {
+                    frame = route_audio(frame, matrix->second, routed_[it->first]);
+                } else {
+                    routed_.erase(it->first);
+                }
+
+                auto delay = tick_delays_.find(it->first);
+                if (delay != tick_delays_.end()) {
+                    frame = (*delay->second)(frame);
+                }
+
+                futures.emplace(it->first, it->second->send(frame));
                 ++it;
             } catch (...) {
                 CASPAR_LOG_CURRENT_EXCEPTION();
-                it = consumers_.erase(it);
+                drop(*it);
+                it = consumers.erase(it);
             }
         }
 
         for (auto& p : futures) {
+            auto ok = false;
             try {
-                if (!p.second.get()) {
-                    consumers_.erase(p.first);
-                }
+                ok = p.second.get();
             } catch (...) {
                 CASPAR_LOG_CURRENT_EXCEPTION();
-                consumers_.erase(p.first);
             }
+            if (!ok) {
+                drop(*consumers.find(p.first));
+                consumers.erase(p.first);
+            }
+        }
+
+        for (auto it = routed_.begin(); it != routed_.end();) {
+            it = consumers.count(it->first) > 0 ? std::next(it) : routed_.erase(it);
         }
 
         state_.clear();
-        for (auto& p : consumers_) {
+        for (auto& p : consumers) {
             state_.insert_or_assign("port/" + boost::lexical_cast<std::string>(p.first), p.second->state());
         }
 
         const auto needs_sync = std::all_of(
-            consumers_.begin(), consumers_.end(), [](auto& p) { return !p.second->has_synchronization_clock(); });
+            consumers.begin(), consumers.end(), [](auto& p) { return !p.second->has_synchronization_clock(); });
 
         if (needs_sync) {
             if (!time) {
@@ -161,6 +382,32 @@ struct output::impl
         }
     }
 
+  private:
+    // Drops a consumer that failed on the tick, unless it was replaced meanwhile.
+    void drop(const std::pair<const int, spl::shared_ptr<frame_consumer>>& consumer)
+    {
+        std::lock_guard<std::mutex> lock(consumers_mutex_);
+        auto                        it = consumers_.find(consumer.first);
+        if (it != consumers_.end() && it->second == consumer.second) {
+            consumers_.erase(it);
+        }
+    }
+
+    // Keeps the delays that didn't change, along with the audio and frames they hold.
+    void update_delays(const std::map<int, int>& delays)
+    {
+        std::map<int, std::shared_ptr<output_delay>> result;
+        for (auto& delay : delays) {
+            auto it = tick_delays_.find(delay.first);
+            result.emplace(delay.first,
+                           it != tick_delays_.end() && it->second->delay == delay.second
+                               ? it->second
+                               : std::make_shared<output_delay>(delay.second, format_desc_));
+        }
+        tick_delays_ = std::move(result);
+    }
+
+  public:
     std::wstring print() const { return L"output[" + boost::lexical_cast<std::wstring>(channel_index_) + L"]"; }
 };
 
@@ -173,6 +420,8 @@ void output::add(int index, const spl::shared_ptr<frame_consumer>& consumer) { i
 void output::add(const spl::shared_ptr<frame_consumer>& consumer) { impl_->add(consumer); }
 void output::remove(int index) { impl_->remove(index); }
 void output::remove(const spl::shared_ptr<frame_consumer>& consumer) { impl_->remove(consumer); }
+void output::set_audio_matrix(int index, audio_matrix matrix) { impl_->set_audio_matrix(index, std::move(matrix)); }
+void output::set_audio_delay(int index, int delay) { impl_->set_audio_delay(index, delay); }
 void output::operator()(const_frame frame, const video_format_desc& format_desc)
 {
     return (*impl_)(std::move(frame), format_desc);
@@ -21,6 +21,7 @@
 
 #pragma once
 
+#include "../frame/audio_matrix.h"
 #include "../fwd.h"
 #include "../monitor/monitor.h"
 
@@ -50,6 +51,13 @@ class output final
     void remove(const spl::shared_ptr<frame_consumer>& consumer);
     void remove(int index);
 
+    // Routes the audio sent to the consumer at index, until it is removed. An empty matrix stops routing.
+    void set_audio_matrix(int index, audio_matrix matrix);
+
+    // Delays the audio sent to the consumer at index by delay sample frames, until it is removed. When delay is
+    // negative the audio is early and the consumer's video is held back for whole frames instead.
+    void set_audio_delay(int index, int delay);
+
     const monitor::state& state() const;
 
   private:
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "../StdAfx.h"
+
+#include "audio_delay.h"
+
+#include "../video_format.h"
+
+#include <common/except.h>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <cmath>
+
+namespace caspar { namespace core {
+
+av_delay split_audio_delay(int delay, const video_format_desc& format_desc)
+{
+    av_delay result;
+    if (delay >= 0) {
+        result.audio_samples = delay;
+        return result;
+    }
+
+    const auto samples_per_frame = format_desc.audio_sample_rate / format_desc.fps;
+    result.video_frames          = static_cast<int>(std::ceil(-delay / samples_per_frame));
+    result.audio_samples         = static_cast<int>(std::lround(result.video_frames * samples_per_frame)) + delay;
+    result.audio_samples         = std::max(result.audio_samples, 0);
+    return result;
+}
+
+int parse_audio_delay(const std::wstring& value, int sample_rate)
+{
+    auto number  = boost::trim_copy(value);
+    auto samples = boost::iends_with(number, L"samples");
+    if (samples) {
+        number.resize(number.size() - 7);
+    } else if (boost::iends_with(number, L"ms")) {
+        number.resize(number.size() - 2);
+    }
+
+    double delay;
+    try {
+        delay = boost::lexical_cast<double>(boost::trim_copy(number));
+    } catch (const boost::bad_lexical_cast&) {
+        CASPAR_THROW_EXCEPTION(user_error() << msg_info(L"Invalid audio delay: " + value));
+    }
+
+    // Checked before the conversion to int, the delay lines are allocated for this many sample frames.
+    const auto frames = samples ? delay : delay * sample_rate / 1000.0;
+    if (!(std::abs(frames) <= max_audio_delay_seconds * static_cast<double>(sample_rate))) {
+        CASPAR_THROW_EXCEPTION(user_error() << msg_info(L"Audio delay out of range: " + value));
+    }
+    return static_cast<int>(std::lround(frames));
+}
+
+}} // namespace caspar::core
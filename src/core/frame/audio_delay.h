@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace caspar { namespace core {
+
+struct video_format_desc;
+
+// Delays interleaved audio by a fixed number of sample frames. The ring buffer is allocated when the delay is created
+// and process only swaps samples through it.
+template <typename T>
+class audio_delay final
+{
+  public:
+    audio_delay() = default;
+    audio_delay(int channels, int delay)
+        : channels_(channels)
+        , delay_(delay)
+        , buffer_(static_cast<std::size_t>(channels) * std::max(delay, 0))
+    {
+    }
+
+    // Replaces samples with the ones from delay sample frames earlier. size must be a multiple of the channel count.
+    void process(T* samples, std::size_t size)
+    {
+        if (buffer_.empty()) {
+            return;
+        }
+        for (std::size_t n = 0; n < size;) {
+            const auto count = std::min(size - n, buffer_.size() - pos_);
+            std::swap_ranges(samples + n, samples + n + count, buffer_.data() + pos_);
+            n += count;
+            pos_ = (pos_ + count) % buffer_.size();
+        }
+    }
+
+    int channels() const { return channels_; }
+    int delay() const { return delay_; }
+
+  private:
+    int            channels_ = 0;
+    int            delay_    = 0;
+    std::vector<T> buffer_;
+    std::size_t    pos_ = 0;
+};
+
+// A delay of audio against video, split into what each of them is held back. Video can only be held for whole frames,
+// so audio that is early holds the video and delays the audio by the rest.
+struct av_delay
+{
+    int video_frames  = 0;
+    int audio_samples = 0;
+};
+
+// delay is in sample frames and negative when audio is to be early.
+av_delay split_audio_delay(int delay, const video_format_desc& format_desc);
+
+const int max_audio_delay_seconds = 10;
+
+// Parses a delay in ms, or in sample frames with the suffix "samples", either of which may be negative. Throws
+// user_error for delays longer than max_audio_delay_seconds either way.
+int parse_audio_delay(const std::wstring& value, int sample_rate);
+
+}} // namespace caspar::core
@@ -0,0 +1,348 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "../StdAfx.h"
+
+#include "audio_matrix.h"
+
+#include <common/except.h>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/lexical_cast.hpp>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <smmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+namespace caspar { namespace core {
+
+namespace {
+
+// Routes two sample frames at a time with their accumulators held in registers, which also shares the column loads.
+template <int Vectors, typename Output>
+void route(const std::vector<int>& inputs,
+           const float*            columns,
+           const int32_t*          src,
+           int                     channels,
+           std::size_t             nb_samples,
+           Output&&                output)
+{
+    alignas(16) float frames[2][Vectors * 4];
+    alignas(16) float routed[2][Vectors * 4];
+
+    for (std::size_t n = 0; n < nb_samples; n += 2) {
+        const auto count = std::min<std::size_t>(nb_samples - n, 2);
+
+        for (std::size_t f = 0; f < 2; ++f) {
+            const auto in = src + (n + f % count) * channels;
+            for (auto i = 0; i < channels; ++i) {
+                frames[f][i] = static_cast<float>(in[i]);
+            }
+        }
+
+        __m128 acc0[Vectors];
+        __m128 acc1[Vectors];
+        for (auto v = 0; v < Vectors; ++v) {
+            acc0[v] = _mm_setzero_ps();
+            acc1[v] = _mm_setzero_ps();
+        }
+
+        auto column = columns;
+        for (auto input : inputs) {
+            const auto x0 = _mm_load1_ps(frames[0] + input);
+            const auto x1 = _mm_load1_ps(frames[1] + input);
+            for (auto v = 0; v < Vectors; ++v) {
+                const auto gains = _mm_loadu_ps(column + v * 4);
+                acc0[v]          = _mm_add_ps(acc0[v], _mm_mul_ps(x0, gains));
+                acc1[v]          = _mm_add_ps(acc1[v], _mm_mul_ps(x1, gains));
+            }
+            column += Vectors * 4;
+        }
+
+        for (auto v = 0; v < Vectors; ++v) {
+            _mm_store_ps(routed[0] + v * 4, acc0[v]);
+            _mm_store_ps(routed[1] + v * 4, acc1[v]);
+        }
+
+        for (std::size_t f = 0; f < count; ++f) {
+            output(routed[f], (n + f) * channels);
+        }
+    }
+}
+
+// For every sample frame, output is called with the routed frame padded to whole vectors.
+template <typename Output>
+void route(int                       channels,
+           const std::vector<int>&   inputs,
+           const std::vector<float>& columns,
+           const int32_t*            src,
+           std::size_t               nb_samples,
+           Output&&                  output)
+{
+    const auto vectors = (channels + 3) / 4;
+
+    switch (vectors) {
+        case 1:
+            return route<1>(inputs, columns.data(), src, channels, nb_samples, output);
+        case 2:
+            return route<2>(inputs, columns.data(), src, channels, nb_samples, output);
+        case 3:
+            return route<3>(inputs, columns.data(), src, channels, nb_samples, output);
+        case 4:
+            return route<4>(inputs, columns.data(), src, channels, nb_samples, output);
+    }
+
+    std::vector<float> routed(vectors * 4);
+    for (std::size_t n = 0; n < nb_samples; ++n) {
+        const auto in = src + n * channels;
+        for (auto v = 0; v < vectors; ++v) {
+            auto acc    = _mm_setzero_ps();
+            auto column = columns.data() + v * 4;
+            for (auto input : inputs) {
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(static_cast<float>(in[input])), _mm_loadu_ps(column)));
+                column += vectors * 4;
+            }
+            _mm_storeu_ps(routed.data() + v * 4, acc);
+        }
+
+        output(routed.data(), n * channels);
+    }
+}
+
+} // namespace
+
+audio_matrix::audio_matrix(int channels)
+    : channels_(channels)
+    , gains_(channels * channels, 0.0f)
+{
+    pack();
+}
+
+void audio_matrix::set_gain(int output, int input, float gain)
+{
+    gains_[output * channels_ + input] = gain;
+    pack();
+}
+
+void audio_matrix::pack()
+{
+    const auto vectors = (channels_ + 3) / 4;
+
+    inputs_.clear();
+    columns_.clear();
+    for (auto i = 0; i < channels_; ++i) {
+        const auto start = columns_.size();
+        columns_.resize(start + vectors * 4, 0.0f);
+
+        auto used = false;
+        for (auto o = 0; o < channels_; ++o) {
+            columns_[start + o] = gains_[o * channels_ + i];
+            used |= columns_[start + o] != 0.0f;
+        }
+
+        if (used) {
+            inputs_.push_back(i);
+        } else {
+            columns_.resize(start);
+        }
+    }
+}
+
+audio_matrix audio_matrix::identity(int channels)
+{
+    audio_matrix result(channels);
+    for (auto n = 0; n < channels; ++n) {
+        result.gains_[n * channels + n] = 1.0f;
+    }
+    result.pack();
+    return result;
+}
+
+void audio_matrix::apply(const int32_t* src, float* dest, std::size_t nb_samples) const
+{
+    route(channels_, inputs_, columns_, src, nb_samples, [&](const float* routed, std::size_t offset) {
+        std::memcpy(dest + offset, routed, channels_ * sizeof(float));
+    });
+}
+
+void audio_matrix::apply(const int32_t* src, int32_t* dest, std::size_t nb_samples) const
+{
+    // cvtps returns INT_MIN for anything out of range, positive overflow is flipped to INT_MAX.
+    const auto limit = _mm_set1_ps(2147483648.0f);
+
+    route(channels_, inputs_, columns_, src, nb_samples, [&](const float* routed, std::size_t offset) {
+        for (auto n = 0; n < channels_; n += 4) {
+            auto xmm0 = _mm_loadu_ps(routed + n);
+            auto xmm1 = _mm_xor_si128(_mm_cvtps_epi32(xmm0), _mm_castps_si128(_mm_cmpge_ps(xmm0, limit)));
+            if (n + 4 <= channels_) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + offset + n), xmm1);
+            } else {
+                alignas(16) int32_t converted[4];
+                _mm_store_si128(reinterpret_cast<__m128i*>(converted), xmm1);
+                std::memcpy(dest + offset + n, converted, (channels_ - n) * sizeof(int32_t));
+            }
+        }
+    });
+}
+
+audio_matrix& audio_matrix::operator*=(const audio_matrix& other)
+{
+    if (other.empty() || (!empty() && channels_ != other.channels_)) {
+        return *this;
+    }
+
+    if (empty()) {
+        return *this = other;
+    }
+
+    audio_matrix result(channels_);
+    for (auto o = 0; o < channels_; ++o) {
+        for (auto i = 0; i < channels_; ++i) {
+            auto gain = 0.0f;
+            for (auto k = 0; k < channels_; ++k) {
+                gain += this->gain(o, k) * other.gain(k, i);
+            }
+            result.gains_[o * channels_ + i] = gain;
+        }
+    }
+    result.pack();
+    return *this = std::move(result);
+}
+
+audio_matrix audio_matrix::operator*(const audio_matrix& other) const { return audio_matrix(*this) *= other; }
+
+std::wstring audio_matrix::print() const
+{
+    if (empty()) {
+        return L"identity";
+    }
+
+    std::wstringstream result;
+    for (auto o = 0; o < channels_; ++o) {
+        for (auto i = 0; i < channels_; ++i) {
+            if (gain(o, i) != 0.0f) {
+                result << (result.tellp() > 0 ? L" " : L"") << o + 1 << L":" << i + 1 << L":" << gain(o, i);
+            }
+        }
+    }
+    return result.str();
+}
+
+bool operator==(const audio_matrix& lhs, const audio_matrix& rhs)
+{
+    if (lhs.channels() != rhs.channels()) {
+        return false;
+    }
+    for (auto o = 0; o < lhs.channels(); ++o) {
+        for (auto i = 0; i < lhs.channels(); ++i) {
+            if (lhs.gain(o, i) != rhs.gain(o, i)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool operator!=(const audio_matrix& lhs, const audio_matrix& rhs) { return !(lhs == rhs); }
+
+audio_matrix create_audio_matrix(const std::vector<std::wstring>& params, int channels)
+{
+    const auto& name = params.empty() ? std::wstring(L"identity") : params.at(0);
+
+    if (boost::iequals(name, L"identity")) {
+        return audio_matrix();
+    }
+
+    if (boost::iequals(name, L"mono") || boost::iequals(name, L"swap")) {
+        auto result = audio_matrix::identity(channels);
+        if (channels >= 2) {
+            const auto same  = boost::iequals(name, L"mono") ? 0.5f : 0.0f;
+            const auto other = boost::iequals(name, L"mono") ? 0.5f : 1.0f;
+            result.set_gain(0, 0, same);
+            result.set_gain(1, 1, same);
+            result.set_gain(0, 1, other);
+            result.set_gain(1, 0, other);
+        }
+        return result;
+    }
+
+    if (boost::iequals(name, L"stereo-to-5.1") || boost::iequals(name, L"5.1-to-stereo")) {
+        if (channels < 6) {
+            CASPAR_THROW_EXCEPTION(user_error() << msg_info(name + L" needs at least 6 channels."));
+        }
+
+        // L R C LFE Ls Rs. The downmix follows ITU-R BS.775, the upmix feeds the centre and surrounds from the front.
+        auto result = audio_matrix::identity(channels);
+        for (auto o = 0; o < 6; ++o) {
+            result.set_gain(o, o, 0.0f);
+        }
+        if (boost::iequals(name, L"stereo-to-5.1")) {
+            result.set_gain(0, 0, 1.0f);
+            result.set_gain(1, 1, 1.0f);
+            result.set_gain(2, 0, 0.5f);
+            result.set_gain(2, 1, 0.5f);
+            result.set_gain(4, 0, 0.707f);
+            result.set_gain(5, 1, 0.707f);
+        } else {
+            result.set_gain(0, 0, 1.0f);
+            result.set_gain(0, 2, 0.707f);
+            result.set_gain(0, 4, 0.707f);
+            result.set_gain(1, 1, 1.0f);
+            result.set_gain(1, 2, 0.707f);
+            result.set_gain(1, 5, 0.707f);
+        }
+        return result;
+    }
+
+    audio_matrix result(channels);
+    for (auto& param : params) {
+        std::vector<std::wstring> cell;
+        boost::split(cell, param, [](wchar_t c) { return c == L':'; });
+
+        auto output = -1;
+        auto input  = -1;
+        auto gain   = 1.0f;
+        try {
+            if (cell.size() == 2 || cell.size() == 3) {
+                output = boost::lexical_cast<int>(cell.at(0)) - 1;
+                input  = boost::lexical_cast<int>(cell.at(1)) - 1;
+                gain   = cell.size() == 3 ? boost::lexical_cast<float>(cell.at(2)) : 1.0f;
+            }
+        } catch (const boost::bad_lexical_cast&) {
+            output = -1;
+        }
+
+        if (output < 0 || output >= channels || input < 0 || input >= channels) {
+            CASPAR_THROW_EXCEPTION(user_error() << msg_info(L"Invalid audio routing: " + param));
+        }
+
+        result.set_gain(output, input, gain);
+    }
+    return result;
+}
+
+}} // namespace caspar::core
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace caspar { namespace core {
+
+// Routes interleaved audio between channels of the same count. Output channel o is the sum over the input
+// channels i of input i times gain(o, i). An empty matrix passes audio through unchanged.
+class audio_matrix final
+{
+  public:
+    audio_matrix() = default;
+    explicit audio_matrix(int channels); // Silent, every gain is 0.
+
+    static audio_matrix identity(int channels);
+
+    bool  empty() const { return channels_ == 0; }
+    int   channels() const { return channels_; }
+    float gain(int output, int input) const { return gains_[output * channels_ + input]; }
+    void  set_gain(int output, int input, float gain);
+
+    // Routes nb_samples sample frames from src to dest, which must not overlap. The int32 version saturates.
+    void apply(const int32_t* src, float* dest, std::size_t nb_samples) const;
+    void apply(const int32_t* src, int32_t* dest, std::size_t nb_samples) const;
+
+    // Applies other first and then this. Matrices of different channel counts don't compose, the result is this.
+    audio_matrix& operator*=(const audio_matrix& other);
+    audio_matrix  operator*(const audio_matrix& other) const;
+
+    // Non-zero gains as output:input:gain with channels counted from 1, or "identity" when empty.
+    std::wstring print() const;
+
+  private:
+    void pack();
+
+    int                channels_ = 0;
+    std::vector<float> gains_;
+
+    // Columns of the inputs that reach any output, padded to whole vectors. Packed whenever a gain changes, so that
+    // apply only routes.
+    std::vector<int>   inputs_;
+    std::vector<float> columns_;
+};
+
+bool operator==(const audio_matrix& lhs, const audio_matrix& rhs);
+bool operator!=(const audio_matrix& lhs, const audio_matrix& rhs);
+
+// Creates a matrix for a channel count from a preset or from output:input[:gain] cells, channels counted from 1.
+// Presets are identity, mono (the first two channels carry their sum), swap (the first two channels trade places),
+// stereo-to-5.1 and 5.1-to-stereo, in any case. Channels that a preset doesn't touch pass through, cells only route
+// what they name.
+audio_matrix create_audio_matrix(const std::vector<std::wstring>& params, int channels);
+
+}} // namespace caspar::core
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../StdAfx.h"
+
+#include "field_weave.h"
+
+#include "frame.h"
+#include "pixel_format.h"
+
+#include <common/except.h>
+
+#include <tbb/concurrent_queue.h>
+#include <tbb/parallel_for.h>
+#include <tbb/scalable_allocator.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <emmintrin.h>
+#endif
+
+#include <cstring>
+#include <map>
+#include <mutex>
+
+namespace caspar { namespace core {
+
+namespace {
+
+std::shared_ptr<void> alloc_pooled(std::size_t size)
+{
+    struct pool
+    {
+        tbb::concurrent_queue<void*> buffers;
+
+        ~pool()
+        {
+            void* ptr;
+            while (buffers.try_pop(ptr)) {
+                scalable_aligned_free(ptr);
+            }
+        }
+    };
+
+    static std::mutex                                   mutex;
+    static std::map<std::size_t, std::shared_ptr<pool>> pools;
+
+    std::shared_ptr<pool> p;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto& entry = pools[size];
+        if (!entry) {
+            entry = std::make_shared<pool>();
+        }
+        p = entry;
+    }
+
+    void* ptr = nullptr;
+    if (!p->buffers.try_pop(ptr)) {
+        ptr = scalable_aligned_malloc(size, 64);
+        if (!ptr) {
+            CASPAR_THROW_EXCEPTION(bad_alloc());
+        }
+    }
+
+    return std::shared_ptr<void>(ptr, [p](void* ptr) { p->buffers.push(ptr); });
+}
+
+} // namespace
+
+void weave_fields(std::uint8_t*       dest,
+                  const std::uint8_t* upper,
+                  const std::uint8_t* lower,
+                  std::size_t         linesize,
+                  std::size_t         height)
+{
+    const auto streaming = reinterpret_cast<std::uintptr_t>(dest) % 16 == 0 && linesize % 16 == 0;
+
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, height, 16), [&](const tbb::blocked_range<std::size_t>& r) {
+        for (auto y = r.begin(); y < r.end(); ++y) {
+            const auto src = (y % 2 == 0 ? upper : lower) + y * linesize;
+            const auto dst = dest + y * linesize;
+
+            if (!streaming) {
+                std::memcpy(dst, src, linesize);
+                continue;
+            }
+
+            auto src128 = reinterpret_cast<const __m128i*>(src);
+            auto dst128 = reinterpret_cast<__m128i*>(dst);
+
+            for (std::size_t n = 0; n < linesize / 16; ++n) {
+                _mm_stream_si128(dst128 + n, _mm_loadu_si128(src128 + n));
+            }
+        }
+        _mm_sfence();
+    });
+}
+
+std::shared_ptr<void> weave_fields(const const_frame& upper, const const_frame& lower)
+{
+    if (upper.image_data(0).size() != lower.image_data(0).size()) {
+        CASPAR_THROW_EXCEPTION(invalid_argument() << msg_info("Fields must be of equal size."));
+    }
+
+    const auto linesize = upper.pixel_format_desc().planes.at(0).linesize;
+    const auto height   = upper.pixel_format_desc().planes.at(0).height;
+
+    auto dest = alloc_pooled(upper.image_data(0).size());
+    weave_fields(reinterpret_cast<std::uint8_t*>(dest.get()),
+                 upper.image_data(0).data(),
+                 lower.image_data(0).data(),
+                 linesize,
+                 height);
+    return dest;
+}
+
+}} // namespace caspar::core
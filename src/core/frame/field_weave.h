@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace caspar { namespace core {
+
+// Interleaves two progressive pictures into one interlaced picture, even rows from upper and odd rows
+// from lower. Rows are copied in parallel bands with non-temporal stores when dest is 16 byte aligned.
+void weave_fields(std::uint8_t*       dest,
+                  const std::uint8_t* upper,
+                  const std::uint8_t* lower,
+                  std::size_t         linesize,
+                  std::size_t         height);
+
+// Weaves the first image plane of two frames into a buffer from a pool of equally sized buffers.
+std::shared_ptr<void> weave_fields(const class const_frame& upper, const class const_frame& lower);
+
+}} // namespace caspar::core
@@ -20,6 +20,7 @@
  */
 #include "frame.h"
 
+#include "frame_factory.h"
 #include "geometry.h"
 #include "pixel_format.h"
 
@@ -35,6 +36,10 @@
 
 #include <cstdint>
 #include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
 #include <vector>
 
 #include <boost/lexical_cast.hpp>
@@ -100,6 +105,10 @@ struct const_frame::impl
     core::pixel_format_desc                desc_     = pixel_format::invalid;
     frame_geometry                         geometry_ = frame_geometry::get_default();
     boost::any                             opaque_;
+    const void*                            tag_ = nullptr;
+
+    std::mutex                                            cache_mutex_;
+    std::map<std::string, std::shared_future<boost::any>> cache_;
 
     impl(std::vector<array<const std::uint8_t>> image_data,
          array<const std::int32_t>              audio_data,
@@ -131,6 +140,7 @@ struct const_frame::impl
         , audio_data_(std::move(other.impl_->audio_data_))
         , desc_(std::move(other.impl_->desc_))
         , geometry_(std::move(other.impl_->geometry_))
+        , tag_(other.impl_->tag_)
     {
         if (desc_.planes.size() != image_data_.size()) {
             CASPAR_THROW_EXCEPTION(invalid_argument());
@@ -147,6 +157,37 @@ struct const_frame::impl
     std::size_t height() const { return desc_.planes.at(0).height; }
 
     std::size_t size() const { return desc_.planes.at(0).size; }
+
+    const boost::any& cache(const std::string& key, const std::function<boost::any()>& factory)
+    {
+        std::promise<boost::any>       promise;
+        std::shared_future<boost::any> future;
+        bool                           owner = false;
+        {
+            std::lock_guard<std::mutex> lock(cache_mutex_);
+
+            auto it = cache_.find(key);
+            if (it != cache_.end()) {
+                future = it->second;
+            } else {
+                future = promise.get_future().share();
+                owner  = true;
+                cache_.emplace(key, future);
+            }
+        }
+
+        // The factory runs outside of the lock so that different representations can be created
+        // concurrently. Anyone else asking for the same key waits on the future.
+        if (owner) {
+            try {
+                promise.set_value(factory());
+            } catch (...) {
+                promise.set_exception(std::current_exception());
+            }
+        }
+
+        return future.get();
+    }
 };
 
 const_frame::const_frame() {}
@@ -182,5 +223,22 @@ std::size_t                      const_frame::height() const { return impl_->hei
 std::size_t                      const_frame::size() const { return impl_->size(); }
 const frame_geometry&            const_frame::geometry() const { return impl_->geometry_; }
 const boost::any&                const_frame::opaque() const { return impl_->opaque_; }
+const void*                      const_frame::stream_tag() const { return impl_->tag_; }
+const boost::any& const_frame::cache(const std::string& key, const std::function<boost::any()>& factory) const
+{
+    if (!impl_) {
+        CASPAR_THROW_EXCEPTION(invalid_operation() << msg_info("Cannot cache representations of an empty frame."));
+    }
+    return impl_->cache(key, factory);
+}
 const_frame::operator bool() const { return impl_ != nullptr && impl_->desc_.format != core::pixel_format::invalid; }
+
+mutable_frame cpu_frame_factory::create_frame(const void* tag, const core::pixel_format_desc& desc)
+{
+    std::vector<array<std::uint8_t>> image_data;
+    for (auto& plane : desc.planes) {
+        image_data.emplace_back(plane.size);
+    }
+    return mutable_frame(tag, std::move(image_data), array<int32_t>{}, desc);
+}
 }} // namespace caspar::core
@@ -8,6 +8,7 @@
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace caspar { namespace core {
@@ -82,8 +83,16 @@ class const_frame final
 
     const boost::any& opaque() const;
 
+    // The tag the frame was created with, identifies the stream it belongs to. nullptr for frames not created
+    // through a frame_factory.
+    const void* stream_tag() const;
+
     const class frame_geometry& geometry() const;
 
+    // Returns a representation derived from this frame, e.g. a different pixel or sample format.
+    // factory runs at most once per key and the result is shared by everyone holding the frame.
+    const boost::any& cache(const std::string& key, const std::function<boost::any()>& factory) const;
+
     bool operator==(const const_frame& other) const;
     bool operator!=(const const_frame& other) const;
     bool operator<(const const_frame& other) const;
@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../StdAfx.h"
+
+#include "frame_conversion.h"
+
+#include "frame.h"
+#include "pixel_format.h"
+
+#include <common/except.h>
+
+#include <tbb/parallel_for.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <tmmintrin.h>
+#endif
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace caspar { namespace core {
+
+namespace {
+
+// BT.709 limited range coefficients for 10 bit output, 16.16 fixed point.
+const int y_r = 47864, y_g = 161016, y_b = 16255;
+const int cb_r = -26383, cb_g = -88755, cb_b = 115138;
+const int cr_r = 115138, cr_g = -104580, cr_b = -10558;
+
+// The same for 16 bit input, 8.24 fixed point.
+const std::int64_t y16_r = 47678, y16_g = 160390, y16_b = 16192;
+const std::int64_t cb16_r = -26280, cb16_g = -88410, cb16_b = 114690;
+const std::int64_t cr16_r = 114690, cr16_g = -104173, cr16_b = -10517;
+
+void check_bgra(const const_frame& frame)
+{
+    if (frame.pixel_format_desc().format != pixel_format::bgra) {
+        CASPAR_THROW_EXCEPTION(not_supported() << msg_info("Expected bgra frame."));
+    }
+}
+
+// Converts one row of BGRA to 10 bit Y, Cb and Cr. Chroma is sited between each pair of pixels.
+void bgra_to_ycbcr10(const std::uint8_t* src, int width, std::uint16_t* y, std::uint16_t* cb, std::uint16_t* cr)
+{
+    for (auto x = 0; x < width; ++x) {
+        const int b = src[x * 4 + 0];
+        const int g = src[x * 4 + 1];
+        const int r = src[x * 4 + 2];
+        y[x]        = static_cast<std::uint16_t>((y_r * r + y_g * g + y_b * b + (64 << 16) + (1 << 15)) >> 16);
+    }
+
+    for (auto x = 0; x < (width + 1) / 2; ++x) {
+        const auto n = std::min(x * 2 + 1, width - 1);
+        const int  b = src[x * 8 + 0] + src[n * 4 + 0];
+        const int  g = src[x * 8 + 1] + src[n * 4 + 1];
+        const int  r = src[x * 8 + 2] + src[n * 4 + 2];
+        cb[x]        = static_cast<std::uint16_t>((cb_r * r + cb_g * g + cb_b * b + (512 << 17) + (1 << 16)) >> 17);
+        cr[x]        = static_cast<std::uint16_t>((cr_r * r + cr_g * g + cr_b * b + (512 << 17) + (1 << 16)) >> 17);
+    }
+}
+
+// As bgra_to_ycbcr10, for rows of 16 bit samples.
+void bgra16_to_ycbcr10(const std::uint16_t* src, int width, std::uint16_t* y, std::uint16_t* cb, std::uint16_t* cr)
+{
+    for (auto x = 0; x < width; ++x) {
+        const std::int64_t b = src[x * 4 + 0];
+        const std::int64_t g = src[x * 4 + 1];
+        const std::int64_t r = src[x * 4 + 2];
+        y[x] = static_cast<std::uint16_t>((y16_r * r + y16_g * g + y16_b * b + (64ll << 24) + (1ll << 23)) >> 24);
+    }
+
+    for (auto x = 0; x < (width + 1) / 2; ++x) {
+        const auto         n = std::min(x * 2 + 1, width - 1);
+        const std::int64_t b = src[x * 8 + 0] + src[n * 4 + 0];
+        const std::int64_t g = src[x * 8 + 1] + src[n * 4 + 1];
+        const std::int64_t r = src[x * 8 + 2] + src[n * 4 + 2];
+        cb[x] = static_cast<std::uint16_t>((cb16_r * r + cb16_g * g + cb16_b * b + (512ll << 25) + (1ll << 24)) >> 25);
+        cr[x] = static_cast<std::uint16_t>((cr16_r * r + cr16_g * g + cr16_b * b + (512ll << 25) + (1ll << 24)) >> 25);
+    }
+}
+
+template <typename F>
+void for_each_ycbcr10_row(const const_frame& frame, F&& func)
+{
+    check_bgra(frame);
+
+    const auto width  = static_cast<int>(frame.width());
+    const auto height = static_cast<int>(frame.height());
+    const auto depth  = frame.pixel_format_desc().depth;
+    const auto src    = frame.image_data(0).data();
+
+    tbb::parallel_for(tbb::blocked_range<int>(0, height), [&](const tbb::blocked_range<int>& r) {
+        std::vector<std::uint16_t> y(width);
+        std::vector<std::uint16_t> cb((width + 1) / 2);
+        std::vector<std::uint16_t> cr((width + 1) / 2);
+
+        for (auto row = r.begin(); row < r.end(); ++row) {
+            if (depth == color_depth::sixteen) {
+                bgra16_to_ycbcr10(reinterpret_cast<const std::uint16_t*>(src) + row * width * 4,
+                                  width,
+                                  y.data(),
+                                  cb.data(),
+                                  cr.data());
+            } else {
+                bgra_to_ycbcr10(src + row * width * 4, width, y.data(), cb.data(), cr.data());
+            }
+            func(row, y.data(), cb.data(), cr.data());
+        }
+    });
+}
+
+template <typename T>
+array<const T> to_array(std::vector<T>&& data)
+{
+    return array<T>(std::move(data));
+}
+
+template <typename T>
+array<const T> cached(const const_frame& frame, const std::string& key, std::function<array<const T>()> factory)
+{
+    return boost::any_cast<array<const T>>(frame.cache(key, [&] { return boost::any(factory()); }));
+}
+
+} // namespace
+
+int v210_linesize(int width) { return (width + 47) / 48 * 128; }
+
+array<const std::uint8_t> bgra8(const const_frame& frame)
+{
+    check_bgra(frame);
+
+    if (frame.pixel_format_desc().depth == color_depth::eight) {
+        return frame.image_data(0);
+    }
+
+    return cached<std::uint8_t>(frame, "bgra8", [&] {
+        const auto size = frame.image_data(0).size() / 2;
+        const auto src  = reinterpret_cast<const std::uint16_t*>(frame.image_data(0).data());
+
+        auto dest = std::vector<std::uint8_t>(size);
+
+        // v / 257 rounded to nearest, i.e. ((v * 65281 >> 16) + 128) >> 8, which is exact for all 16 bit values.
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, size / 16), [&](const tbb::blocked_range<std::size_t>& r) {
+            const auto scale = _mm_set1_epi16(static_cast<short>(65281));
+            const auto half  = _mm_set1_epi16(128);
+            for (auto n = r.begin(); n < r.end(); ++n) {
+                auto xmm0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src) + n * 2 + 0);
+                auto xmm1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src) + n * 2 + 1);
+                xmm0      = _mm_srli_epi16(_mm_add_epi16(_mm_mulhi_epu16(xmm0, scale), half), 8);
+                xmm1      = _mm_srli_epi16(_mm_add_epi16(_mm_mulhi_epu16(xmm1, scale), half), 8);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dest.data()) + n, _mm_packus_epi16(xmm0, xmm1));
+            }
+        });
+
+        for (auto n = size / 16 * 16; n < size; ++n) {
+            dest[n] = static_cast<std::uint8_t>(((src[n] * 65281u >> 16) + 128) >> 8);
+        }
+
+        return to_array(std::move(dest));
+    });
+}
+
+array<const std::uint8_t> key_only(const const_frame& frame)
+{
+    return cached<std::uint8_t>(frame, "key-only", [&] {
+        const auto image = bgra8(frame);
+        const auto size  = image.size();
+        const auto src   = image.data();
+
+        auto dest = std::vector<std::uint8_t>(size);
+
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, size / 16), [&](const tbb::blocked_range<std::size_t>& r) {
+            const auto mask = _mm_set_epi32(0x0F0F0F0F, 0x0B0B0B0B, 0x07070707, 0x03030303);
+            for (auto n = r.begin(); n < r.end(); ++n) {
+                auto xmm0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src) + n);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dest.data()) + n, _mm_shuffle_epi8(xmm0, mask));
+            }
+        });
+
+        for (auto n = size / 16 * 16; n < size; n += 4) {
+            std::memset(dest.data() + n, src[n + 3], 4);
+        }
+
+        return to_array(std::move(dest));
+    });
+}
+
+array<const std::uint8_t> uyvy(const const_frame& frame)
+{
+    return cached<std::uint8_t>(frame, "uyvy", [&] {
+        const auto pairs    = (static_cast<int>(frame.width()) + 1) / 2;
+        const auto linesize = pairs * 4;
+
+        auto dest = std::vector<std::uint8_t>(linesize * frame.height());
+
+        for_each_ycbcr10_row(frame, [&](int row, const std::uint16_t* y, const std::uint16_t* cb, const std::uint16_t* cr) {
+            auto out   = dest.data() + row * linesize;
+            auto width = static_cast<int>(frame.width());
+            for (auto x = 0; x < pairs; ++x) {
+                out[x * 4 + 0] = static_cast<std::uint8_t>((cb[x] + 2) >> 2);
+                out[x * 4 + 1] = static_cast<std::uint8_t>((y[x * 2] + 2) >> 2);
+                out[x * 4 + 2] = static_cast<std::uint8_t>((cr[x] + 2) >> 2);
+                out[x * 4 + 3] = static_cast<std::uint8_t>((y[std::min(x * 2 + 1, width - 1)] + 2) >> 2);
+            }
+        });
+
+        return to_array(std::move(dest));
+    });
+}
+
+array<const std::uint16_t> yuv422p10(const const_frame& frame)
+{
+    return cached<std::uint16_t>(frame, "yuv422p10", [&] {
+        const auto width   = static_cast<int>(frame.width());
+        const auto height  = static_cast<int>(frame.height());
+        const auto c_width = (width + 1) / 2;
+        const auto y_size  = width * height;
+        const auto c_size  = c_width * height;
+
+        auto dest = std::vector<std::uint16_t>(y_size + c_size * 2);
+
+        for_each_ycbcr10_row(frame, [&](int row, const std::uint16_t* y, const std::uint16_t* cb, const std::uint16_t* cr) {
+            std::memcpy(dest.data() + row * width, y, width * sizeof(std::uint16_t));
+            std::memcpy(dest.data() + y_size + row * c_width, cb, c_width * sizeof(std::uint16_t));
+            std::memcpy(dest.data() + y_size + c_size + row * c_width, cr, c_width * sizeof(std::uint16_t));
+        });
+
+        return to_array(std::move(dest));
+    });
+}
+
+array<const std::uint32_t> v210(const const_frame& frame)
+{
+    return cached<std::uint32_t>(frame, "v210", [&] {
+        const auto width    = static_cast<int>(frame.width());
+        const auto linesize = v210_linesize(width) / 4;
+
+        auto dest = std::vector<std::uint32_t>(linesize * frame.height());
+
+        for_each_ycbcr10_row(frame, [&](int row, const std::uint16_t* y, const std::uint16_t* cb, const std::uint16_t* cr) {
+            auto out = dest.data() + row * linesize;
+
+            // Every group of 6 pixels is packed into 4 words. A partial last group repeats the last pixel.
+            auto Y  = [&](int x) -> std::uint32_t { return y[std::min(x, width - 1)]; };
+            auto Cb = [&](int x) -> std::uint32_t { return cb[std::min(x, (width - 1) / 2)]; };
+            auto Cr = [&](int x) -> std::uint32_t { return cr[std::min(x, (width - 1) / 2)]; };
+
+            for (auto x = 0; x < width; x += 6, out += 4) {
+                const auto c = x / 2;
+                out[0]       = Cb(c + 0) | Y(x + 0) << 10 | Cr(c + 0) << 20;
+                out[1]       = Y(x + 1) | Cb(c + 1) << 10 | Y(x + 2) << 20;
+                out[2]       = Cr(c + 1) | Y(x + 3) << 10 | Cb(c + 2) << 20;
+                out[3]       = Y(x + 4) | Cr(c + 2) << 10 | Y(x + 5) << 20;
+            }
+        });
+
+        return to_array(std::move(dest));
+    });
+}
+
+}} // namespace caspar::core
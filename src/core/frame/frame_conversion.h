@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <common/array.h>
+
+#include <cstdint>
+
+namespace caspar { namespace core {
+
+// Output representations of the mixer's 8 or 16 bit BGRA frames. Each is computed the first time a consumer asks
+// for it and then shared through the frame's cache, so consumers on the same channel never convert twice.
+
+// 8 bit BGRA. 8 bit frames are returned as is, 16 bit frames are rounded.
+array<const std::uint8_t> bgra8(const class const_frame& frame);
+
+// BGRA where every channel holds the alpha value.
+array<const std::uint8_t> key_only(const class const_frame& frame);
+
+// 8 bit 4:2:2 packed as Cb Y Cr Y (UYVY), BT.709 limited range.
+array<const std::uint8_t> uyvy(const class const_frame& frame);
+
+// 10 bit 4:2:2 as three planes (Y, Cb, Cr) of 16 bit samples, BT.709 limited range.
+array<const std::uint16_t> yuv422p10(const class const_frame& frame);
+
+// 10 bit 4:2:2 packed as v210, rows padded to 128 bytes.
+array<const std::uint32_t> v210(const class const_frame& frame);
+
+int v210_linesize(int width);
+
+}} // namespace caspar::core
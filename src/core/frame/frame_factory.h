@@ -35,4 +35,11 @@ class frame_factory
     virtual class mutable_frame create_frame(const void* video_stream_tag, const struct pixel_format_desc& desc) = 0;
 };
 
+// Creates frames in system memory, for channels without an image mixer.
+class cpu_frame_factory final : public frame_factory
+{
+  public:
+    class mutable_frame create_frame(const void* video_stream_tag, const struct pixel_format_desc& desc) override;
+};
+
 }} // namespace caspar::core
\ No newline at end of file
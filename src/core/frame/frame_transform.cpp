@@ -208,6 +208,12 @@ bool operator==(const rectangle& lhs, const rectangle& rhs)
     return boost::range::equal(lhs.ul, rhs.ul, eq) && boost::range::equal(lhs.lr, rhs.lr, eq);
 }
 
+bool operator==(const levels& lhs, const levels& rhs)
+{
+    return eq(lhs.min_input, rhs.min_input) && eq(lhs.max_input, rhs.max_input) && eq(lhs.gamma, rhs.gamma) &&
+           eq(lhs.min_output, rhs.min_output) && eq(lhs.max_output, rhs.max_output);
+}
+
 bool operator==(const image_transform& lhs, const image_transform& rhs)
 {
     return eq(lhs.opacity, rhs.opacity) && eq(lhs.contrast, rhs.contrast) && eq(lhs.brightness, rhs.brightness) &&
@@ -223,7 +229,7 @@ bool operator==(const image_transform& lhs, const image_transform& rhs)
            eq(lhs.chroma.min_brightness, rhs.chroma.min_brightness) && eq(lhs.chroma.softness, rhs.chroma.softness) &&
            eq(lhs.chroma.spill_suppress, rhs.chroma.spill_suppress) &&
            eq(lhs.chroma.spill_suppress_saturation, rhs.chroma.spill_suppress_saturation) && lhs.crop == rhs.crop &&
-           lhs.perspective == rhs.perspective;
+           lhs.perspective == rhs.perspective && lhs.levels == rhs.levels;
 }
 
 bool operator!=(const image_transform& lhs, const image_transform& rhs) { return !(lhs == rhs); }
@@ -233,6 +239,7 @@ bool operator!=(const image_transform& lhs, const image_transform& rhs) { return
 audio_transform& audio_transform::operator*=(const audio_transform& other)
 {
     volume *= other.volume;
+    matrix *= other.matrix;
     return *this;
 }
 
@@ -250,10 +257,30 @@ audio_transform audio_transform::tween(double                 time,
     audio_transform result;
     result.volume = do_tween(time, source.volume, dest.volume, duration, tween);
 
+    // An empty matrix tweens as the identity.
+    if (source.matrix == dest.matrix) {
+        result.matrix = dest.matrix;
+    } else {
+        const auto channels = dest.matrix.empty() ? source.matrix.channels() : dest.matrix.channels();
+        const auto from     = source.matrix.channels() == channels ? source.matrix : audio_matrix::identity(channels);
+        const auto to       = dest.matrix.empty() ? audio_matrix::identity(channels) : dest.matrix;
+
+        result.matrix = audio_matrix(channels);
+        for (auto o = 0; o < channels; ++o) {
+            for (auto i = 0; i < channels; ++i) {
+                result.matrix.set_gain(
+                    o, i, static_cast<float>(do_tween(time, from.gain(o, i), to.gain(o, i), duration, tween)));
+            }
+        }
+    }
+
     return result;
 }
 
-bool operator==(const audio_transform& lhs, const audio_transform& rhs) { return eq(lhs.volume, rhs.volume); }
+bool operator==(const audio_transform& lhs, const audio_transform& rhs)
+{
+    return eq(lhs.volume, rhs.volume) && lhs.matrix == rhs.matrix;
+}
 
 bool operator!=(const audio_transform& lhs, const audio_transform& rhs) { return !(lhs == rhs); }
 
@@ -21,6 +21,8 @@
 
 #pragma once
 
+#include "audio_matrix.h"
+
 #include <common/env.h>
 #include <common/tweener.h>
 
@@ -114,7 +116,8 @@ bool operator!=(const image_transform& lhs, const image_transform& rhs);
 
 struct audio_transform final
 {
-    double volume = 1.0;
+    double       volume = 1.0;
+    audio_matrix matrix;
 
     audio_transform& operator*=(const audio_transform& other);
     audio_transform  operator*(const audio_transform& other) const;
@@ -41,6 +41,15 @@ enum class pixel_format
     invalid,
 };
 
+// Bits per sample of image data. Planes of sixteen bit frames hold native endian 16 bit samples.
+enum class color_depth
+{
+    eight   = 8,
+    sixteen = 16,
+};
+
+inline int bytes_per_sample(color_depth depth) { return static_cast<int>(depth) / 8; }
+
 struct pixel_format_desc final
 {
     struct plane
@@ -65,12 +74,14 @@ struct pixel_format_desc final
 
     pixel_format_desc() = default;
 
-    pixel_format_desc(pixel_format format)
+    pixel_format_desc(pixel_format format, color_depth depth = color_depth::eight)
         : format(format)
+        , depth(depth)
     {
     }
 
     pixel_format       format = pixel_format::invalid;
+    color_depth        depth  = color_depth::eight;
     std::vector<plane> planes;
 };
 
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "../../StdAfx.h"
+
+#include "audio_limiter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <vector>
+
+namespace caspar { namespace core {
+
+struct audio_limiter::impl
+{
+    const int              channels_;
+    const int              sample_rate_;
+    const limiter_settings settings_;
+    const float            threshold_;
+    const float            release_;
+    const std::size_t      look_ahead_;
+
+    // The released gain of the last look_ahead_ + 1 sample frames. Their mean is the gain that is applied.
+    std::vector<float> history_;
+    std::size_t        history_pos_ = 0;
+    float              envelope_    = 1.0f;
+    bool               primed_      = false;
+
+    std::vector<float>      required_;
+    std::deque<std::size_t> window_;
+    double                  gain_reduction_ = 0.0;
+
+    impl(int channels, int sample_rate, const limiter_settings& settings)
+        : channels_(channels)
+        , sample_rate_(sample_rate)
+        , settings_(settings)
+        , threshold_(static_cast<float>(std::pow(10.0, settings.threshold / 20.0) * 2147483648.0))
+        , release_(settings.release > 0.0 ? static_cast<float>(1.0 - std::exp(-1.0 / (settings.release * sample_rate)))
+                                          : 1.0f)
+        , look_ahead_(static_cast<std::size_t>(std::max(0.0, settings.look_ahead * sample_rate)))
+        , history_(look_ahead_ + 1, 1.0f)
+    {
+    }
+
+    void process(float* samples, std::size_t size, const float* next, std::size_t next_size)
+    {
+        const auto frames      = size / channels_;
+        const auto next_frames = std::min(next_size / channels_, look_ahead_);
+
+        gain_reduction_ = 0.0;
+        if (frames == 0) {
+            return;
+        }
+
+        // The gain each sample frame needs to stay under the threshold. Frames past the end of next are unknown and
+        // need none.
+        required_.assign(frames + look_ahead_, 1.0f);
+        auto peaks = [&](const float* x, std::size_t count, float* dest) {
+            for (std::size_t n = 0; n < count; ++n) {
+                auto peak = 0.0f;
+                for (auto ch = 0; ch < channels_; ++ch) {
+                    peak = std::max(peak, std::abs(x[n * channels_ + ch]));
+                }
+                if (peak > threshold_) {
+                    dest[n] = threshold_ / peak;
+                }
+            }
+        };
+        peaks(samples, frames, required_.data());
+        peaks(next, next_frames, required_.data() + frames);
+
+        // Nothing was looked ahead at before the first block, so it starts out reduced for the peaks at its start.
+        if (!primed_) {
+            envelope_ = *std::min_element(required_.begin(), required_.begin() + look_ahead_ + 1);
+            std::fill(history_.begin(), history_.end(), envelope_);
+            primed_ = true;
+        }
+
+        auto sum = 0.0;
+        for (auto gain : history_) {
+            sum += gain;
+        }
+
+        const auto scale = 1.0 / static_cast<double>(history_.size());
+
+        auto min_gain = 1.0;
+        window_.clear();
+        for (std::size_t n = 0, end = 0; n < frames; ++n) {
+            // Minimum of the required gain from this frame to look_ahead_ frames later.
+            for (; end <= n + look_ahead_; ++end) {
+                while (!window_.empty() && required_[window_.back()] >= required_[end]) {
+                    window_.pop_back();
+                }
+                window_.push_back(end);
+            }
+            while (window_.front() < n) {
+                window_.pop_front();
+            }
+
+            // Every frame that is averaged into the gain of a peak has a released gain at or below what the peak
+            // needs, so the mean is too.
+            envelope_ = std::min(required_[window_.front()], envelope_ + (1.0f - envelope_) * release_);
+
+            sum += envelope_ - history_[history_pos_];
+            history_[history_pos_] = envelope_;
+            history_pos_           = (history_pos_ + 1) % history_.size();
+
+            const auto gain = static_cast<float>(std::min(1.0, sum * scale));
+            for (auto ch = 0; ch < channels_; ++ch) {
+                samples[n * channels_ + ch] *= gain;
+            }
+            min_gain = std::min<double>(min_gain, gain);
+        }
+
+        gain_reduction_ = -20.0 * std::log10(min_gain);
+    }
+};
+
+audio_limiter::audio_limiter(int channels, int sample_rate, const limiter_settings& settings)
+    : impl_(new impl(channels, sample_rate, settings))
+{
+}
+audio_limiter::audio_limiter(audio_limiter&& other)
+    : impl_(std::move(other.impl_))
+{
+}
+audio_limiter::~audio_limiter() {}
+audio_limiter& audio_limiter::operator=(audio_limiter&& other)
+{
+    impl_ = std::move(other.impl_);
+    return *this;
+}
+void audio_limiter::process(float* samples, std::size_t size, const float* next, std::size_t next_size)
+{
+    impl_->process(samples, size, next, next_size);
+}
+double                  audio_limiter::gain_reduction() const { return impl_->gain_reduction_; }
+int                     audio_limiter::channels() const { return impl_->channels_; }
+int                     audio_limiter::sample_rate() const { return impl_->sample_rate_; }
+const limiter_settings& audio_limiter::settings() const { return impl_->settings_; }
+
+bool operator==(const limiter_settings& lhs, const limiter_settings& rhs)
+{
+    return lhs.enabled == rhs.enabled && lhs.threshold == rhs.threshold && lhs.release == rhs.release &&
+           lhs.look_ahead == rhs.look_ahead;
+}
+bool operator!=(const limiter_settings& lhs, const limiter_settings& rhs) { return !(lhs == rhs); }
+
+}} // namespace caspar::core
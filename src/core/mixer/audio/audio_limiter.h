@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+namespace caspar { namespace core {
+
+struct limiter_settings
+{
+    bool   enabled    = false;
+    double threshold  = -1.0;  // dBFS.
+    double release    = 0.1;   // Seconds, time constant of the recovery.
+    double look_ahead = 0.005; // Seconds, at most one tick.
+};
+
+bool operator==(const limiter_settings& lhs, const limiter_settings& rhs);
+bool operator!=(const limiter_settings& lhs, const limiter_settings& rhs);
+
+// Brickwall limiter with look-ahead, every channel gets the same gain. The gain reaches what a peak needs by the time
+// the peak is played, so the limiter needs the samples that follow a block but doesn't delay it.
+class audio_limiter final
+{
+  public:
+    audio_limiter(int channels, int sample_rate, const limiter_settings& settings);
+    audio_limiter(audio_limiter&& other);
+    ~audio_limiter();
+
+    audio_limiter& operator=(audio_limiter&& other);
+
+    // Limits interleaved samples in place, where full scale is 2^31. next holds the samples that follow, of which
+    // the look-ahead is read. Sizes must be multiples of the channel count.
+    void process(float* samples, std::size_t size, const float* next, std::size_t next_size);
+
+    // Largest gain reduction of the last process call, in dB.
+    double gain_reduction() const;
+
+    int                     channels() const;
+    int                     sample_rate() const;
+    const limiter_settings& settings() const;
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> impl_;
+};
+
+}} // namespace caspar::core
@@ -0,0 +1,310 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "../../StdAfx.h"
+
+#include "audio_meter.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <smmintrin.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace caspar { namespace core {
+
+namespace {
+
+const int   taps        = 12;
+const int   phases      = 4;
+const float floor_db    = -144.0f;
+const float full_scale  = 1.0f / 2147483648.0f;
+const float floor_level = 6.3e-8f; // -144 dBFS
+
+typedef std::array<std::array<float, taps>, phases> interpolation_taps_t;
+
+// Hann windowed sinc. Phase p interpolates at p / phases past tap taps / 2 - 1, with unity gain.
+const interpolation_taps_t& interpolation_taps()
+{
+    static const interpolation_taps_t result = [] {
+        const auto           pi = 3.14159265358979323846;
+        interpolation_taps_t h;
+        for (auto p = 0; p < phases; ++p) {
+            auto sum = 0.0;
+            for (auto k = 0; k < taps; ++k) {
+                const auto x    = taps / 2 - 1 + static_cast<double>(p) / phases - k;
+                const auto sinc = x == 0.0 ? 1.0 : std::sin(pi * x) / (pi * x);
+                const auto w    = 0.5 * (1.0 + std::cos(pi * x / (taps / 2)));
+                h[p][k]         = static_cast<float>(sinc * w);
+                sum += sinc * w;
+            }
+            for (auto& v : h[p]) {
+                v = static_cast<float>(v / sum);
+            }
+        }
+        return h;
+    }();
+    return result;
+}
+
+float to_db(float level) { return level > floor_level ? 20.0f * std::log10(level) : floor_db; }
+
+// Interleaved samples repeat their channel pattern across vector lanes every lcm(4, channels) samples, so that many
+// samples are covered by one accumulator per group of four lanes. Lane j of group i belongs to channel (i + j) % channels.
+int lane_period(int channels)
+{
+    auto period = channels;
+    while (period % 4 != 0) {
+        period += channels;
+    }
+    return period;
+}
+
+// Adds the four lanes of a group to the per channel maximums.
+void fold_max(float* dest, __m128 lanes, int first, int channels)
+{
+    alignas(16) float values[4];
+    _mm_store_ps(values, lanes);
+    for (auto j = 0; j < 4; ++j) {
+        auto& value = dest[(first + j) % channels];
+        value       = std::max(value, values[j]);
+    }
+}
+
+// Peak and sum of squares per channel of interleaved samples. size is a multiple of the channel count.
+void peak_and_sum(const float* x, std::size_t size, int channels, float* peak, double* sum)
+{
+    const auto period = static_cast<std::size_t>(lane_period(channels));
+    const auto full   = size / period * period;
+    const auto sign   = _mm_set1_ps(-0.0f);
+
+    for (std::size_t first = 0; first < period; first += 4) {
+        auto max = _mm_setzero_ps();
+        auto acc = _mm_setzero_ps();
+        for (auto n = first; n < full; n += period) {
+            const auto xmm0 = _mm_loadu_ps(x + n);
+            max             = _mm_max_ps(max, _mm_andnot_ps(sign, xmm0));
+            acc             = _mm_add_ps(acc, _mm_mul_ps(xmm0, xmm0));
+        }
+
+        fold_max(peak, max, static_cast<int>(first), channels);
+
+        alignas(16) float sums[4];
+        _mm_store_ps(sums, acc);
+        for (auto j = 0; j < 4; ++j) {
+            sum[(first + j) % channels] += sums[j];
+        }
+    }
+
+    for (auto n = full; n < size; ++n) {
+        const auto ch = n % channels;
+        peak[ch]      = std::max(peak[ch], std::abs(x[n]));
+        sum[ch] += x[n] * x[n];
+    }
+}
+
+// Peak per channel of the 4x interpolated signal. Output frame n is interpolated from frames n to n + taps - 1 of
+// the interleaved samples x, for frames frames.
+void interpolated_peak(const float* x, std::size_t frames, int channels, float* peak)
+{
+    const auto& h      = interpolation_taps();
+    const auto  size   = frames * channels;
+    const auto  period = static_cast<std::size_t>(lane_period(channels));
+    const auto  full   = size / period * period;
+    const auto  sign   = _mm_set1_ps(-0.0f);
+
+    for (std::size_t first = 0; first < period; first += 4) {
+        auto max = _mm_setzero_ps();
+        for (auto n = first; n < full; n += period) {
+            for (auto p = 0; p < phases; ++p) {
+                auto acc = _mm_setzero_ps();
+                for (auto k = 0; k < taps; ++k) {
+                    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(h[p][k]), _mm_loadu_ps(x + n + k * channels)));
+                }
+                max = _mm_max_ps(max, _mm_andnot_ps(sign, acc));
+            }
+        }
+        fold_max(peak, max, static_cast<int>(first), channels);
+    }
+
+    for (auto n = full; n < size; ++n) {
+        for (auto p = 0; p < phases; ++p) {
+            auto acc = 0.0f;
+            for (auto k = 0; k < taps; ++k) {
+                acc += h[p][k] * x[n + k * channels];
+            }
+            peak[n % channels] = std::max(peak[n % channels], std::abs(acc));
+        }
+    }
+}
+
+} // namespace
+
+struct audio_meter::impl
+{
+    const int              channels_;
+    const int              sample_rate_;
+    const meter_ballistics ballistics_;
+
+    // The samples are metered where they are. For the true peak the last taps - 1 frames of the previous block are
+    // kept, and joined with the first frames of the next block to interpolate across the boundary.
+    std::vector<float> history_;
+    std::vector<float> joined_;
+
+    std::vector<float>  peaks_;
+    std::vector<double> sums_;
+
+    std::vector<float>  block_peak_;
+    std::vector<float>  block_true_peak_;
+    std::vector<double> block_sum_;
+    std::size_t         block_frames_ = 0;
+
+    std::vector<float>  peak_level_;
+    std::vector<float>  true_peak_level_;
+    std::vector<double> mean_square_;
+
+    std::vector<float> peak_;
+    std::vector<float> rms_;
+    std::vector<float> true_peak_;
+
+    impl(int channels, int sample_rate, const meter_ballistics& ballistics)
+        : channels_(channels)
+        , sample_rate_(sample_rate)
+        , ballistics_(ballistics)
+        , history_((taps - 1) * channels, 0.0f)
+        , peaks_(channels, 0.0f)
+        , sums_(channels, 0.0)
+        , block_peak_(channels, 0.0f)
+        , block_true_peak_(channels, 0.0f)
+        , block_sum_(channels, 0.0)
+        , peak_level_(channels, 0.0f)
+        , true_peak_level_(channels, 0.0f)
+        , mean_square_(channels, 0.0)
+        , peak_(channels, floor_db)
+        , rms_(channels, floor_db)
+        , true_peak_(ballistics.true_peak ? channels : 0, floor_db)
+    {
+    }
+
+    void process(const float* samples, std::size_t size)
+    {
+        const auto frames = size / channels_;
+        size              = frames * channels_;
+
+        // Levels are scaled to full scale once per block rather than per sample.
+        std::fill(peaks_.begin(), peaks_.end(), 0.0f);
+        std::fill(sums_.begin(), sums_.end(), 0.0);
+        peak_and_sum(samples, size, channels_, peaks_.data(), sums_.data());
+
+        for (auto ch = 0; ch < channels_; ++ch) {
+            block_peak_[ch] = std::max(block_peak_[ch], peaks_[ch] * full_scale);
+            block_sum_[ch] += sums_[ch] * static_cast<double>(full_scale) * full_scale;
+        }
+
+        if (ballistics_.true_peak && frames > 0) {
+            process_true_peak(samples, frames);
+        }
+
+        block_frames_ += frames;
+    }
+
+    void process_true_peak(const float* samples, std::size_t frames)
+    {
+        const auto history = static_cast<std::size_t>(taps - 1);
+        const auto head    = std::min(frames, history);
+
+        // The first head frames are interpolated from the history joined with the start of this block, the rest
+        // straight from the block.
+        joined_.assign(history_.begin(), history_.end());
+        joined_.insert(joined_.end(), samples, samples + head * channels_);
+
+        std::fill(peaks_.begin(), peaks_.end(), 0.0f);
+        interpolated_peak(joined_.data(), head, channels_, peaks_.data());
+        if (frames > history) {
+            interpolated_peak(samples, frames - history, channels_, peaks_.data());
+        }
+
+        for (auto ch = 0; ch < channels_; ++ch) {
+            block_true_peak_[ch] = std::max(block_true_peak_[ch], peaks_[ch] * full_scale);
+        }
+
+        if (frames >= history) {
+            history_.assign(samples + (frames - history) * channels_, samples + frames * channels_);
+        } else {
+            history_.assign(joined_.end() - history * channels_, joined_.end());
+        }
+    }
+
+    void update(int nb_samples)
+    {
+        const auto duration   = static_cast<double>(nb_samples) / sample_rate_;
+        const auto peak_decay = static_cast<float>(std::pow(10.0, -ballistics_.peak_release * duration / 20.0));
+        const auto rms_window = ballistics_.rms_window;
+        const auto rms_attack = rms_window > 0.0 ? 1.0 - std::exp(-duration / rms_window) : 1.0;
+
+        for (auto ch = 0; ch < channels_; ++ch) {
+            const auto mean_square = block_frames_ > 0 ? block_sum_[ch] / block_frames_ : 0.0;
+
+            peak_level_[ch]      = std::max(block_peak_[ch], peak_level_[ch] * peak_decay);
+            true_peak_level_[ch] = std::max(std::max(block_true_peak_[ch], block_peak_[ch]),
+                                            true_peak_level_[ch] * peak_decay);
+            mean_square_[ch] += rms_attack * (mean_square - mean_square_[ch]);
+
+            peak_[ch]      = to_db(peak_level_[ch]);
+            rms_[ch]       = to_db(static_cast<float>(std::sqrt(mean_square_[ch])));
+            if (ballistics_.true_peak) {
+                true_peak_[ch] = to_db(true_peak_level_[ch]);
+            }
+
+            block_peak_[ch]      = 0.0f;
+            block_true_peak_[ch] = 0.0f;
+            block_sum_[ch]       = 0.0;
+        }
+
+        block_frames_ = 0;
+    }
+};
+
+audio_meter::audio_meter(int channels, int sample_rate, const meter_ballistics& ballistics)
+    : impl_(new impl(channels, sample_rate, ballistics))
+{
+}
+audio_meter::audio_meter(audio_meter&& other)
+    : impl_(std::move(other.impl_))
+{
+}
+audio_meter::~audio_meter() {}
+audio_meter& audio_meter::operator=(audio_meter&& other)
+{
+    impl_ = std::move(other.impl_);
+    return *this;
+}
+void audio_meter::process(const float* samples, std::size_t size) { impl_->process(samples, size); }
+void audio_meter::update(int nb_samples) { impl_->update(nb_samples); }
+int  audio_meter::channels() const { return impl_->channels_; }
+const std::vector<float>& audio_meter::peak() const { return impl_->peak_; }
+const std::vector<float>& audio_meter::rms() const { return impl_->rms_; }
+const std::vector<float>& audio_meter::true_peak() const { return impl_->true_peak_; }
+
+}} // namespace caspar::core
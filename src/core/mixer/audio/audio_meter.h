@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace caspar { namespace core {
+
+struct meter_ballistics
+{
+    double peak_release = 20.0; // dB per second.
+    double rms_window   = 0.3;  // Seconds.
+    bool   true_peak    = false; // The channel true peak is part of loudness.
+};
+
+// Sample peak, RMS and 4x oversampled true peak of interleaved audio, in dBFS per channel.
+class audio_meter final
+{
+  public:
+    audio_meter(int channels, int sample_rate, const meter_ballistics& ballistics = meter_ballistics());
+    audio_meter(audio_meter&& other);
+    ~audio_meter();
+
+    audio_meter& operator=(audio_meter&& other);
+
+    // Adds interleaved samples where full scale is 2^31. size must be a multiple of the channel count.
+    void process(const float* samples, std::size_t size);
+
+    // Applies the ballistics for nb_samples sample frames and publishes what was processed since the last update.
+    void update(int nb_samples);
+
+    int                       channels() const;
+    const std::vector<float>& peak() const;
+    const std::vector<float>& rms() const;
+    const std::vector<float>& true_peak() const; // Empty unless the ballistics measure true peak.
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> impl_;
+};
+
+}} // namespace caspar::core
@@ -22,20 +22,35 @@
 #include "../../StdAfx.h"
 
 #include "audio_mixer.h"
+#include "audio_limiter.h"
+#include "audio_meter.h"
+#include "loudness_meter.h"
 
+#include <core/frame/audio_delay.h>
 #include <core/frame/frame.h>
 #include <core/frame/frame_transform.h>
 #include <core/monitor/monitor.h>
 
 #include <common/diagnostics/graph.h>
+#include <common/env.h>
+#include <common/except.h>
 
 #include <boost/container/flat_map.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/property_tree/ptree.hpp>
 #include <boost/range/adaptors.hpp>
 #include <boost/range/algorithm.hpp>
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <smmintrin.h>
+#endif
+
 #include <atomic>
+#include <cmath>
 #include <map>
+#include <mutex>
 #include <stack>
 #include <vector>
 
@@ -45,11 +60,107 @@ using namespace boost::container;
 
 struct audio_item
 {
+    int                  layer = 0;
+    const void*          tag   = nullptr;
     audio_transform      transform;
     array<const int32_t> samples;
 };
 
-typedef std::vector<double> audio_buffer_ps;
+// The last sample frame of an item, after gains, per channel.
+struct audio_tail
+{
+    int                layer = 0;
+    std::vector<float> samples;
+};
+
+namespace {
+
+// Samples are mixed in blocks of this many floats, so the accumulator stays in L1 while every item is added.
+const std::size_t mix_block_size = 2048;
+
+// dest[n] += src[n] * (from + (to - from) * ramp[n])
+void mix_ramped(float* dest, const float* ramp, const int32_t* src, std::size_t size, float from, float to)
+{
+    const auto delta = to - from;
+
+    std::size_t n = 0;
+
+    const auto xmm_from  = _mm_set1_ps(from);
+    const auto xmm_delta = _mm_set1_ps(delta);
+    for (; n + 8 <= size; n += 8) {
+        auto gain0 = _mm_add_ps(xmm_from, _mm_mul_ps(xmm_delta, _mm_loadu_ps(ramp + n + 0)));
+        auto gain1 = _mm_add_ps(xmm_from, _mm_mul_ps(xmm_delta, _mm_loadu_ps(ramp + n + 4)));
+        auto src0  = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n + 0)));
+        auto src1  = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n + 4)));
+        _mm_storeu_ps(dest + n + 0, _mm_add_ps(_mm_loadu_ps(dest + n + 0), _mm_mul_ps(src0, gain0)));
+        _mm_storeu_ps(dest + n + 4, _mm_add_ps(_mm_loadu_ps(dest + n + 4), _mm_mul_ps(src1, gain1)));
+    }
+
+    for (; n < size; ++n) {
+        dest[n] += static_cast<float>(src[n]) * (from + delta * ramp[n]);
+    }
+}
+
+void mix_ramped(float* dest, const float* ramp, const float* src, std::size_t size, float from, float to)
+{
+    const auto delta = to - from;
+
+    std::size_t n = 0;
+
+    const auto xmm_from  = _mm_set1_ps(from);
+    const auto xmm_delta = _mm_set1_ps(delta);
+    for (; n + 8 <= size; n += 8) {
+        auto gain0 = _mm_add_ps(xmm_from, _mm_mul_ps(xmm_delta, _mm_loadu_ps(ramp + n + 0)));
+        auto gain1 = _mm_add_ps(xmm_from, _mm_mul_ps(xmm_delta, _mm_loadu_ps(ramp + n + 4)));
+        auto src0  = _mm_loadu_ps(src + n + 0);
+        auto src1  = _mm_loadu_ps(src + n + 4);
+        _mm_storeu_ps(dest + n + 0, _mm_add_ps(_mm_loadu_ps(dest + n + 0), _mm_mul_ps(src0, gain0)));
+        _mm_storeu_ps(dest + n + 4, _mm_add_ps(_mm_loadu_ps(dest + n + 4), _mm_mul_ps(src1, gain1)));
+    }
+
+    for (; n < size; ++n) {
+        dest[n] += src[n] * (from + delta * ramp[n]);
+    }
+}
+
+void add(float* dest, const float* src, std::size_t size)
+{
+    std::size_t n = 0;
+    for (; n + 4 <= size; n += 4) {
+        _mm_storeu_ps(dest + n, _mm_add_ps(_mm_loadu_ps(dest + n), _mm_loadu_ps(src + n)));
+    }
+    for (; n < size; ++n) {
+        dest[n] += src[n];
+    }
+}
+
+// Rounds to nearest and saturates.
+void float_to_int32(int32_t* dest, const float* src, std::size_t size)
+{
+    std::size_t n = 0;
+
+    // cvtps returns INT_MIN for anything out of range, which is right for negative overflow. Positive overflow
+    // is flipped to INT_MAX.
+    const auto limit = _mm_set1_ps(2147483648.0f);
+    for (; n + 4 <= size; n += 4) {
+        auto xmm0 = _mm_loadu_ps(src + n);
+        auto xmm1 = _mm_cvtps_epi32(xmm0);
+        xmm1      = _mm_xor_si128(xmm1, _mm_castps_si128(_mm_cmpge_ps(xmm0, limit)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + n), xmm1);
+    }
+
+    for (; n < size; ++n) {
+        if (src[n] >= 2147483648.0f) {
+            dest[n] = std::numeric_limits<int32_t>::max();
+        } else if (src[n] < -2147483648.0f) {
+            dest[n] = std::numeric_limits<int32_t>::min();
+        } else {
+            dest[n] = static_cast<int32_t>(std::lrint(src[n]));
+        }
+    }
+}
+
+} // namespace
 
 struct audio_mixer::impl : boost::noncopyable
 {
@@ -59,15 +170,89 @@ struct audio_mixer::impl : boost::noncopyable
     std::atomic<float>                  master_volume_{1.0f};
     spl::shared_ptr<diagnostics::graph> graph_;
 
+    // Gains are ramped from the previous tick's values. Items are matched on the stream tag of their frame and
+    // the order in which frames with that tag were visited.
+    flat_map<std::pair<const void*, int>, float> previous_volumes_;
+    float                                        previous_master_volume_ = 1.0f;
+
+    std::vector<float> ramp_;
+    int                ramp_channels_ = 0;
+    std::vector<float> mixed_;
+
+    // Items that appear fade in and items that disappear fade out from their last sample frame, both over the
+    // de-click time, so that starting, stopping and swapping layers doesn't step the signal.
+    double                                            declick_        = 0.0;
+    int                                               declick_frames_ = 0;
+    std::vector<float>                                declick_ramp_;
+    flat_map<std::pair<const void*, int>, audio_tail> previous_tails_;
+
+    // Samples of items with a routing matrix, after routing.
+    std::vector<std::vector<float>> routed_;
+
+    // Every layer is mixed into its own block first, which is metered before it is added to the channel mix.
+    int                        layer_ = 0;
+    std::vector<int>           layers_;
+    std::map<int, audio_meter> meters_;
+    meter_ballistics           ballistics_;
+    std::vector<float>         layer_mixed_;
+
+    // Layers whose audio is delayed, in sample frames. A layer's delay runs after its items are mixed, so it keeps
+    // playing out what it holds when the layer has no audio.
+    std::map<int, int>                layer_delays_;
+    std::map<int, audio_delay<float>> delays_;
+
+    // Loudness of the channel mix. Resets are picked up on the next tick, values are read under the mutex.
+    std::wstring                    loudness_layout_;
+    std::unique_ptr<loudness_meter> loudness_meter_;
+    int                             loudness_sample_rate_ = 0;
+    std::atomic<bool>               loudness_reset_{false};
+    mutable std::mutex              loudness_mutex_;
+    loudness                        loudness_;
+
+    // While looking ahead the mix is held for a tick, the limiter looks ahead into the next tick's mix.
+    std::vector<float>             held_;
+    int                            held_channels_ = 0;
+    bool                           holding_       = false;
+    array<const int32_t>           released_;
+    mutable std::mutex             limiter_mutex_;
+    limiter_settings               limiter_settings_;
+    std::unique_ptr<audio_limiter> limiter_;
+
   public:
     impl(spl::shared_ptr<diagnostics::graph> graph)
         : graph_(std::move(graph))
     {
+        ballistics_.peak_release = env::properties().get(L"configuration.audio-meter.peak-release", 20.0);
+        ballistics_.rms_window   = env::properties().get(L"configuration.audio-meter.rms-window", 300) / 1000.0;
+        ballistics_.true_peak    = env::properties().get(L"configuration.audio-meter.true-peak", false);
+
+        loudness_layout_ = env::properties().get(L"configuration.loudness.layout", std::wstring(L"stereo"));
+        loudness_weights(loudness_layout_, 2); // Throws on unknown layouts.
+
+        const auto declick = env::properties().get(L"configuration.audio-declick", 5);
+        if (declick < 0) {
+            CASPAR_THROW_EXCEPTION(user_error() << msg_info(L"Invalid audio-declick: " +
+                                                            boost::lexical_cast<std::wstring>(declick)));
+        }
+        declick_ = declick / 1000.0;
+
+        limiter_settings_.enabled    = env::properties().get(L"configuration.audio-limiter.enabled", false);
+        limiter_settings_.threshold  = env::properties().get(L"configuration.audio-limiter.threshold", -1.0);
+        limiter_settings_.release    = env::properties().get(L"configuration.audio-limiter.release", 100) / 1000.0;
+        limiter_settings_.look_ahead = env::properties().get(L"configuration.audio-limiter.look-ahead", 5) / 1000.0;
+
         graph_->set_color("volume", diagnostics::color(1.0f, 0.8f, 0.1f));
         graph_->set_color("audio-clipping", diagnostics::color(0.3f, 0.6f, 0.3f));
+        graph_->set_color("limiter", diagnostics::color(0.9f, 0.3f, 0.3f));
         transform_stack_.push(core::audio_transform());
     }
 
+    void begin_layer(int index)
+    {
+        layer_ = index;
+        layers_.push_back(index);
+    }
+
     void push(const frame_transform& transform)
     {
         transform_stack_.push(transform_stack_.top() * transform.audio_transform);
@@ -79,6 +264,8 @@ struct audio_mixer::impl : boost::noncopyable
             return;
 
         audio_item item;
+        item.layer     = layer_;
+        item.tag       = frame.stream_tag();
         item.transform = transform_stack_.top();
         item.samples   = frame.audio_data();
 
@@ -91,38 +278,295 @@ struct audio_mixer::impl : boost::noncopyable
 
     float get_master_volume() { return master_volume_; }
 
-    array<const int32_t> mix(const video_format_desc& format_desc, int nb_samples)
+    loudness get_loudness() const
+    {
+        std::lock_guard<std::mutex> lock(loudness_mutex_);
+        return loudness_;
+    }
+
+    void reset_loudness() { loudness_reset_ = true; }
+
+    void set_limiter(const limiter_settings& settings)
+    {
+        std::lock_guard<std::mutex> lock(limiter_mutex_);
+        limiter_settings_ = settings;
+    }
+
+    limiter_settings get_limiter() const
+    {
+        std::lock_guard<std::mutex> lock(limiter_mutex_);
+        return limiter_settings_;
+    }
+
+    void set_layer_delays(std::map<int, int> delays) { layer_delays_ = std::move(delays); }
+
+    array<const int32_t> mix(const video_format_desc& format_desc, int nb_samples, bool look_ahead)
     {
         auto channels = format_desc.audio_channels;
         auto items    = std::move(items_);
-        auto result   = std::vector<int32_t>(nb_samples * channels, 0);
+        auto mix_size = static_cast<std::size_t>(nb_samples * channels);
+
+        auto master_volume          = master_volume_.load();
+        auto previous_master_volume = previous_master_volume_;
+        auto previous_volumes       = std::move(previous_volumes_);
+        auto previous_tails         = std::move(previous_tails_);
+        previous_master_volume_     = master_volume;
+        previous_volumes_.clear();
+        previous_tails_.clear();
+
+        state_.clear();
+
+        auto layers = std::move(layers_);
+        layers_.clear();
+
+        for (auto it = meters_.begin(); it != meters_.end();) {
+            if (boost::range::find(layers, it->first) == layers.end() || it->second.channels() != channels) {
+                it = meters_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        for (auto layer : layers) {
+            if (meters_.find(layer) == meters_.end()) {
+                meters_.emplace(layer, audio_meter(channels, format_desc.audio_sample_rate, ballistics_));
+            }
+        }
+
+        for (auto it = delays_.begin(); it != delays_.end();) {
+            auto delay = layer_delays_.find(it->first);
+            if (delay == layer_delays_.end() || delay->second != it->second.delay() ||
+                it->second.channels() != channels) {
+                it = delays_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        for (auto& delay : layer_delays_) {
+            if (delay.second > 0 && delays_.find(delay.first) == delays_.end()) {
+                delays_.emplace(delay.first, audio_delay<float>(channels, delay.second));
+            }
+        }
 
-        if (items.empty()) {
-            return result;
+        // Position of each interleaved sample within the tick, from 0 for the first sample frame towards 1, and
+        // within the de-click fade, which is at most a tick long.
+        const auto declick_frames =
+            std::min(static_cast<int>(std::lround(declick_ * format_desc.audio_sample_rate)), nb_samples);
+        if (ramp_.size() != mix_size || ramp_channels_ != channels || declick_frames_ != declick_frames) {
+            ramp_.resize(mix_size);
+            declick_ramp_.resize(mix_size);
+            ramp_channels_  = channels;
+            declick_frames_ = declick_frames;
+            for (std::size_t n = 0; n < ramp_.size(); ++n) {
+                const auto frame = static_cast<float>(n / channels);
+                ramp_[n]         = frame / static_cast<float>(nb_samples);
+                declick_ramp_[n] =
+                    declick_frames > 0 ? std::min(1.0f, frame / static_cast<float>(declick_frames)) : 1.0f;
+            }
         }
 
-        auto mixed = std::vector<double>(nb_samples * channels, 0.0f);
+        if (items.empty() && delays_.empty()) {
+            mixed_.assign(mix_size, 0.0f);
+            for (auto& tail : previous_tails) {
+                fade_out(tail, mixed_.data(), 0, mixed_.size(), channels);
+            }
+            update_meters(nb_samples);
+            return output(format_desc, look_ahead);
+        }
 
+        struct ramped_item
+        {
+            int            layer;
+            const int32_t* samples;
+            const float*   routed;
+            const float*   ramp;
+            std::size_t    size;
+            float          from;
+            float          to;
+        };
+
+        std::vector<ramped_item>   ramped;
+        flat_map<const void*, int> occurrences;
+        std::size_t                nb_routed = 0;
         for (auto& item : items) {
-            auto ptr  = item.samples.data();
-            auto size = std::min(item.samples.size(), result.size());
-            for (auto n = 0; n < size; ++n) {
-                mixed[n] = static_cast<double>(ptr[n]) * item.transform.volume + mixed[n];
+            auto to   = static_cast<float>(item.transform.volume);
+            auto from = to;
+            auto ramp = ramp_.data();
+            auto key  = std::make_pair(item.tag, 0);
+            if (item.tag) {
+                key.second = occurrences[item.tag]++;
+                auto it    = previous_volumes.find(key);
+                if (it != previous_volumes.end()) {
+                    from = it->second;
+                } else if (declick_frames > 0) {
+                    from = 0.0f;
+                    ramp = declick_ramp_.data();
+                }
+                previous_volumes_[key] = to;
+            }
+            auto size = std::min(item.samples.size(), mix_size);
+
+            const float* routed = nullptr;
+            const auto&  matrix = item.transform.matrix;
+            if (!matrix.empty() && matrix.channels() == channels) {
+                if (routed_.size() <= nb_routed) {
+                    routed_.resize(nb_routed + 1);
+                }
+                auto& buffer = routed_[nb_routed++];
+                buffer.resize(size);
+                matrix.apply(item.samples.data(), buffer.data(), size / channels);
+                routed = buffer.data();
+            }
+
+            ramped.push_back(ramped_item{item.layer,
+                                         item.samples.data(),
+                                         routed,
+                                         ramp,
+                                         size,
+                                         from * previous_master_volume,
+                                         to * master_volume});
+
+            if (item.tag && size >= static_cast<std::size_t>(channels)) {
+                auto& tail = previous_tails_[key];
+                tail.layer = item.layer;
+                tail.samples.resize(channels);
+                for (auto ch = 0; ch < channels; ++ch) {
+                    const auto index  = size - channels + ch;
+                    const auto sample = routed ? routed[index] : static_cast<float>(item.samples.data()[index]);
+                    tail.samples[ch]  = sample * to * master_volume;
+                }
             }
         }
 
-        auto master_volume = master_volume_.load();
-        for (auto n = 0; n < mixed.size(); ++n) {
-            auto sample = mixed[n] * master_volume;
-            if (sample > std::numeric_limits<int32_t>::max()) {
-                result[n] = std::numeric_limits<int32_t>::max();
-            } else if (sample < std::numeric_limits<int32_t>::min()) {
-                result[n] = std::numeric_limits<int32_t>::min();
-            } else {
-                result[n] = static_cast<int32_t>(sample);
+        // Delayed layers without audio this tick still run, silence goes into their delay.
+        for (auto& delay : delays_) {
+            if (std::none_of(ramped.begin(), ramped.end(), [&](auto& item) { return item.layer == delay.first; })) {
+                ramped.push_back(ramped_item{delay.first, nullptr, nullptr, nullptr, 0, 0.0f, 0.0f});
             }
         }
 
+        // Tails of delayed layers fade out ahead of their delay.
+        mixed_.assign(mix_size, 0.0f);
+        for (auto& tail : previous_tails) {
+            if (delays_.find(tail.second.layer) == delays_.end()) {
+                fade_out(tail, mixed_.data(), 0, mixed_.size(), channels);
+            }
+        }
+
+        // Whole sample frames per block, so that meters see every channel.
+        const auto block_size = std::max<std::size_t>(mix_block_size / channels, 1) * channels;
+        layer_mixed_.resize(block_size);
+
+        for (std::size_t offset = 0; offset < mixed_.size(); offset += block_size) {
+            const auto count = std::min(block_size, mixed_.size() - offset);
+
+            for (auto begin = ramped.begin(); begin != ramped.end();) {
+                auto end = std::find_if(begin, ramped.end(), [&](auto& item) { return item.layer != begin->layer; });
+
+                std::fill_n(layer_mixed_.data(), count, 0.0f);
+                for (auto item = begin; item != end; ++item) {
+                    if (offset >= item->size) {
+                        continue;
+                    }
+                    const auto size = std::min(count, item->size - offset);
+                    if (item->routed) {
+                        mix_ramped(layer_mixed_.data(),
+                                   item->ramp + offset,
+                                   item->routed + offset,
+                                   size,
+                                   item->from,
+                                   item->to);
+                    } else {
+                        mix_ramped(layer_mixed_.data(),
+                                   item->ramp + offset,
+                                   item->samples + offset,
+                                   size,
+                                   item->from,
+                                   item->to);
+                    }
+                }
+
+                auto delay = delays_.find(begin->layer);
+                if (delay != delays_.end()) {
+                    for (auto& tail : previous_tails) {
+                        if (tail.second.layer == begin->layer) {
+                            fade_out(tail, layer_mixed_.data(), offset, count, channels);
+                        }
+                    }
+                    delay->second.process(layer_mixed_.data(), count);
+                }
+
+                auto meter = meters_.find(begin->layer);
+                if (meter != meters_.end()) {
+                    meter->second.process(layer_mixed_.data(), count);
+                }
+
+                add(mixed_.data() + offset, layer_mixed_.data(), count);
+
+                begin = end;
+            }
+        }
+
+        update_meters(nb_samples);
+
+        return output(format_desc, look_ahead);
+    }
+
+    // Fades the last sample frame of an item that isn't mixed any more out to silence. dest holds count samples of
+    // the tick from offset on.
+    void fade_out(const std::pair<std::pair<const void*, int>, audio_tail>& tail,
+                  float*                                                   dest,
+                  std::size_t                                              offset,
+                  std::size_t                                              count,
+                  int                                                      channels)
+    {
+        if (previous_volumes_.find(tail.first) != previous_volumes_.end() ||
+            static_cast<int>(tail.second.samples.size()) != channels) {
+            return;
+        }
+        const auto end = std::min(offset + count, static_cast<std::size_t>(declick_frames_) * channels);
+        for (auto n = offset; n < end; ++n) {
+            const auto gain = 1.0f - static_cast<float>(n / channels) / static_cast<float>(declick_frames_);
+            dest[n - offset] += tail.second.samples[n % channels] * gain;
+        }
+    }
+
+    array<const int32_t> output(const video_format_desc& format_desc, bool look_ahead)
+    {
+        const auto channels = format_desc.audio_channels;
+        const auto settings = get_limiter();
+
+        // A held mix is released rather than dropped when the hold ends, it belongs to the previous tick.
+        holding_  = look_ahead && settings.enabled;
+        released_ = array<const int32_t>{};
+        if (!holding_ || held_channels_ != channels) {
+            if (!held_.empty()) {
+                if (held_channels_ == channels) {
+                    update_loudness(format_desc, held_);
+                }
+                auto released = std::vector<int32_t>(held_.size());
+                float_to_int32(released.data(), held_.data(), released.size());
+                released_ = std::move(released);
+            }
+            held_.clear();
+            held_channels_ = channels;
+        }
+        if (holding_ && held_.empty()) {
+            // Nothing is held yet, this mix is returned on the next tick.
+            std::swap(held_, mixed_);
+            return array<const int32_t>{};
+        }
+
+        auto& samples = holding_ ? held_ : mixed_;
+
+        update_limiter(format_desc, settings, samples);
+        update_loudness(format_desc, samples);
+
+        auto result = std::vector<int32_t>(samples.size());
+        float_to_int32(result.data(), samples.data(), result.size());
+        if (holding_) {
+            std::swap(held_, mixed_);
+        }
+
         auto max = std::vector<int32_t>(channels, std::numeric_limits<int32_t>::min());
         for (size_t n = 0; n < result.size(); n += channels) {
             for (int ch = 0; ch < channels; ++ch) {
@@ -134,28 +578,111 @@ struct audio_mixer::impl : boost::noncopyable
             graph_->set_tag(diagnostics::tag_severity::WARNING, "audio-clipping");
         }
 
-        state_["volume"] = std::move(max);
-
         graph_->set_value("volume",
                           static_cast<double>(*boost::max_element(max)) / std::numeric_limits<int32_t>::max());
 
+        state_["volume"] = std::move(max);
+
         return std::move(result);
     }
+
+    void update_meters(int nb_samples)
+    {
+        for (auto& p : meters_) {
+            p.second.update(nb_samples);
+
+            const auto prefix        = "layer/" + boost::lexical_cast<std::string>(p.first);
+            state_[prefix + "/peak"] = p.second.peak();
+            state_[prefix + "/rms"]  = p.second.rms();
+
+            // Without oversampling there is no true peak, only the sample peak above.
+            if (ballistics_.true_peak) {
+                state_[prefix + "/true-peak"] = p.second.true_peak();
+            }
+        }
+    }
+
+    void update_limiter(const video_format_desc& format_desc, limiter_settings settings, std::vector<float>& samples)
+    {
+        if (!settings.enabled) {
+            limiter_.reset();
+            return;
+        }
+
+        // Never further than the shortest tick ahead, and not at all without the next tick's mix.
+        const auto sample_rate = format_desc.audio_sample_rate;
+        const auto max_frames  = holding_ ? std::floor(sample_rate / format_desc.fps) - 1.0 : 0.0;
+        settings.look_ahead    = std::max(0.0, std::min(settings.look_ahead, max_frames / sample_rate));
+
+        if (!limiter_ || limiter_->channels() != format_desc.audio_channels || limiter_->sample_rate() != sample_rate ||
+            limiter_->settings() != settings) {
+            limiter_.reset(new audio_limiter(format_desc.audio_channels, sample_rate, settings));
+        }
+
+        if (holding_) {
+            limiter_->process(samples.data(), samples.size(), mixed_.data(), mixed_.size());
+        } else {
+            limiter_->process(samples.data(), samples.size(), nullptr, 0);
+        }
+
+        graph_->set_value("limiter", limiter_->gain_reduction() / 20.0);
+        state_["limiter/gain-reduction"] = limiter_->gain_reduction();
+    }
+
+    void update_loudness(const video_format_desc& format_desc, const std::vector<float>& samples)
+    {
+        const auto channels    = format_desc.audio_channels;
+        const auto sample_rate = format_desc.audio_sample_rate;
+
+        if (!loudness_meter_ || loudness_meter_->channels() != channels || loudness_sample_rate_ != sample_rate) {
+            loudness_meter_.reset(new loudness_meter(loudness_weights(loudness_layout_, channels), sample_rate));
+            loudness_sample_rate_ = sample_rate;
+        }
+
+        if (loudness_reset_.exchange(false)) {
+            loudness_meter_->reset();
+        }
+
+        loudness_meter_->process(samples.data(), samples.size());
+
+        const auto loudness = loudness_meter_->get();
+        {
+            std::lock_guard<std::mutex> lock(loudness_mutex_);
+            loudness_ = loudness;
+        }
+
+        state_["loudness/momentary"]  = loudness.momentary;
+        state_["loudness/short-term"] = loudness.short_term;
+        state_["loudness/integrated"] = loudness.integrated;
+        state_["loudness/range"]      = loudness.range;
+        state_["loudness/true-peak"]  = loudness.true_peak;
+    }
 };
 
 audio_mixer::audio_mixer(spl::shared_ptr<diagnostics::graph> graph)
     : impl_(new impl(std::move(graph)))
 {
 }
+void                 audio_mixer::begin_layer(int index) { impl_->begin_layer(index); }
 void                 audio_mixer::push(const frame_transform& transform) { impl_->push(transform); }
 void                 audio_mixer::visit(const const_frame& frame) { impl_->visit(frame); }
 void                 audio_mixer::pop() { impl_->pop(); }
 void                 audio_mixer::set_master_volume(float volume) { impl_->set_master_volume(volume); }
 float                audio_mixer::get_master_volume() { return impl_->get_master_volume(); }
-array<const int32_t> audio_mixer::operator()(const video_format_desc& format_desc, int nb_samples)
+array<const int32_t> audio_mixer::operator()(const video_format_desc& format_desc, int nb_samples, bool look_ahead)
 {
-    return impl_->mix(format_desc, nb_samples);
+    return impl_->mix(format_desc, nb_samples, look_ahead);
 }
+bool                  audio_mixer::holding() const { return impl_->holding_; }
+array<const int32_t>  audio_mixer::released() const { return impl_->released_; }
 const monitor::state& audio_mixer::state() const { return impl_->state_; }
+loudness              audio_mixer::get_loudness() const { return impl_->get_loudness(); }
+void                  audio_mixer::reset_loudness() { impl_->reset_loudness(); }
+void                  audio_mixer::set_limiter(const limiter_settings& settings) { impl_->set_limiter(settings); }
+limiter_settings      audio_mixer::get_limiter() const { return impl_->get_limiter(); }
+void                  audio_mixer::set_layer_delays(std::map<int, int> delays)
+{
+    impl_->set_layer_delays(std::move(delays));
+}
 
 }} // namespace caspar::core
@@ -21,6 +21,9 @@
 
 #pragma once
 
+#include "audio_limiter.h"
+#include "loudness_meter.h"
+
 #include <common/array.h>
 #include <common/forward.h>
 #include <common/memory.h>
@@ -29,6 +32,7 @@
 #include <core/monitor/monitor.h>
 
 #include <cstdint>
+#include <map>
 #include <vector>
 
 FORWARD2(caspar, diagnostics, class graph);
@@ -43,11 +47,28 @@ class audio_mixer final : public frame_visitor
   public:
     audio_mixer(spl::shared_ptr<::caspar::diagnostics::graph> graph);
 
-    array<const int32_t>  operator()(const struct video_format_desc& format_desc, int nb_samples);
+    // Mixes the frames visited this tick and returns the mix. With look_ahead and the limiter enabled the mix of the
+    // previous tick is returned instead, so that the limiter can look ahead into this one. It is empty on the first
+    // tick that holds.
+    array<const int32_t>  operator()(const struct video_format_desc& format_desc, int nb_samples, bool look_ahead);
+    bool                  holding() const;  // Whether the last call returned the mix of the previous tick.
+    array<const int32_t>  released() const; // The previous tick's mix when the last call ended a hold, or empty.
     void                  set_master_volume(float volume);
     float                 get_master_volume();
     const monitor::state& state() const;
 
+    loudness get_loudness() const;
+    void     reset_loudness();
+
+    void             set_limiter(const limiter_settings& settings);
+    limiter_settings get_limiter() const;
+
+    // Delays the audio of each layer by the given number of sample frames, from the next tick on.
+    void set_layer_delays(std::map<int, int> delays);
+
+    // Frames visited after this are metered as the layer with the given index.
+    void begin_layer(int index);
+
     virtual void push(const struct frame_transform& transform);
     virtual void visit(const class const_frame& frame);
     virtual void pop();
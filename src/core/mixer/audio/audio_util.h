@@ -21,41 +21,158 @@
 
 #pragma once
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <tmmintrin.h>
+#endif
+
 #include <algorithm>
+#include <cstddef>
 #include <cstdint>
-#include <vector>
 
 namespace caspar { namespace core {
 
-template <typename T>
-std::vector<int8_t> audio_32_to_24(const T& audio_data)
+// Converters from the mixer's 32 bit samples. They write size samples to a caller owned buffer, so consumers can
+// convert into buffers they reuse every frame.
+
+// Triangular noise of one 16 bit step for dithered conversion. Keep one per stream, the state carries between calls.
+class tpdf_dither final
 {
-    auto size    = std::distance(std::begin(audio_data), std::end(audio_data));
-    auto input8  = reinterpret_cast<const int8_t*>(&(*std::begin(audio_data)));
-    auto output8 = std::vector<int8_t>();
+  public:
+    tpdf_dither(std::uint32_t seed = 0x9E3779B9)
+    {
+        for (auto& state : state_) {
+            seed  = seed * 1664525 + 1013904223;
+            state = seed | 1;
+        }
+    }
 
-    output8.reserve(size * 3);
-    for (int n = 0; n < size; ++n) {
-        output8.push_back(input8[n * 4 + 1]);
-        output8.push_back(input8[n * 4 + 2]);
-        output8.push_back(input8[n * 4 + 3]);
+    // Xorshift32 on four lanes, each noise value is the difference of the two 16 bit halves of a lane. Converters
+    // step register copies of two independent sets of lanes, which hides the latency of each step, and store them
+    // back once.
+    static __m128i next(__m128i& lanes)
+    {
+        lanes = _mm_xor_si128(lanes, _mm_slli_epi32(lanes, 13));
+        lanes = _mm_xor_si128(lanes, _mm_srli_epi32(lanes, 17));
+        lanes = _mm_xor_si128(lanes, _mm_slli_epi32(lanes, 5));
+        return _mm_sub_epi32(_mm_and_si128(lanes, _mm_set1_epi32(0xFFFF)), _mm_srli_epi32(lanes, 16));
     }
 
-    return output8;
+    __m128i lanes(int set) const { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(state_ + set * 4)); }
+    void    lanes(int set, __m128i lanes) { _mm_storeu_si128(reinterpret_cast<__m128i*>(state_ + set * 4), lanes); }
+
+    std::int32_t next_scalar()
+    {
+        auto x = state_[0];
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        state_[0] = x;
+        return static_cast<std::int32_t>(x & 0xFFFF) - static_cast<std::int32_t>(x >> 16);
+    }
+
+  private:
+    std::uint32_t state_[8];
+};
+
+// Keeps the upper 16 bits.
+inline void audio_32_to_16(const std::int32_t* src, std::int16_t* dest, std::size_t size)
+{
+    std::size_t n = 0;
+    for (; n + 8 <= size; n += 8) {
+        auto a = _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n + 0)), 16);
+        auto b = _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n + 4)), 16);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + n), _mm_packs_epi32(a, b));
+    }
+    for (; n < size; ++n) {
+        dest[n] = static_cast<std::int16_t>(src[n] >> 16);
+    }
 }
 
-template <typename T>
-std::vector<int16_t> audio_32_to_16(const T& audio_data)
+// Adds dither and rounds to the nearest 16 bit value, saturating. The sums are taken at half scale so they can't
+// overflow.
+inline void audio_32_to_16(const std::int32_t* src, std::int16_t* dest, std::size_t size, tpdf_dither& dither)
 {
-    auto size     = std::distance(std::begin(audio_data), std::end(audio_data));
-    auto input32  = &(*std::begin(audio_data));
-    auto output16 = std::vector<int16_t>();
+    const auto half   = _mm_set1_epi32(0x4000);
+    auto       lanes0 = dither.lanes(0);
+    auto       lanes1 = dither.lanes(1);
 
-    output16.reserve(size);
-    for (int n = 0; n < size; ++n)
-        output16.push_back((input32[n] >> 16) & 0xFFFF);
+    std::size_t n = 0;
+    for (; n + 8 <= size; n += 8) {
+        auto a = _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n + 0)), 1);
+        auto b = _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n + 4)), 1);
+        a      = _mm_add_epi32(_mm_add_epi32(a, _mm_srai_epi32(tpdf_dither::next(lanes0), 1)), half);
+        b      = _mm_add_epi32(_mm_add_epi32(b, _mm_srai_epi32(tpdf_dither::next(lanes1), 1)), half);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + n),
+                         _mm_packs_epi32(_mm_srai_epi32(a, 15), _mm_srai_epi32(b, 15)));
+    }
+    dither.lanes(0, lanes0);
+    dither.lanes(1, lanes1);
+    for (; n < size; ++n) {
+        auto value = ((src[n] >> 1) + (dither.next_scalar() >> 1) + 0x4000) >> 15;
+        dest[n]    = static_cast<std::int16_t>(std::max(-32768, std::min(32767, value)));
+    }
+}
+
+// Keeps the upper 24 bits, packed little endian in 3 bytes.
+inline void audio_32_to_24(const std::int32_t* src, std::int8_t* dest, std::size_t size)
+{
+    const auto shuffle = _mm_setr_epi8(1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, -1, -1, -1, -1);
 
-    return output16;
+    // Each store writes 16 bytes of which 12 are kept, so stop while the 4 extra bytes still land inside dest.
+    std::size_t n = 0;
+    for (; n + 6 <= size; n += 4) {
+        auto x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + n * 3), _mm_shuffle_epi8(x, shuffle));
+    }
+    for (; n < size; ++n) {
+        auto input8     = reinterpret_cast<const std::int8_t*>(src + n);
+        dest[n * 3 + 0] = input8[1];
+        dest[n * 3 + 1] = input8[2];
+        dest[n * 3 + 2] = input8[3];
+    }
+}
+
+// Scales to [-1.0, 1.0], the largest samples round up to 1.0 in single precision.
+inline void audio_32_to_float(const std::int32_t* src, float* dest, std::size_t size)
+{
+    const auto scale = _mm_set1_ps(1.0f / 2147483648.0f);
+
+    std::size_t n = 0;
+    for (; n + 4 <= size; n += 4) {
+        auto x = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n)));
+        _mm_storeu_ps(dest + n, _mm_mul_ps(x, scale));
+    }
+    for (; n < size; ++n) {
+        dest[n] = static_cast<float>(src[n]) * (1.0f / 2147483648.0f);
+    }
+}
+
+// Splits nb_samples interleaved sample frames into one buffer per channel.
+template <typename T>
+void audio_deinterleave(const T* src, T* const* dest, int channels, std::size_t nb_samples)
+{
+    for (int c = 0; c < channels; ++c) {
+        auto in  = src + c;
+        auto out = dest[c];
+        for (std::size_t n = 0; n < nb_samples; ++n) {
+            out[n] = in[n * channels];
+        }
+    }
+}
+
+// Joins one buffer per channel into nb_samples interleaved sample frames.
+template <typename T>
+void audio_interleave(const T* const* src, T* dest, int channels, std::size_t nb_samples)
+{
+    for (int c = 0; c < channels; ++c) {
+        auto in  = src[c];
+        auto out = dest + c;
+        for (std::size_t n = 0; n < nb_samples; ++n) {
+            out[n * channels] = in[n];
+        }
+    }
 }
 
-}} // namespace caspar::core
\ No newline at end of file
+}} // namespace caspar::core
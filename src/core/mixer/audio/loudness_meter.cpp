@@ -0,0 +1,327 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "../../StdAfx.h"
+#include "loudness_meter.h"
+#include "audio_meter.h"
+
+#include <common/except.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+namespace caspar { namespace core {
+
+namespace {
+
+const double floor_lufs       = -144.0;
+const double absolute_gate    = -70.0;
+const double full_scale       = 1.0 / 2147483648.0;
+const int    momentary_count  = 4;    // 100 ms blocks in the momentary window.
+const int    short_term_count = 30;   // 100 ms blocks in the short-term window.
+const double bin_width        = 0.1;  // LU.
+const int    bin_count        = 1000; // From the absolute gate up to +30 LUFS.
+
+struct biquad
+{
+    double b0, b1, b2, a1, a2;
+};
+
+// BS.1770 K-weighting, the pre-filter shelf followed by the RLB high-pass, derived for any sample rate.
+std::array<biquad, 2> k_weighting(int sample_rate)
+{
+    const auto pi = 3.14159265358979323846;
+
+    std::array<biquad, 2> result;
+    {
+        const auto f0 = 1681.974450955533;
+        const auto q  = 0.7071752369554196;
+        const auto k  = std::tan(pi * f0 / sample_rate);
+        const auto vh = std::pow(10.0, 3.999843853973347 / 20.0);
+        const auto vb = std::pow(vh, 0.4996667741545416);
+        const auto a0 = 1.0 + k / q + k * k;
+
+        result[0] = biquad{(vh + vb * k / q + k * k) / a0,
+                           2.0 * (k * k - vh) / a0,
+                           (vh - vb * k / q + k * k) / a0,
+                           2.0 * (k * k - 1.0) / a0,
+                           (1.0 - k / q + k * k) / a0};
+    }
+    {
+        const auto f0 = 38.13547087602444;
+        const auto q  = 0.5003270373238773;
+        const auto k  = std::tan(pi * f0 / sample_rate);
+        const auto a0 = 1.0 + k / q + k * k;
+
+        result[1] = biquad{1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0};
+    }
+    return result;
+}
+
+double to_lufs(double power)
+{
+    return power > 0.0 ? std::max(-0.691 + 10.0 * std::log10(power), floor_lufs) : floor_lufs;
+}
+
+double to_power(double lufs) { return std::pow(10.0, (lufs + 0.691) / 10.0); }
+
+// Gating blocks above the absolute gate, binned by loudness. Bins keep the sum of their powers, so gated means are
+// exact except for the bin that the gate falls in.
+struct histogram
+{
+    std::array<double, bin_count>       power{};
+    std::array<std::int64_t, bin_count> count{};
+
+    void add(double value)
+    {
+        const auto lufs = to_lufs(value);
+        if (lufs <= absolute_gate) {
+            return;
+        }
+        const auto bin = std::min(static_cast<int>((lufs - absolute_gate) / bin_width), bin_count - 1);
+        power[bin] += value;
+        count[bin] += 1;
+    }
+
+    bool above(int bin, double gate_power) const { return count[bin] > 0 && power[bin] / count[bin] >= gate_power; }
+
+    // Mean power of the blocks at or above the gate.
+    double mean(double gate) const
+    {
+        const auto   gate_power = to_power(gate);
+        double       sum        = 0.0;
+        std::int64_t n          = 0;
+        for (auto bin = 0; bin < bin_count; ++bin) {
+            if (above(bin, gate_power)) {
+                sum += power[bin];
+                n += count[bin];
+            }
+        }
+        return n > 0 ? sum / n : 0.0;
+    }
+
+    // Loudness at the given fraction of the blocks at or above the gate.
+    double percentile(double gate, double fraction) const
+    {
+        const auto   gate_power = to_power(gate);
+        std::int64_t total      = 0;
+        for (auto bin = 0; bin < bin_count; ++bin) {
+            if (above(bin, gate_power)) {
+                total += count[bin];
+            }
+        }
+
+        std::int64_t n = 0;
+        for (auto bin = 0; bin < bin_count; ++bin) {
+            if (above(bin, gate_power)) {
+                n += count[bin];
+                if (n >= fraction * total) {
+                    return to_lufs(power[bin] / count[bin]);
+                }
+            }
+        }
+        return floor_lufs;
+    }
+};
+
+meter_ballistics true_peak_ballistics()
+{
+    meter_ballistics result;
+    result.peak_release = 0.0;
+    result.true_peak    = true;
+    return result;
+}
+
+} // namespace
+
+struct loudness_meter::impl
+{
+    const std::vector<double>   weights_;
+    const int                   channels_;
+    const int                   sample_rate_;
+    const std::array<biquad, 2> filter_;
+    const int                   block_size_;
+
+    // Filter state, two delay elements per stage and channel.
+    std::vector<std::array<double, 4>> state_;
+    std::vector<double>                sum_;
+    int                                block_frames_ = 0;
+
+    std::array<double, short_term_count> blocks_{};
+    int                                  block_index_ = 0;
+    std::int64_t                         block_total_ = 0;
+
+    histogram   integrated_;
+    histogram   range_;
+    audio_meter true_peak_;
+    loudness    loudness_;
+
+    impl(std::vector<double> weights, int sample_rate)
+        : weights_(std::move(weights))
+        , channels_(static_cast<int>(weights_.size()))
+        , sample_rate_(sample_rate)
+        , filter_(k_weighting(sample_rate))
+        , block_size_(sample_rate / 10)
+        , state_(channels_, std::array<double, 4>{})
+        , sum_(channels_, 0.0)
+        , true_peak_(channels_, sample_rate, true_peak_ballistics())
+    {
+    }
+
+    void process(const float* samples, std::size_t size)
+    {
+        const auto frames = size / channels_;
+
+        for (std::size_t n = 0; n < frames; ++n) {
+            for (auto ch = 0; ch < channels_; ++ch) {
+                if (weights_[ch] == 0.0) {
+                    continue;
+                }
+
+                auto& z = state_[ch];
+                auto  x = samples[n * channels_ + ch] * full_scale;
+
+                const auto& s0 = filter_[0];
+                const auto  y0 = s0.b0 * x + z[0];
+                z[0]           = s0.b1 * x - s0.a1 * y0 + z[1];
+                z[1]           = s0.b2 * x - s0.a2 * y0;
+
+                const auto& s1 = filter_[1];
+                const auto  y1 = s1.b0 * y0 + z[2];
+                z[2]           = s1.b1 * y0 - s1.a1 * y1 + z[3];
+                z[3]           = s1.b2 * y0 - s1.a2 * y1;
+
+                sum_[ch] += y1 * y1;
+            }
+
+            if (++block_frames_ == block_size_) {
+                end_block();
+            }
+        }
+
+        true_peak_.process(samples, size);
+        true_peak_.update(static_cast<int>(frames));
+
+        const auto& true_peak = true_peak_.true_peak();
+        loudness_.true_peak   = *std::max_element(true_peak.begin(), true_peak.end());
+    }
+
+    void end_block()
+    {
+        auto power = 0.0;
+        for (auto ch = 0; ch < channels_; ++ch) {
+            power += weights_[ch] * sum_[ch] / block_size_;
+            sum_[ch] = 0.0;
+
+            // Keep the filters out of denormals during silence.
+            for (auto& z : state_[ch]) {
+                if (std::abs(z) < 1e-20) {
+                    z = 0.0;
+                }
+            }
+        }
+        block_frames_ = 0;
+
+        blocks_[block_index_] = power;
+        block_index_          = (block_index_ + 1) % short_term_count;
+        block_total_ += 1;
+
+        auto momentary = 0.0;
+        for (auto n = 1; n <= momentary_count; ++n) {
+            momentary += blocks_[(block_index_ + short_term_count - n) % short_term_count];
+        }
+        momentary /= momentary_count;
+
+        auto short_term = 0.0;
+        for (auto block : blocks_) {
+            short_term += block;
+        }
+        short_term /= short_term_count;
+
+        loudness_.momentary  = to_lufs(momentary);
+        loudness_.short_term = to_lufs(short_term);
+
+        // Gating blocks overlap by 75%, short-term values are taken every 100 ms as EBU Tech 3342 asks for.
+        if (block_total_ >= momentary_count) {
+            integrated_.add(momentary);
+            loudness_.integrated = to_lufs(integrated_.mean(to_lufs(integrated_.mean(absolute_gate)) - 10.0));
+        }
+        if (block_total_ >= short_term_count) {
+            range_.add(short_term);
+            const auto gate = to_lufs(range_.mean(absolute_gate)) - 20.0;
+            const auto high = range_.percentile(gate, 0.95);
+            const auto low  = range_.percentile(gate, 0.10);
+            loudness_.range = high > floor_lufs ? high - low : 0.0;
+        }
+    }
+
+    void reset()
+    {
+        integrated_ = histogram();
+        range_      = histogram();
+        true_peak_  = audio_meter(channels_, sample_rate_, true_peak_ballistics());
+
+        loudness_.integrated = floor_lufs;
+        loudness_.range      = 0.0;
+        loudness_.true_peak  = floor_lufs;
+    }
+};
+
+loudness_meter::loudness_meter(std::vector<double> weights, int sample_rate)
+    : impl_(new impl(std::move(weights), sample_rate))
+{
+}
+loudness_meter::loudness_meter(loudness_meter&& other)
+    : impl_(std::move(other.impl_))
+{
+}
+loudness_meter::~loudness_meter() {}
+loudness_meter& loudness_meter::operator=(loudness_meter&& other)
+{
+    impl_ = std::move(other.impl_);
+    return *this;
+}
+void     loudness_meter::process(const float* samples, std::size_t size) { impl_->process(samples, size); }
+void     loudness_meter::reset() { impl_->reset(); }
+int      loudness_meter::channels() const { return impl_->channels_; }
+loudness loudness_meter::get() const { return impl_->loudness_; }
+
+std::vector<double> loudness_weights(const std::wstring& layout, int channels)
+{
+    std::vector<double> result(channels, 0.0);
+
+    if (layout == L"all") {
+        std::fill(result.begin(), result.end(), 1.0);
+    } else if (layout == L"stereo") {
+        std::fill_n(result.begin(), std::min(channels, 2), 1.0);
+    } else if (layout == L"5.1") {
+        // Surround channels are weighted +1.5 dB, LFE is left out.
+        const double surround[] = {1.0, 1.0, 1.0, 0.0, 1.41, 1.41};
+        std::copy_n(std::begin(surround), std::min(channels, 6), result.begin());
+    } else {
+        CASPAR_THROW_EXCEPTION(user_error() << msg_info(L"Invalid loudness layout: " + layout));
+    }
+
+    return result;
+}
+
+}} // namespace caspar::core
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace caspar { namespace core {
+
+// Loudness in LUFS, range in LU and true peak in dBTP. Values without enough audio to measure are -144.
+struct loudness
+{
+    double momentary  = -144.0; // 400 ms window.
+    double short_term = -144.0; // 3 s window.
+    double integrated = -144.0; // Gated, since the last reset.
+    double range      = 0.0;    // Loudness range (EBU Tech 3342), since the last reset.
+    double true_peak  = -144.0; // Maximum since the last reset.
+};
+
+// ITU-R BS.1770 / EBU R128 loudness of interleaved audio.
+class loudness_meter final
+{
+  public:
+    // weights holds the BS.1770 weighting of each channel, 0 leaves a channel out.
+    loudness_meter(std::vector<double> weights, int sample_rate);
+    loudness_meter(loudness_meter&& other);
+    ~loudness_meter();
+
+    loudness_meter& operator=(loudness_meter&& other);
+
+    // Adds interleaved samples where full scale is 2^31. size must be a multiple of the channel count.
+    void process(const float* samples, std::size_t size);
+
+    // Restarts integrated loudness, loudness range and true peak.
+    void reset();
+
+    int      channels() const;
+    loudness get() const;
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> impl_;
+};
+
+// Weights for "stereo" (the first two channels), "5.1" (L R C LFE Ls Rs) or "all" channels at unity.
+std::vector<double> loudness_weights(const std::wstring& layout, int channels);
+
+}} // namespace caspar::core
@@ -24,6 +24,8 @@
 #include <core/frame/frame.h>
 #include <core/frame/frame_factory.h>
 #include <core/frame/frame_visitor.h>
+#include <core/frame/pixel_format.h>
+#include <core/monitor/monitor.h>
 
 #include <cstdint>
 #include <future>
@@ -48,6 +50,11 @@ class image_mixer
     virtual std::future<array<const uint8_t>> operator()(const struct video_format_desc& format_desc) = 0;
 
     virtual class mutable_frame create_frame(const void* tag, const struct pixel_format_desc& desc) = 0;
+
+    // Depth of the mixed images returned by operator().
+    virtual color_depth depth() const = 0;
+
+    virtual const monitor::state& state() const = 0;
 };
 
 }} // namespace caspar::core
\ No newline at end of file
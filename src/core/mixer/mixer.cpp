@@ -35,6 +35,7 @@
 #include <common/future.h>
 #include <common/timer.h>
 
+#include <core/frame/audio_delay.h>
 #include <core/frame/draw_frame.h>
 #include <core/frame/frame_factory.h>
 #include <core/frame/frame_transform.h>
@@ -45,6 +46,7 @@
 
 #include <tbb/concurrent_queue.h>
 
+#include <algorithm>
 #include <atomic>
 #include <mutex>
 #include <unordered_map>
@@ -58,11 +60,35 @@ struct mixer::impl : boost::noncopyable
     int                                  channel_index_;
     spl::shared_ptr<diagnostics::graph>  graph_;
     audio_mixer                          audio_mixer_{graph_};
-    spl::shared_ptr<image_mixer>         image_mixer_;
-    std::queue<std::future<const_frame>> buffer_;
+    std::shared_ptr<image_mixer>         image_mixer_;
+    cpu_frame_factory                    cpu_frame_factory_;
+
+    // Images are a tick behind. The audio of a tick is stored with its image, or when the audio mixer holds its mix
+    // for the limiter, with the image of the tick before. When the hold ends both mixes are handed out in one tick.
+    struct buffered_frame
+    {
+        std::future<array<const uint8_t>> image;
+        pixel_format_desc                 desc;
+        array<const int32_t>              audio;
+    };
+    std::queue<buffered_frame> buffer_;
+
+    // Audio delays per layer in sample frames, negative when the audio is early. Early audio holds the layer's
+    // images back for whole frames in a ring that is only resized when the delay changes.
+    struct held_frames
+    {
+        std::vector<draw_frame> frames;
+        std::size_t             pos = 0;
+    };
+    mutable std::mutex         audio_delays_mutex_;
+    std::map<int, int>         audio_delays_;
+    bool                       audio_delays_changed_ = true;
+    video_format_desc          delays_format_desc_;
+    std::map<int, int>         video_frames_;
+    std::map<int, held_frames> held_frames_;
 
   public:
-    impl(int channel_index, spl::shared_ptr<diagnostics::graph> graph, spl::shared_ptr<image_mixer> image_mixer)
+    impl(int channel_index, spl::shared_ptr<diagnostics::graph> graph, std::shared_ptr<image_mixer> image_mixer)
         : channel_index_(channel_index)
         , graph_(std::move(graph))
         , image_mixer_(std::move(image_mixer))
@@ -71,54 +97,185 @@ struct mixer::impl : boost::noncopyable
 
     const_frame operator()(std::map<int, draw_frame> frames, const video_format_desc& format_desc, int nb_samples)
     {
+        if (!image_mixer_) {
+            return mix_audio_only(std::move(frames), format_desc, nb_samples);
+        }
+
+        update_delays(frames, format_desc);
+
         for (auto& frame : frames) {
+            audio_mixer_.begin_layer(frame.first);
             frame.second.accept(audio_mixer_);
+
+            auto held = held_frames_.find(frame.first);
+            if (held != held_frames_.end()) {
+                std::swap(frame.second, held->second.frames[held->second.pos]);
+                held->second.pos = (held->second.pos + 1) % held->second.frames.size();
+            }
             frame.second.transform().image_transform.layer_depth = 1;
             frame.second.accept(*image_mixer_);
         }
 
-        auto image = (*image_mixer_)(format_desc);
-        auto audio = audio_mixer_(format_desc, nb_samples);
+        const auto depth = image_mixer_->depth();
+        auto       desc  = pixel_format_desc(pixel_format::bgra, depth);
+        desc.planes.push_back(
+            pixel_format_desc::plane(format_desc.width, format_desc.height, 4 * bytes_per_sample(depth)));
+        buffer_.push(buffered_frame{(*image_mixer_)(format_desc), desc, array<const int32_t>{}});
 
-        state_.insert_or_assign("audio", audio_mixer_.state());
+        auto audio = audio_mixer_(format_desc, nb_samples, true);
+        if (audio.size() > 0) {
+            (audio_mixer_.holding() ? buffer_.front() : buffer_.back()).audio = std::move(audio);
+        }
+        auto released = audio_mixer_.released();
+        if (released.size() > 0) {
+            buffer_.front().audio = std::move(released);
+        }
 
-        buffer_.push(std::async(
-            std::launch::deferred,
-            [image = std::move(image), audio = std::move(audio), graph = graph_, format_desc, tag = this]() mutable {
-                auto desc = pixel_format_desc(pixel_format::bgra);
-                desc.planes.push_back(pixel_format_desc::plane(format_desc.width, format_desc.height, 4));
-                std::vector<array<const uint8_t>> image_data;
-                image_data.emplace_back(std::move(image.get()));
-                return const_frame(std::move(image_data), std::move(audio), desc);
-            }));
+        state_.clear();
+        state_.insert_or_assign("audio", audio_mixer_.state());
+        state_.insert_or_assign("image", image_mixer_->state());
 
         if (buffer_.size() < 2) {
             return const_frame{};
         }
 
-        auto frame = std::move(buffer_.front().get());
+        auto frame = std::move(buffer_.front());
         buffer_.pop();
-        return frame;
+
+        std::vector<array<const uint8_t>> image_data;
+        image_data.emplace_back(std::move(frame.image.get()));
+        return const_frame(std::move(image_data), std::move(frame.audio), frame.desc);
+    }
+
+    const_frame mix_audio_only(std::map<int, draw_frame> frames, const video_format_desc& format_desc, int nb_samples)
+    {
+        // Without images audio can't be early, negative delays are ignored.
+        std::map<int, int> delays;
+        if (take_audio_delays(format_desc, delays)) {
+            for (auto& delay : delays) {
+                delay.second = std::max(delay.second, 0);
+            }
+            audio_mixer_.set_layer_delays(std::move(delays));
+        }
+
+        for (auto& frame : frames) {
+            audio_mixer_.begin_layer(frame.first);
+            frame.second.accept(audio_mixer_);
+        }
+
+        // Nothing else is a tick behind, the mix isn't held for the limiter to look ahead.
+        auto audio = audio_mixer_(format_desc, nb_samples, false);
+
+        state_.clear();
+        state_.insert_or_assign("audio", audio_mixer_.state());
+
+        // There is no render to wait for, the frame goes out in the tick it was mixed in.
+        auto desc = pixel_format_desc(pixel_format::bgra);
+        desc.planes.push_back(pixel_format_desc::plane(0, 0, 4));
+        std::vector<array<const uint8_t>> image_data;
+        image_data.emplace_back(array<const uint8_t>{});
+        return const_frame(std::move(image_data), std::move(audio), desc);
     }
 
     void set_master_volume(float volume) { audio_mixer_.set_master_volume(volume); }
 
     float get_master_volume() { return audio_mixer_.get_master_volume(); }
+
+    loudness get_loudness() const { return audio_mixer_.get_loudness(); }
+
+    void reset_loudness() { audio_mixer_.reset_loudness(); }
+
+    void set_limiter(const limiter_settings& settings) { audio_mixer_.set_limiter(settings); }
+
+    limiter_settings get_limiter() const { return audio_mixer_.get_limiter(); }
+
+    void set_audio_delay(int layer, int delay)
+    {
+        std::lock_guard<std::mutex> lock(audio_delays_mutex_);
+        if (delay == 0) {
+            audio_delays_.erase(layer);
+        } else {
+            audio_delays_[layer] = delay;
+        }
+        audio_delays_changed_ = true;
+    }
+
+    int get_audio_delay(int layer) const
+    {
+        std::lock_guard<std::mutex> lock(audio_delays_mutex_);
+        auto                        it = audio_delays_.find(layer);
+        return it != audio_delays_.end() ? it->second : 0;
+    }
+
+    // Hands out the delays when they or the format changed since the last call, so that ticks don't rebuild them.
+    bool take_audio_delays(const video_format_desc& format_desc, std::map<int, int>& delays)
+    {
+        std::lock_guard<std::mutex> lock(audio_delays_mutex_);
+        if (!audio_delays_changed_ && format_desc == delays_format_desc_) {
+            return false;
+        }
+        delays                = audio_delays_;
+        audio_delays_changed_ = false;
+        delays_format_desc_   = format_desc;
+        return true;
+    }
+
+    void update_delays(const std::map<int, draw_frame>& frames, const video_format_desc& format_desc)
+    {
+        std::map<int, int> delays;
+        if (take_audio_delays(format_desc, delays)) {
+            std::map<int, int> audio_samples;
+            video_frames_.clear();
+            for (auto& delay : delays) {
+                auto split                 = split_audio_delay(delay.second, format_desc);
+                audio_samples[delay.first] = split.audio_samples;
+                video_frames_[delay.first] = split.video_frames;
+            }
+            audio_mixer_.set_layer_delays(std::move(audio_samples));
+        }
+
+        // Rings of layers without a frame this tick are dropped rather than showing stale images when they return.
+        for (auto it = held_frames_.begin(); it != held_frames_.end();) {
+            auto count = video_frames_.find(it->first);
+            if (count == video_frames_.end() || static_cast<int>(it->second.frames.size()) != count->second ||
+                frames.find(it->first) == frames.end()) {
+                it = held_frames_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        // A new ring starts out with the layer's current frame, which is repeated until the ring has filled.
+        for (auto& count : video_frames_) {
+            auto frame = frames.find(count.first);
+            if (count.second > 0 && frame != frames.end() && held_frames_.find(count.first) == held_frames_.end()) {
+                held_frames_[count.first].frames.assign(count.second, frame->second);
+            }
+        }
+    }
 };
 
-mixer::mixer(int channel_index, spl::shared_ptr<diagnostics::graph> graph, spl::shared_ptr<image_mixer> image_mixer)
+mixer::mixer(int channel_index, spl::shared_ptr<diagnostics::graph> graph, std::shared_ptr<image_mixer> image_mixer)
     : impl_(new impl(channel_index, std::move(graph), std::move(image_mixer)))
 {
 }
 void        mixer::set_master_volume(float volume) { impl_->set_master_volume(volume); }
 float       mixer::get_master_volume() { return impl_->get_master_volume(); }
+loudness    mixer::get_loudness() const { return impl_->get_loudness(); }
+void        mixer::reset_loudness() { impl_->reset_loudness(); }
 const_frame mixer::operator()(std::map<int, draw_frame> frames, const video_format_desc& format_desc, int nb_samples)
 {
     return (*impl_)(std::move(frames), format_desc, nb_samples);
 }
 mutable_frame mixer::create_frame(const void* tag, const pixel_format_desc& desc)
 {
+    if (!impl_->image_mixer_) {
+        return impl_->cpu_frame_factory_.create_frame(tag, desc);
+    }
     return impl_->image_mixer_->create_frame(tag, desc);
 }
 const monitor::state& mixer::state() const { return impl_->state_; }
+void                  mixer::set_limiter(const limiter_settings& settings) { impl_->set_limiter(settings); }
+limiter_settings      mixer::get_limiter() const { return impl_->get_limiter(); }
+void                  mixer::set_audio_delay(int layer, int delay) { impl_->set_audio_delay(layer, delay); }
+int                   mixer::get_audio_delay(int layer) const { return impl_->get_audio_delay(layer); }
 }} // namespace caspar::core
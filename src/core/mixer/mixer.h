@@ -21,6 +21,8 @@
 
 #pragma once
 
+#include "audio/audio_limiter.h"
+#include "audio/loudness_meter.h"
 #include "image/blend_modes.h"
 
 #include <common/forward.h>
@@ -44,15 +46,27 @@ class mixer final
     mixer& operator=(const mixer&);
 
   public:
+    // Without an image_mixer only audio is mixed and the frames carry no image.
     explicit mixer(int                                         channel_index,
                    spl::shared_ptr<caspar::diagnostics::graph> graph,
-                   spl::shared_ptr<image_mixer>                image_mixer);
+                   std::shared_ptr<image_mixer>                image_mixer);
 
     const_frame operator()(std::map<int, draw_frame> frames, const video_format_desc& format_desc, int nb_samples);
 
     void  set_master_volume(float volume);
     float get_master_volume();
 
+    loudness get_loudness() const;
+    void     reset_loudness();
+
+    void             set_limiter(const limiter_settings& settings);
+    limiter_settings get_limiter() const;
+
+    // Delays a layer's audio against its video by delay sample frames. When delay is negative the audio is early and
+    // the layer's video is held back for whole frames instead.
+    void set_audio_delay(int layer, int delay);
+    int  get_audio_delay(int layer) const;
+
     mutable_frame create_frame(const void* tag, const pixel_format_desc& desc);
 
     const monitor::state& state() const;
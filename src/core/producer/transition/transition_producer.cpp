@@ -32,10 +32,32 @@
 
 #include <tbb/parallel_invoke.h>
 
+#include <cmath>
 #include <future>
 
 namespace caspar { namespace core {
 
+namespace {
+
+// Gains of the source and the destination at position 0 to 1 through the transition.
+std::pair<double, double> audio_gains(transition_curve curve, double position)
+{
+    switch (curve) {
+        case transition_curve::linear:
+            return {1.0 - position, position};
+        case transition_curve::log: {
+            auto gain = [](double x) { return x > 0.0 ? std::pow(10.0, -3.0 * (1.0 - x)) : 0.0; };
+            return {gain(1.0 - position), gain(position)};
+        }
+        default: {
+            const auto pi = 3.14159265358979323846;
+            return {std::cos(position * pi / 2.0), std::sin(position * pi / 2.0)};
+        }
+    }
+}
+
+} // namespace
+
 class transition_producer : public frame_producer_base
 {
     monitor::state state_;
@@ -142,8 +164,10 @@ class transition_producer : public frame_producer_base
 
         const double dir = info_.direction == transition_direction::from_left ? 1.0 : -1.0;
 
-        src_frame.transform().audio_transform.volume = 1.0 - delta;
-        dst_frame.transform().audio_transform.volume = delta;
+        // The audio mixer ramps between these once per frame, sample by sample.
+        const auto gains = audio_gains(info_.audio_curve, static_cast<double>(current_frame_) / info_.duration);
+        src_frame.transform().audio_transform.volume = gains.first;
+        dst_frame.transform().audio_transform.volume = gains.second;
 
         if (info_.type == transition_type::mix) {
             dst_frame.transform().image_transform.opacity = delta;
@@ -48,11 +48,21 @@ enum class transition_direction
     count
 };
 
+// How audio crosses over during a transition. Audio follows the time of the transition, not the video tween.
+enum class transition_curve
+{
+    equal_power, // Sine and cosine gains, the summed power of uncorrelated sources stays constant.
+    linear,      // Gains that sum to one.
+    log,         // Gains that change by the same number of dB each frame, over 60 dB.
+    count
+};
+
 struct transition_info
 {
-    int                  duration  = 0;
-    transition_direction direction = transition_direction::from_left;
-    transition_type      type      = transition_type::cut;
+    int                  duration    = 0;
+    transition_direction direction   = transition_direction::from_left;
+    transition_type      type        = transition_type::cut;
+    transition_curve     audio_curve = transition_curve::linear;
     caspar::tweener      tweener{L"linear"};
 };
 
@@ -65,12 +65,15 @@ struct video_channel::impl final
         return spl::make_shared<caspar::diagnostics::graph>();
     }(index_);
 
-    caspar::core::output         output_;
-    spl::shared_ptr<image_mixer> image_mixer_;
-    caspar::core::mixer          mixer_;
-    caspar::core::stage          stage_;
+    caspar::core::output                 output_;
+    std::shared_ptr<image_mixer>         image_mixer_;
+    spl::shared_ptr<core::frame_factory> frame_factory_;
+    caspar::core::mixer                  mixer_;
+    caspar::core::stage                  stage_;
 
-    std::vector<int> audio_cadence_ = format_desc_.audio_cadence;
+    audio_cadence_scheduler audio_cadence_{format_desc_.audio_sample_rate,
+                                           format_desc_.framerate,
+                                           format_desc_.audio_cadence};
 
     std::function<void(const monitor::state&)> tick_;
 
@@ -89,6 +92,8 @@ struct video_channel::impl final
         , format_desc_(format_desc)
         , output_(graph_, format_desc, index)
         , image_mixer_(std::move(image_mixer))
+        , frame_factory_(image_mixer_ ? spl::shared_ptr<core::frame_factory>(image_mixer_)
+                                      : spl::make_shared<cpu_frame_factory>())
         , mixer_(index, graph_, image_mixer_)
         , stage_(index, graph_)
         , tick_(tick)
@@ -110,8 +115,7 @@ struct video_channel::impl final
                     {
                         std::lock_guard<std::mutex> lock(format_desc_mutex_);
                         format_desc = format_desc_;
-                        boost::range::rotate(audio_cadence_, std::end(audio_cadence_) - 1);
-                        nb_samples = audio_cadence_.front();
+                        nb_samples  = audio_cadence_.next();
                     }
 
                     state_.clear();
@@ -125,7 +129,7 @@ struct video_channel::impl final
 
                     // Mix
                     caspar::timer mix_timer;
-                    auto          mixed_frame = mixer_(stage_frames, format_desc, format_desc.audio_cadence[0]);
+                    auto          mixed_frame = mixer_(stage_frames, format_desc, nb_samples);
                     graph_->set_value("mix-time", mix_timer.elapsed() * format_desc.fps * 0.5);
 
                     state_.insert_or_assign("mixer", mixer_.state());
@@ -208,7 +212,8 @@ struct video_channel::impl final
     {
         std::lock_guard<std::mutex> lock(format_desc_mutex_);
         format_desc_   = format_desc;
-        audio_cadence_ = format_desc_.audio_cadence;
+        audio_cadence_ =
+            audio_cadence_scheduler(format_desc_.audio_sample_rate, format_desc_.framerate, format_desc_.audio_cadence);
         stage_.clear();
     }
 
@@ -234,7 +239,7 @@ const mixer&                   video_channel::mixer() const { return impl_->mixe
 mixer&                         video_channel::mixer() { return impl_->mixer_; }
 const output&                  video_channel::output() const { return impl_->output_; }
 output&                        video_channel::output() { return impl_->output_; }
-spl::shared_ptr<frame_factory> video_channel::frame_factory() { return impl_->image_mixer_; }
+spl::shared_ptr<frame_factory> video_channel::frame_factory() { return impl_->frame_factory_; }
 core::video_format_desc        video_channel::video_format_desc() const { return impl_->video_format_desc(); }
 void                           core::video_channel::video_format_desc(const core::video_format_desc& format_desc)
 {
@@ -55,6 +55,7 @@ class video_channel final
     video_channel& operator=(const video_channel&);
 
   public:
+    // A null image_mixer makes an audio-only channel, producers then draw into system memory.
     explicit video_channel(int                                        index,
                            const video_format_desc&                   format_desc,
                            std::unique_ptr<image_mixer>               image_mixer,
@@ -29,6 +29,8 @@
 #include <boost/range/adaptors.hpp>
 #include <boost/range/algorithm.hpp>
 
+#include <algorithm>
+
 namespace caspar { namespace core {
 
 const std::vector<video_format_desc> format_descs = {
@@ -42,7 +44,7 @@ const std::vector<video_format_desc> format_descs = {
      60000,
      1001,
      L"NTSC",
-     {1602 / 2, 1601 / 2, 1602 / 2, 1601 / 2, 1602 / 2}},
+     {801, 800, 801, 801, 801}},
     {video_format::x576p2500, 1, 720, 576, 1024, 576, 25000, 1000, L"576p2500", {1920}},
     {video_format::x720p2398, 1, 1280, 720, 1280, 720, 24000, 1001, L"720p2398", {2002}},
     {video_format::x720p2400, 1, 1280, 720, 1280, 720, 24000, 1000, L"720p2400", {2000}},
@@ -64,7 +66,7 @@ const std::vector<video_format_desc> format_descs = {
      60000,
      1001,
      L"1080i5994",
-     {1602 / 2, 1601 / 2, 1602 / 2, 1601 / 2, 1602 / 2}},
+     {801, 800, 801, 801, 801}},
     {video_format::x1080i6000, 2, 1920, 1080, 1920, 1080, 60000, 1000, L"1080i6000", {1600 / 2}},
     {video_format::x1080p2500, 1, 1920, 1080, 1920, 1080, 25000, 1000, L"1080p2500", {1920}},
     {video_format::x1080p2997, 1, 1920, 1080, 1920, 1080, 30000, 1001, L"1080p2997", {1602, 1601, 1602, 1601, 1602}},
@@ -160,6 +162,17 @@ std::vector<int> find_audio_cadence(const boost::rational<int>& framerate, bool
     if (exact_match != CADENCES_BY_FRAMERATE.end())
         return exact_match->second;
 
+    // Other rates get their exact cadence, unless it takes too many frames to repeat.
+    const auto sample_rate = 48000;
+    if (framerate > 0 && (sample_rate / framerate).denominator() <= 1000) {
+        audio_cadence_scheduler scheduler(sample_rate, framerate);
+        std::vector<int>        result((sample_rate / framerate).denominator());
+        for (auto& nb_samples : result) {
+            nb_samples = scheduler.next();
+        }
+        return result;
+    }
+
     boost::rational<int> closest_framerate_diff = std::numeric_limits<int>::max();
     boost::rational<int> closest_framerate      = 0;
 
@@ -184,4 +197,44 @@ std::vector<int> find_audio_cadence(const boost::rational<int>& framerate, bool
     return CADENCES_BY_FRAMERATE[closest_framerate];
 }
 
+audio_cadence_scheduler::audio_cadence_scheduler(int sample_rate, const boost::rational<int>& rate)
+    : step_(static_cast<std::int64_t>(sample_rate) * rate.denominator())
+    , rate_(rate.numerator())
+{
+}
+
+audio_cadence_scheduler::audio_cadence_scheduler(int                         sample_rate,
+                                                 const boost::rational<int>& rate,
+                                                 const std::vector<int>&     cadence)
+    : audio_cadence_scheduler(sample_rate, rate)
+{
+    // Rotating right before every frame hands out the cadence back to front, starting at its last entry. The remainder
+    // to start from has to put every position of that sequence between its floor and the next sample.
+    std::int64_t lower    = 0;
+    std::int64_t upper    = rate_;
+    std::int64_t position = 0;
+    for (std::size_t n = 1; n <= cadence.size(); ++n) {
+        position += cadence[cadence.size() - n];
+        lower = std::max(lower, position * rate_ - static_cast<std::int64_t>(n) * step_);
+        upper = std::min(upper, (position + 1) * rate_ - static_cast<std::int64_t>(n) * step_);
+    }
+
+    if (!cadence.empty() && lower < upper && position * rate_ == static_cast<std::int64_t>(cadence.size()) * step_) {
+        remainder_ = lower;
+    }
+}
+
+int audio_cadence_scheduler::next()
+{
+    remainder_ += step_;
+
+    const auto result = remainder_ / rate_;
+    remainder_ -= result * rate_;
+
+    ticks_ += 1;
+    position_ += result;
+
+    return static_cast<int>(result);
+}
+
 }} // namespace caspar::core
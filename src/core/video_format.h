@@ -22,6 +22,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -112,4 +113,28 @@ std::wostream& operator<<(std::wostream& out, const video_format_desc& format_de
 
 std::vector<int> find_audio_cadence(const boost::rational<int>& framerate, bool log_quiet = false);
 
+// Number of audio samples in each tick at a rational tick rate. The fraction of a sample left over is carried to the
+// next tick, so after n ticks exactly floor(n * sample_rate / rate) samples have been handed out and nothing drifts.
+class audio_cadence_scheduler final
+{
+  public:
+    audio_cadence_scheduler(int sample_rate, const boost::rational<int>& rate);
+
+    // Starts at the phase that hands out the same samples as a producer rotating cadence before every frame, as long
+    // as cadence holds whole cycles of the rate. Positions are then a fraction of a sample ahead of the above.
+    audio_cadence_scheduler(int sample_rate, const boost::rational<int>& rate, const std::vector<int>& cadence);
+
+    int next();
+
+    std::int64_t ticks() const { return ticks_; }
+    std::int64_t position() const { return position_; }
+
+  private:
+    std::int64_t step_;
+    std::int64_t rate_;
+    std::int64_t remainder_ = 0;
+    std::int64_t ticks_     = 0;
+    std::int64_t position_  = 0;
+};
+
 }} // namespace caspar::core
@@ -30,7 +30,9 @@
 
 #include <core/consumer/frame_consumer.h>
 #include <core/diagnostics/call_context.h>
+#include <core/frame/field_weave.h>
 #include <core/frame/frame.h>
+#include <core/frame/frame_conversion.h>
 #include <core/mixer/audio/audio_mixer.h>
 
 #include <common/array.h>
@@ -80,6 +82,7 @@ struct configuration
     keyer_t   keyer             = keyer_t::default_keyer;
     latency_t latency           = latency_t::default_latency;
     bool      key_only          = false;
+    bool      ten_bit           = false;
     int       base_buffer_depth = 3;
 
     int buffer_depth() const 
@@ -90,6 +93,13 @@ struct configuration
     }
 
     int key_device_index() const { return key_device_idx == 0 ? device_index + 1 : key_device_idx; }
+
+    BMDPixelFormat pixel_format() const { return ten_bit ? bmdFormat10BitYUV : bmdFormat8BitBGRA; }
+
+    int linesize(const core::video_format_desc& format_desc) const
+    {
+        return ten_bit ? core::v210_linesize(format_desc.width) : format_desc.width * 4;
+    }
 };
 
 template <typename Configuration>
@@ -140,12 +150,20 @@ class decklink_frame : public IDeckLinkVideoFrame
     std::shared_ptr<void>   data_;
     std::atomic<int>        ref_count_{0};
     int                     nb_samples_;
+    BMDPixelFormat          pixel_format_;
+    long                    row_bytes_;
 
   public:
-    decklink_frame(std::shared_ptr<void> data, const core::video_format_desc& format_desc, int nb_samples)
+    decklink_frame(std::shared_ptr<void>          data,
+                   const core::video_format_desc& format_desc,
+                   int                            nb_samples,
+                   BMDPixelFormat                 pixel_format = bmdFormat8BitBGRA,
+                   long                           row_bytes    = 0)
         : data_(data)
         , format_desc_(format_desc)
         , nb_samples_(nb_samples)
+        , pixel_format_(pixel_format)
+        , row_bytes_(row_bytes > 0 ? row_bytes : static_cast<long>(format_desc.width * 4))
     {
     }
 
@@ -170,8 +188,8 @@ class decklink_frame : public IDeckLinkVideoFrame
 
     virtual long STDMETHODCALLTYPE GetWidth() { return static_cast<long>(format_desc_.width); }
     virtual long STDMETHODCALLTYPE GetHeight() { return static_cast<long>(format_desc_.height); }
-    virtual long STDMETHODCALLTYPE GetRowBytes() { return static_cast<long>(format_desc_.width * 4); }
-    virtual BMDPixelFormat STDMETHODCALLTYPE GetPixelFormat() { return bmdFormat8BitBGRA; }
+    virtual long STDMETHODCALLTYPE GetRowBytes() { return row_bytes_; }
+    virtual BMDPixelFormat STDMETHODCALLTYPE GetPixelFormat() { return pixel_format_; }
     virtual BMDFrameFlags STDMETHODCALLTYPE GetFlags() { return bmdFrameFlagDefault; }
 
     virtual HRESULT STDMETHODCALLTYPE GetBytes(void** buffer)
@@ -286,7 +304,7 @@ struct decklink_consumer : public IDeckLinkVideoOutputCallback
     std::unique_ptr<key_video_context>  key_context_;
 
     com_ptr<IDeckLinkDisplayMode> mode_ =
-        get_display_mode(output_, format_desc_.format, bmdFormat8BitBGRA, bmdVideoOutputFlagDefault);
+        get_display_mode(output_, format_desc_.format, config_.pixel_format(), bmdVideoOutputFlagDefault);
     int field_count_ = mode_->GetFieldDominance() != bmdProgressiveFrame ? 2 : 1;
 
     std::atomic<bool> abort_request_{false};
@@ -334,8 +352,9 @@ struct decklink_consumer : public IDeckLinkVideoOutputCallback
                 schedule_next_audio(std::vector<int32_t>(nb_samples * format_desc_.audio_channels), nb_samples);
             }
 
-            std::shared_ptr<void> image_data(scalable_aligned_malloc(format_desc_.size, 64), scalable_aligned_free);
-            schedule_next_video(image_data, nb_samples);
+            const auto            size = config_.linesize(format_desc_) * format_desc_.height;
+            std::shared_ptr<void> image_data(scalable_aligned_malloc(size, 64), scalable_aligned_free);
+            schedule_next_video(image_data, nullptr, nb_samples);
         }
 
         if (config.embedded_audio) {
@@ -452,7 +471,8 @@ struct decklink_consumer : public IDeckLinkVideoOutputCallback
                 }
             }
 
-            std::shared_ptr<void>     image_data(scalable_aligned_malloc(format_desc_.size, 64), scalable_aligned_free);
+            std::shared_ptr<void>     image_data;
+            std::shared_ptr<void>     key_data;
             std::vector<std::int32_t> audio_data;
 
             std::vector<core::const_frame> frames{pop()};
@@ -469,10 +489,10 @@ struct decklink_consumer : public IDeckLinkVideoOutputCallback
                     std::swap(frames[0], frames[1]);
                 }
 
-                for (auto y = 0; y < format_desc_.height; ++y) {
-                    std::memcpy(reinterpret_cast<char*>(image_data.get()) + y * format_desc_.width * 4,
-                                frames[y % 2].image_data(0).data() + y * format_desc_.width * 4,
-                                format_desc_.width * 4);
+                if (config_.ten_bit) {
+                    image_data = weave_v210(frames[0], frames[1]);
+                } else {
+                    image_data = core::weave_fields(frames[0], frames[1]);
                 }
 
                 audio_data.insert(audio_data.end(), frames[0].audio_data().begin(), frames[0].audio_data().end());
@@ -482,18 +502,32 @@ struct decklink_consumer : public IDeckLinkVideoOutputCallback
                     return E_FAIL;
                 }
 
-                for (auto y = 0; y < format_desc_.height; ++y) {
-                    std::memcpy(reinterpret_cast<char*>(image_data.get()) + y * format_desc_.width * 4,
-                                frames[0].image_data(0).data() + y * format_desc_.width * 4,
-                                format_desc_.width * 4);
+                if (config_.ten_bit) {
+                    // Shared with any other consumer on the channel that outputs v210.
+                    auto v210  = core::v210(frames[0]);
+                    image_data = std::shared_ptr<void>(const_cast<std::uint32_t*>(v210.data()), [v210](void*) {});
+                } else {
+                    image_data.reset(scalable_aligned_malloc(format_desc_.size, 64), scalable_aligned_free);
+
+                    for (auto y = 0; y < format_desc_.height; ++y) {
+                        std::memcpy(reinterpret_cast<char*>(image_data.get()) + y * format_desc_.width * 4,
+                                    frames[0].image_data(0).data() + y * format_desc_.width * 4,
+                                    format_desc_.width * 4);
+                    }
                 }
 
                 audio_data.insert(audio_data.end(), frames[0].audio_data().begin(), frames[0].audio_data().end());
+
+                if (key_context_ || config_.key_only) {
+                    // Shared with any other consumer on the channel that needs the key.
+                    auto key = core::key_only(frames[0]);
+                    key_data = std::shared_ptr<void>(const_cast<std::uint8_t*>(key.data()), [key](void*) {});
+                }
             }
 
             const auto nb_samples = static_cast<int>(audio_data.size()) / format_desc_.audio_channels;
 
-            schedule_next_video(image_data, nb_samples);
+            schedule_next_video(image_data, key_data, nb_samples);
 
             if (config_.embedded_audio) {
                 schedule_next_audio(std::move(audio_data), nb_samples);
@@ -507,6 +541,21 @@ struct decklink_consumer : public IDeckLinkVideoOutputCallback
         return S_OK;
     }
 
+    std::shared_ptr<void> weave_v210(const core::const_frame& upper, const core::const_frame& lower)
+    {
+        const auto linesize   = config_.linesize(format_desc_);
+        const auto upper_v210 = core::v210(upper);
+        const auto lower_v210 = core::v210(lower);
+
+        std::shared_ptr<void> dest(scalable_aligned_malloc(linesize * format_desc_.height, 64), scalable_aligned_free);
+        core::weave_fields(static_cast<std::uint8_t*>(dest.get()),
+                           reinterpret_cast<const std::uint8_t*>(upper_v210.data()),
+                           reinterpret_cast<const std::uint8_t*>(lower_v210.data()),
+                           linesize,
+                           format_desc_.height);
+        return dest;
+    }
+
     core::const_frame pop()
     {
         core::const_frame frame;
@@ -539,14 +588,15 @@ struct decklink_consumer : public IDeckLinkVideoOutputCallback
         audio_scheduled_ += nb_samples;
     }
 
-    void schedule_next_video(std::shared_ptr<void> fill, int nb_samples)
+    void schedule_next_video(std::shared_ptr<void> fill, std::shared_ptr<void> key, int nb_samples)
     {
-        std::shared_ptr<void> key;
-
         if (key_context_ || config_.key_only) {
-            key = std::shared_ptr<void>(scalable_aligned_malloc(format_desc_.size, 64), scalable_aligned_free);
+            if (!key) {
+                key = std::shared_ptr<void>(scalable_aligned_malloc(format_desc_.size, 64), scalable_aligned_free);
 
-            aligned_memshfl(key.get(), fill.get(), format_desc_.size, 0x0F0F0F0F, 0x0B0B0B0B, 0x07070707, 0x03030303);
+                aligned_memshfl(
+                    key.get(), fill.get(), format_desc_.size, 0x0F0F0F0F, 0x0B0B0B0B, 0x07070707, 0x03030303);
+            }
 
             if (config_.key_only) {
                 fill = key;
@@ -563,7 +613,8 @@ struct decklink_consumer : public IDeckLinkVideoOutputCallback
             }
         }
 
-        auto fill_frame = wrap_raw<com_ptr, IDeckLinkVideoFrame>(new decklink_frame(fill, format_desc_, nb_samples));
+        auto fill_frame = wrap_raw<com_ptr, IDeckLinkVideoFrame>(new decklink_frame(
+            fill, format_desc_, nb_samples, config_.pixel_format(), config_.linesize(format_desc_)));
         if (FAILED(output_->ScheduleVideoFrame(get_raw(fill_frame),
                                                video_scheduled_,
                                                format_desc_.duration * field_count_,
@@ -656,9 +707,23 @@ struct decklink_consumer_proxy : public core::frame_consumer
 
     bool has_synchronization_clock() const override { return true; }
 
+    bool supports_color_depth(core::color_depth depth) const override
+    {
+        return depth == core::color_depth::eight || config_.ten_bit;
+    }
+
     const core::monitor::state& state() { return state_; }
 };
 
+// v210 carries no alpha, so there is no key to output.
+void validate_ten_bit(configuration& config)
+{
+    if (config.ten_bit && (config.key_only || config.keyer == configuration::keyer_t::external_separate_device_keyer)) {
+        CASPAR_LOG(warning) << L"[decklink_consumer] 10 bit output can't be combined with key output, using 8 bit.";
+        config.ten_bit = false;
+    }
+}
+
 spl::shared_ptr<core::frame_consumer> create_consumer(const std::vector<std::wstring>&                  params,
                                                       std::vector<spl::shared_ptr<core::video_channel>> channels)
 {
@@ -687,6 +752,9 @@ spl::shared_ptr<core::frame_consumer> create_consumer(const std::vector<std::wst
 
     config.embedded_audio = contains_param(L"EMBEDDED_AUDIO", params);
     config.key_only       = contains_param(L"KEY_ONLY", params);
+    config.ten_bit        = contains_param(L"10BIT", params);
+
+    validate_ten_bit(config);
 
     return spl::make_shared<decklink_consumer_proxy>(config);
 }
@@ -718,6 +786,9 @@ create_preconfigured_consumer(const boost::property_tree::wptree&
     config.key_device_idx    = ptree.get(L"key-device", config.key_device_idx);
     config.embedded_audio    = ptree.get(L"embedded-audio", config.embedded_audio);
     config.base_buffer_depth = ptree.get(L"buffer-depth", config.base_buffer_depth);
+    config.ten_bit           = ptree.get(L"ten-bit", config.ten_bit);
+
+    validate_ten_bit(config);
 
     return spl::make_shared<decklink_consumer_proxy>(config);
 }
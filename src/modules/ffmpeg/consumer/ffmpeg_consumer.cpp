@@ -32,10 +32,13 @@
 #include <common/scope_exit.h>
 #include <common/timer.h>
 
+#include <core/frame/field_weave.h>
 #include <core/frame/frame.h>
+#include <core/frame/pixel_format.h>
 #include <core/video_format.h>
 
 #include <boost/algorithm/string.hpp>
+#include <boost/any.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/format.hpp>
 #include <boost/optional.hpp>
@@ -73,8 +76,20 @@ extern "C"
 #include <tbb/parallel_for.h>
 #include <tbb/parallel_invoke.h>
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <tmmintrin.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <map>
 #include <memory>
+#include <string>
 #include <thread>
+#include <utility>
+#include <vector>
 
 namespace caspar { namespace ffmpeg {
 
@@ -83,6 +98,153 @@ namespace caspar { namespace ffmpeg {
 // TODO run video filter, video encoder, audio filter, audio encoder in separate threads.
 // TODO realtime with smaller buffer?
 
+boost::filesystem::path resolve_path(const std::string& path)
+{
+    boost::filesystem::path full_path = path;
+
+    static boost::regex prot_exp("^.+:.*");
+    if (!boost::regex_match(path, prot_exp)) {
+        if (!full_path.is_complete()) {
+            full_path = u8(env::media_folder()) + path;
+        }
+
+        // TODO -y?
+        if (boost::filesystem::exists(full_path)) {
+            boost::filesystem::remove(full_path);
+        }
+
+        boost::filesystem::create_directories(full_path.parent_path());
+    }
+
+    return full_path;
+}
+
+void write_packets(AVFormatContext* oc, tbb::concurrent_bounded_queue<std::shared_ptr<AVPacket>>& packet_buffer)
+{
+    CASPAR_SCOPE_EXIT
+    {
+        if (!(oc->oformat->flags & AVFMT_NOFILE)) {
+            FF(avio_closep(&oc->pb));
+        }
+    };
+
+    std::map<int, int64_t> count;
+
+    std::shared_ptr<AVPacket> pkt;
+    while (true) {
+        packet_buffer.pop(pkt);
+        if (!pkt) {
+            break;
+        }
+        count[pkt->stream_index] += 1;
+        FF(av_interleaved_write_frame(oc, pkt.get()));
+    }
+
+    for (auto n = 0U; n < oc->nb_streams; ++n) {
+        if (!count[static_cast<int>(n)]) {
+            return;
+        }
+    }
+
+    FF(av_write_trailer(oc));
+}
+
+// One x264 preset faster, or preset itself when there is none faster or it isn't an x264 preset.
+std::string faster_preset(const std::string& preset)
+{
+    static const char* presets[] = {
+        "ultrafast", "superfast", "veryfast", "faster", "fast", "medium", "slow", "slower", "veryslow", "placebo"};
+
+    for (auto n = 1; n < 10; ++n) {
+        if (preset == presets[n]) {
+            return presets[n - 1];
+        }
+    }
+    return preset;
+}
+
+// Filters a plane down by an integer factor. width and height are the destination dimensions. The box filter
+// averages every pixel of a block, bilinear interpolates at the centre of the block from the nearest 2x2 pixels,
+// which is cheaper and sharper but aliases more. At a factor of 2 both are the same.
+void downsample_plane(const uint8_t* src,
+                      int            src_linesize,
+                      uint8_t*       dst,
+                      int            dst_linesize,
+                      int            width,
+                      int            height,
+                      int            factor,
+                      bool           bilinear)
+{
+    // The rows and columns of each block that are averaged.
+    const auto first = bilinear ? (factor - 1) / 2 : 0;
+    const auto count = bilinear ? 2 - factor % 2 : factor;
+    const auto area  = count * count;
+
+    tbb::parallel_for(tbb::blocked_range<int>(0, height), [&](const tbb::blocked_range<int>& r) {
+        const __m128i ones8  = _mm_set1_epi8(1);
+        const __m128i ones16 = _mm_set1_epi16(1);
+
+        for (auto y = r.begin(); y < r.end(); ++y) {
+            auto src_row = src + (y * factor + first) * src_linesize;
+            auto dst_row = dst + y * dst_linesize;
+
+            auto x = 0;
+            if (factor == 2) {
+                const __m128i round = _mm_set1_epi16(2);
+                for (; x + 8 <= width; x += 8) {
+                    auto r0  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_row + x * 2));
+                    auto r1  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_row + src_linesize + x * 2));
+                    auto sum = _mm_add_epi16(_mm_maddubs_epi16(r0, ones8), _mm_maddubs_epi16(r1, ones8));
+                    sum      = _mm_srli_epi16(_mm_add_epi16(sum, round), 2);
+                    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst_row + x), _mm_packus_epi16(sum, sum));
+                }
+            } else if (factor == 4) {
+                // Bilinear takes the middle two pixels of the middle two rows.
+                const __m128i weights =
+                    bilinear ? _mm_setr_epi8(0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0) : ones8;
+                const __m128i shift = _mm_cvtsi32_si128(bilinear ? 2 : 4);
+                const __m128i round = _mm_set1_epi32(area / 2);
+                for (; x + 4 <= width; x += 4) {
+                    auto sum = _mm_setzero_si128();
+                    for (auto n = 0; n < count; ++n) {
+                        auto row = src_row + n * src_linesize + x * 4;
+                        sum      = _mm_add_epi16(
+                            sum, _mm_maddubs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row)), weights));
+                    }
+                    auto sum32 = _mm_srl_epi32(_mm_add_epi32(_mm_madd_epi16(sum, ones16), round), shift);
+                    auto sum16 = _mm_packs_epi32(sum32, sum32);
+                    *reinterpret_cast<int32_t*>(dst_row + x) = _mm_cvtsi128_si32(_mm_packus_epi16(sum16, sum16));
+                }
+            }
+
+            for (; x < width; ++x) {
+                auto sum = 0;
+                for (auto n = 0; n < count; ++n) {
+                    for (auto m = 0; m < count; ++m) {
+                        sum += src_row[n * src_linesize + x * factor + first + m];
+                    }
+                }
+                dst_row[x] = static_cast<uint8_t>((sum + area / 2) / area);
+            }
+        }
+    });
+}
+
+// Weaves two fields of an interlaced channel into one frame with the same kernel as the decklink consumer.
+core::const_frame weave_frame(const core::const_frame& first, const core::const_frame& second, bool top_field_first)
+{
+    const auto& upper = top_field_first ? first : second;
+    const auto& lower = top_field_first ? second : first;
+
+    auto data = core::weave_fields(upper, lower);
+    auto size = first.image_data(0).size();
+
+    std::vector<array<const std::uint8_t>> image_data;
+    image_data.emplace_back(static_cast<const std::uint8_t*>(data.get()), size, std::move(data));
+
+    return core::const_frame(std::move(image_data), array<const std::int32_t>{}, first.pixel_format_desc());
+}
+
 struct Stream
 {
     std::shared_ptr<AVFilterGraph> graph  = nullptr;
@@ -93,8 +255,24 @@ struct Stream
     AVStream*                       st  = nullptr;
 
     tbb::concurrent_bounded_queue<std::shared_ptr<SwsContext>> sws_;
+    tbb::concurrent_bounded_queue<std::shared_ptr<SwsContext>> fast_sws_;
 
-    int64_t pts = 0;
+    std::shared_ptr<AVFrame> last_frame;
+    bool                     fast_sws = false;
+
+    int64_t pts      = 0;
+    int64_t last_dts = AV_NOPTS_VALUE;
+
+    // Kept so that the encoder can be reopened with another preset or size, see reconfigure.
+    AVCodec*                           codec = nullptr;
+    core::video_format_desc            format_desc;
+    bool                               realtime = false;
+    std::string                        filter_spec;
+    std::map<std::string, std::string> encoder_options;
+    std::string                        preset;
+    bool                               fast_preset   = false;
+    int                                scale         = 1;
+    bool                               global_header = false;
 
     Stream(AVFormatContext*                    oc,
            std::string                         suffix,
@@ -117,7 +295,6 @@ struct Stream
             }
         }
 
-        std::string filter_spec = "";
         {
             const auto it = stream_options.find("filter");
             if (it != stream_options.end()) {
@@ -126,7 +303,7 @@ struct Stream
             }
         }
 
-        auto codec = avcodec_find_encoder(codec_id);
+        codec = avcodec_find_encoder(codec_id);
         {
             const auto it = stream_options.find("codec");
             if (it != stream_options.end()) {
@@ -139,6 +316,42 @@ struct Stream
             FF_RET(AVERROR(EINVAL), "avcodec_find_encoder");
         }
 
+        this->format_desc = format_desc;
+        this->realtime    = realtime;
+        configure_graph();
+
+        st = avformat_new_stream(oc, nullptr);
+        if (!st) {
+            FF_RET(AVERROR(ENOMEM), "avformat_new_stream");
+        }
+
+        {
+            const auto it = stream_options.find("preset");
+            if (it != stream_options.end()) {
+                preset = it->second;
+            }
+        }
+        encoder_options = stream_options;
+        global_header   = (oc->oformat->flags & AVFMT_GLOBALHEADER) != 0;
+
+        for (auto& p : open_encoder(std::move(stream_options))) {
+            options[p.first] = p.second + suffix;
+        }
+        st->time_base = enc->time_base;
+
+        FF(avcodec_parameters_from_context(st->codecpar, enc.get()));
+
+        if (codec->type == AVMEDIA_TYPE_AUDIO && !(codec->capabilities & AV_CODEC_CAP_VARIABLE_FRAME_SIZE)) {
+            av_buffersink_set_frame_size(sink, enc->frame_size);
+        }
+
+        if (oc->oformat->flags & AVFMT_GLOBALHEADER) {
+            enc->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+        }
+    }
+
+    void configure_graph()
+    {
         AVFilterInOut* outputs = nullptr;
         AVFilterInOut* inputs  = nullptr;
 
@@ -168,7 +381,13 @@ struct Stream
             }
         }
 
-        FF(avfilter_graph_parse2(graph.get(), filter_spec.c_str(), &inputs, &outputs));
+        // A reduced size is scaled to after the user's filters, in even dimensions for subsampled chroma.
+        auto spec = filter_spec;
+        if (scale > 1) {
+            spec += (boost::format(",scale=trunc(iw/%1%/2)*2:trunc(ih/%1%/2)*2") % scale).str();
+        }
+
+        FF(avfilter_graph_parse2(graph.get(), spec.c_str(), &inputs, &outputs));
 
         {
             auto cur = inputs;
@@ -259,12 +478,11 @@ struct Stream
         }
 
         FF(avfilter_graph_config(graph.get(), nullptr));
+    }
 
-        st = avformat_new_stream(oc, nullptr);
-        if (!st) {
-            FF_RET(AVERROR(ENOMEM), "avformat_new_stream");
-        }
-
+    // Opens a new encoder for the filter graph's output. Returns the options the encoder didn't use.
+    std::map<std::string, std::string> open_encoder(std::map<std::string, std::string> options)
+    {
         enc = std::shared_ptr<AVCodecContext>(avcodec_alloc_context3(codec),
                                               [](AVCodecContext* ptr) { avcodec_free_context(&ptr); });
 
@@ -273,22 +491,18 @@ struct Stream
         }
 
         if (codec->type == AVMEDIA_TYPE_VIDEO) {
-            st->time_base = av_inv_q(av_buffersink_get_frame_rate(sink));
-
             enc->width               = av_buffersink_get_w(sink);
             enc->height              = av_buffersink_get_h(sink);
             enc->framerate           = av_buffersink_get_frame_rate(sink);
             enc->sample_aspect_ratio = av_buffersink_get_sample_aspect_ratio(sink);
-            enc->time_base           = st->time_base;
+            enc->time_base           = av_inv_q(av_buffersink_get_frame_rate(sink));
             enc->pix_fmt             = static_cast<AVPixelFormat>(av_buffersink_get_format(sink));
         } else if (codec->type == AVMEDIA_TYPE_AUDIO) {
-            st->time_base = {1, av_buffersink_get_sample_rate(sink)};
-
             enc->sample_fmt     = static_cast<AVSampleFormat>(av_buffersink_get_format(sink));
             enc->sample_rate    = av_buffersink_get_sample_rate(sink);
             enc->channels       = av_buffersink_get_channels(sink);
             enc->channel_layout = av_buffersink_get_channel_layout(sink);
-            enc->time_base      = st->time_base;
+            enc->time_base      = {1, av_buffersink_get_sample_rate(sink)};
 
             if (!enc->channels) {
                 enc->channels = av_get_channel_layout_nb_channels(enc->channel_layout);
@@ -303,36 +517,56 @@ struct Stream
             enc->thread_type = FF_THREAD_SLICE;
         }
 
-        auto dict = to_dict(std::move(stream_options));
+        auto dict = to_dict(std::move(options));
         CASPAR_SCOPE_EXIT { av_dict_free(&dict); };
         FF(avcodec_open2(enc.get(), codec, &dict));
-        for (auto& p : to_map(&dict)) {
-            options[p.first] = p.second + suffix;
-        }
+        return to_map(&dict);
+    }
 
-        FF(avcodec_parameters_from_context(st->codecpar, enc.get()));
+    // Whether the encoder can be reopened mid-stream with a faster preset or a smaller size. Containers with
+    // global headers carry the first encoder's parameter sets, which can't change once the header is written.
+    bool can_change_preset() const
+    {
+        return !global_header && faster_preset(preset) != preset &&
+               av_opt_find(enc.get(), "preset", nullptr, 0, AV_OPT_SEARCH_CHILDREN) != nullptr;
+    }
 
-        if (codec->type == AVMEDIA_TYPE_AUDIO && !(codec->capabilities & AV_CODEC_CAP_VARIABLE_FRAME_SIZE)) {
-            av_buffersink_set_frame_size(sink, enc->frame_size);
+    bool can_rescale() const { return codec->type == AVMEDIA_TYPE_VIDEO && !global_header; }
+
+    // Drains the encoder and reopens it one preset faster or scaled down by new_scale. The stream's parameters
+    // keep describing the first encoder, the parameter sets in the bitstream describe the new one.
+    void reconfigure(bool new_fast_preset, int new_scale, std::function<void(std::shared_ptr<AVPacket>)> cb)
+    {
+        if (new_fast_preset == fast_preset && new_scale == scale) {
+            return;
         }
 
-        if (oc->oformat->flags & AVFMT_GLOBALHEADER) {
-            enc->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+        send(nullptr, cb);
+
+        fast_preset  = new_fast_preset;
+        scale        = new_scale;
+        auto options = encoder_options;
+        if (fast_preset) {
+            options["preset"] = faster_preset(preset);
         }
+        configure_graph();
+        open_encoder(std::move(options));
     }
 
-    std::shared_ptr<SwsContext> get_sws(int width, int height)
+    std::shared_ptr<SwsContext> get_sws(int width, int height, bool fast)
     {
+        auto& pool = fast ? fast_sws_ : sws_;
+
         std::shared_ptr<SwsContext> sws;
 
-        if (sws_.try_pop(sws)) {
+        if (pool.try_pop(sws)) {
             return sws;
         }
 
         sws.reset(sws_getContext(
             width, height, AV_PIX_FMT_BGRA,
             width, height, AV_PIX_FMT_YUVA422P,
-            0, nullptr, nullptr, nullptr
+            fast ? SWS_FAST_BILINEAR : 0, nullptr, nullptr, nullptr
         ), [](SwsContext* ptr) { sws_freeContext(ptr); });
 
         if (!sws) {
@@ -373,69 +607,101 @@ struct Stream
             contrast,
             saturation);
 
-        return std::shared_ptr<SwsContext>(sws.get(), [this, sws](SwsContext*) {
-            sws_.push(sws);
+        return std::shared_ptr<SwsContext>(sws.get(), [&pool, sws](SwsContext*) {
+            pool.push(sws);
         });
     }
 
+    std::shared_ptr<AVFrame> convert(const core::const_frame&       in_frame,
+                                     const core::video_format_desc& format_desc,
+                                     bool                           duplicate = false)
+    {
+        if (duplicate && last_frame) {
+            // Repeat the previous picture instead of converting a new one. Keeps the stream
+            // constant frame rate while the encoder gets an almost free frame.
+            return last_frame;
+        }
+
+        // Other ffmpeg consumers on the channel convert the same frame, so share the result through the frame.
+        last_frame = boost::any_cast<std::shared_ptr<AVFrame>>(
+            in_frame.cache(fast_sws ? "ffmpeg/yuva422p-fast" : "ffmpeg/yuva422p", [&] {
+                return boost::any(convert_yuva422p(in_frame, format_desc));
+            }));
+
+        return last_frame;
+    }
+
+    std::shared_ptr<AVFrame> convert_yuva422p(const core::const_frame&       in_frame,
+                                              const core::video_format_desc& format_desc)
+    {
+        auto frame = make_av_video_frame(in_frame, format_desc);
+
+        auto frame2 = alloc_frame();
+        frame2->sample_aspect_ratio = frame->sample_aspect_ratio;
+        frame2->width               = frame->width;
+        frame2->height              = frame->height;
+        frame2->format              = AV_PIX_FMT_YUVA422P;
+        frame2->colorspace          = AVCOL_SPC_BT709;
+        frame2->color_primaries     = AVCOL_PRI_BT709;
+        frame2->color_range         = AVCOL_RANGE_MPEG;
+        frame2->color_trc           = AVCOL_TRC_BT709;
+        av_frame_get_buffer(frame2.get(), 64);
+
+        int h = frame->height / 8;
+        tbb::parallel_for(0, 8, [&](int i) {
+            auto sws = get_sws(frame->width, h, fast_sws);
+
+            uint8_t* src[4] = {};
+            src[0] = frame->data[0] + frame->linesize[0] * (i * h);
+
+            uint8_t* dst[4] = {};
+            dst[0] = frame2->data[0] + frame2->linesize[0] * (i * h);
+            dst[1] = frame2->data[1] + frame2->linesize[1] * (i * h);
+            dst[2] = frame2->data[2] + frame2->linesize[2] * (i * h);
+            dst[3] = frame2->data[3] + frame2->linesize[3] * (i * h);
+
+            sws_scale(sws.get(), src, frame->linesize, 0, h, dst, frame2->linesize);
+        });
+
+        int i = frame->height - h;
+        if (i > 0) {
+            // TODO
+        }
+
+        return frame2;
+    }
+
     void send(core::const_frame                              in_frame,
               const core::video_format_desc&                 format_desc,
               std::function<void(std::shared_ptr<AVPacket>)> cb)
     {
-        int                       ret;
-        std::shared_ptr<AVFrame>  frame;
-        std::shared_ptr<AVPacket> pkt;
+        std::shared_ptr<AVFrame> frame;
 
         if (in_frame) {
             if (enc->codec_type == AVMEDIA_TYPE_VIDEO) {
-                frame = make_av_video_frame(in_frame, format_desc);
-
-                {
-                    auto frame2 = alloc_frame();
-                    frame2->sample_aspect_ratio = frame->sample_aspect_ratio;
-                    frame2->width               = frame->width;
-                    frame2->height              = frame->height;
-                    frame2->format              = AV_PIX_FMT_YUVA422P;
-                    frame2->colorspace          = AVCOL_SPC_BT709;
-                    frame2->color_primaries     = AVCOL_PRI_BT709;
-                    frame2->color_range         = AVCOL_RANGE_MPEG;
-                    frame2->color_trc           = AVCOL_TRC_BT709;
-                    av_frame_get_buffer(frame2.get(), 64);
-
-                    int h = frame->height / 8;
-                    tbb::parallel_for(0, 8, [&](int i) {
-                        auto sws = get_sws(frame->width, h);
-
-                        uint8_t* src[4] = {};
-                        src[0] = frame->data[0] + frame->linesize[0] * (i * h);
-
-                        uint8_t* dst[4] = {};
-                        dst[0] = frame2->data[0] + frame2->linesize[0] * (i * h);
-                        dst[1] = frame2->data[1] + frame2->linesize[1] * (i * h);
-                        dst[2] = frame2->data[2] + frame2->linesize[2] * (i * h);
-                        dst[3] = frame2->data[3] + frame2->linesize[3] * (i * h);
-
-                        sws_scale(sws.get(), src, frame->linesize, 0, h, dst, frame2->linesize);
-                    });
-
-                    int i = frame->height - h;
-                    if (i > 0) {
-                        // TODO
-                    }
-
-                    frame = frame2;
-                }
-
-                frame->pts = pts;
-                pts += 1;
+                frame = convert(in_frame, format_desc);
             } else if (enc->codec_type == AVMEDIA_TYPE_AUDIO) {
-                frame      = make_av_audio_frame(in_frame, format_desc);
-                frame->pts = pts;
-                pts += frame->nb_samples;
+                frame = make_av_audio_frame(in_frame, format_desc);
             } else {
                 // TODO
             }
-            FF(av_buffersrc_write_frame(source, frame.get()));
+        }
+
+        send(std::move(frame), std::move(cb));
+    }
+
+    void send(std::shared_ptr<AVFrame> frame, std::function<void(std::shared_ptr<AVPacket>)> cb)
+    {
+        int                       ret;
+        std::shared_ptr<AVPacket> pkt;
+
+        if (frame) {
+            // The frame may be shared with other streams and consumers, only modify our own reference.
+            auto frame2 = alloc_frame();
+            FF(av_frame_ref(frame2.get(), frame.get()));
+            frame2->pts = pts;
+            pts += enc->codec_type == AVMEDIA_TYPE_VIDEO ? 1 : frame2->nb_samples;
+            FF(av_buffersrc_write_frame(source, frame2.get()));
         } else {
             FF(av_buffersrc_close(source, pts, 0));
         }
@@ -461,12 +727,350 @@ struct Stream
                 FF_RET(ret, "avcodec_receive_packet");
                 pkt->stream_index = st->index;
                 av_packet_rescale_ts(pkt.get(), enc->time_base, st->time_base);
+
+                // A reopened encoder starts its decode timestamps behind its presentation timestamps again.
+                if (last_dts != AV_NOPTS_VALUE && pkt->dts != AV_NOPTS_VALUE && pkt->dts <= last_dts) {
+                    pkt->dts = last_dts + 1;
+                    pkt->pts = std::max(pkt->pts, pkt->dts);
+                }
+                if (pkt->dts != AV_NOPTS_VALUE) {
+                    last_dts = pkt->dts;
+                }
+
                 cb(std::move(pkt));
             }
         }
     }
 };
 
+// Low resolution H.264 copy written next to the main output. Pictures are downsampled from the main
+// stream's already converted frames and the main stream's encoded audio is muxed as is. The proxy never holds
+// up or ends the main output: pictures and packets are dropped while it is behind and it disables itself on errors.
+struct Proxy
+{
+    std::shared_ptr<AVFormatContext> oc;
+    int                              factor;
+    bool                             bilinear;
+    boost::optional<Stream>          video;
+    AVStream*                        audio_st = nullptr;
+    std::atomic<bool>                failed{false};
+    bool                             video_gap = false;
+
+    std::shared_ptr<AVFrame> source;
+    std::shared_ptr<AVFrame> frame;
+
+    // Pictures are downsampled and encoded on their own thread. A picture that doesn't fit in the buffer is
+    // skipped, the encoder's timestamps jump over it so the proxy stays in sync with the main output.
+    tbb::concurrent_bounded_queue<std::shared_ptr<AVFrame>> frame_buffer;
+    std::thread                                             frame_thread;
+    std::atomic<int>                                        skipped_frames{0};
+    bool                                                    ended = false;
+
+    tbb::concurrent_bounded_queue<std::shared_ptr<AVPacket>> packet_buffer;
+    std::thread                                              packet_thread;
+
+    Proxy(const std::string&      path,
+          int                     factor,
+          bool                    bilinear,
+          core::video_format_desc format_desc,
+          bool                    realtime,
+          const Stream*           audio_stream)
+        : factor(factor)
+        , bilinear(bilinear)
+    {
+        if (factor < 1) {
+            CASPAR_THROW_EXCEPTION(user_error() << msg_info("Invalid proxy scale."));
+        }
+
+        const auto full_path = resolve_path(path);
+
+        {
+            AVFormatContext* ptr = nullptr;
+            FF(avformat_alloc_output_context2(&ptr, nullptr, nullptr, path.c_str()));
+            oc = std::shared_ptr<AVFormatContext>(ptr, [](AVFormatContext* ptr) { avformat_free_context(ptr); });
+        }
+
+        // Keep the luma size even so that 4:2:2 chroma planes map 1:1 onto the downsampled source planes and
+        // the 4:2:0 output has whole chroma rows.
+        format_desc.width  = (format_desc.width / factor) & ~1;
+        format_desc.height = (format_desc.height / factor) & ~1;
+
+        std::map<std::string, std::string> options;
+        options["preset:v"] = "veryfast";
+        options["filter:v"] = "format=pix_fmts=yuv420p";
+        video.emplace(oc.get(), ":v", AV_CODEC_ID_H264, format_desc, realtime, options);
+
+        if (audio_stream) {
+            audio_st = avformat_new_stream(oc.get(), nullptr);
+            if (!audio_st) {
+                FF_RET(AVERROR(ENOMEM), "avformat_new_stream");
+            }
+            FF(avcodec_parameters_from_context(audio_st->codecpar, audio_stream->enc.get()));
+            audio_st->time_base = audio_stream->st->time_base;
+        }
+
+        if (!(oc->oformat->flags & AVFMT_NOFILE)) {
+            FF(avio_open2(&oc->pb, full_path.string().c_str(), AVIO_FLAG_WRITE, nullptr, nullptr));
+        }
+
+        FF(avformat_write_header(oc.get(), nullptr));
+
+        packet_buffer.set_capacity(realtime ? 16 : 128);
+        packet_thread = std::thread([this] {
+            try {
+                write_packets(oc.get(), packet_buffer);
+            } catch (...) {
+                disable();
+
+                // Keep taking packets until close, so that nothing waits on a full buffer.
+                try {
+                    std::shared_ptr<AVPacket> pkt;
+                    do {
+                        packet_buffer.pop(pkt);
+                    } while (pkt);
+                } catch (...) {
+                }
+            }
+        });
+
+        frame_buffer.set_capacity(realtime ? 1 : 16);
+        frame_thread = std::thread([this] {
+            // Takes pictures until the nullptr, also after failing, so that close never waits on a full buffer.
+            std::shared_ptr<AVFrame> main_frame;
+            do {
+                frame_buffer.pop(main_frame);
+                encode(main_frame);
+            } while (main_frame);
+        });
+    }
+
+    ~Proxy()
+    {
+        end();
+        if (packet_thread.joinable()) {
+            // The writer keeps taking packets until the nullptr, also after it failed, so this push returns.
+            packet_buffer.push(nullptr);
+            packet_thread.join();
+        }
+    }
+
+    void end()
+    {
+        if (!ended) {
+            ended = true;
+            frame_buffer.push(nullptr);
+        }
+        if (frame_thread.joinable()) {
+            frame_thread.join();
+        }
+    }
+
+    void disable()
+    {
+        if (!failed.exchange(true)) {
+            CASPAR_LOG_CURRENT_EXCEPTION();
+            CASPAR_LOG(warning) << L"ffmpeg proxy failed and is disabled, the main output continues.";
+        }
+    }
+
+    // A dropped video packet drops the rest of its group of pictures too, they can't be decoded without it.
+    void write(std::shared_ptr<AVPacket> pkt, bool is_video)
+    {
+        if (is_video) {
+            if (video_gap && !(pkt->flags & AV_PKT_FLAG_KEY)) {
+                return;
+            }
+            video_gap = !packet_buffer.try_push(pkt);
+        } else {
+            packet_buffer.try_push(pkt);
+        }
+    }
+
+    // A nullptr flushes the encoder and ends the video.
+    void send(const std::shared_ptr<AVFrame>& main_frame)
+    {
+        if (failed || ended) {
+            return;
+        }
+
+        if (!main_frame) {
+            end();
+        } else if (!frame_buffer.try_push(main_frame)) {
+            skipped_frames += 1;
+        }
+    }
+
+    void encode(const std::shared_ptr<AVFrame>& main_frame)
+    {
+        if (failed) {
+            return;
+        }
+
+        try {
+            video->pts += skipped_frames.exchange(0);
+
+            if (main_frame && main_frame != source) {
+                auto frame2                 = alloc_frame();
+                frame2->sample_aspect_ratio = main_frame->sample_aspect_ratio;
+                frame2->width               = video->enc->width;
+                frame2->height              = video->enc->height;
+                frame2->format              = main_frame->format;
+                frame2->colorspace          = main_frame->colorspace;
+                frame2->color_primaries     = main_frame->color_primaries;
+                frame2->color_range         = main_frame->color_range;
+                frame2->color_trc           = main_frame->color_trc;
+                av_frame_get_buffer(frame2.get(), 64);
+
+                tbb::parallel_for(0, 4, [&](int n) {
+                    const auto width = n == 1 || n == 2 ? frame2->width / 2 : frame2->width;
+                    downsample_plane(main_frame->data[n],
+                                     main_frame->linesize[n],
+                                     frame2->data[n],
+                                     frame2->linesize[n],
+                                     width,
+                                     frame2->height,
+                                     factor,
+                                     bilinear);
+                });
+
+                source = main_frame;
+                frame  = frame2;
+            }
+
+            video->send(main_frame ? frame : nullptr,
+                        [this](std::shared_ptr<AVPacket>&& pkt) { write(std::move(pkt), true); });
+        } catch (...) {
+            disable();
+        }
+    }
+
+    void send(const std::shared_ptr<AVPacket>& pkt, AVRational time_base)
+    {
+        if (!audio_st || failed) {
+            return;
+        }
+
+        try {
+            auto pkt2 = alloc_packet();
+            FF(av_packet_ref(pkt2.get(), pkt.get()));
+            pkt2->stream_index = audio_st->index;
+            av_packet_rescale_ts(pkt2.get(), time_base, audio_st->time_base);
+            write(std::move(pkt2), false);
+        } catch (...) {
+            disable();
+        }
+    }
+
+    void close()
+    {
+        end();
+        packet_buffer.push(nullptr);
+        packet_thread.join();
+    }
+};
+
+// Realtime outputs only buffer a single frame, so when the encoder cannot keep up frames are lost at
+// random. Instead we step down through a ladder of cheaper quality levels while encoding lags behind and
+// step back up once it has recovered:
+//   full quality
+//   fast colour conversion
+//   one encoder preset faster    (reopens the encoder, only for outputs without global headers)
+//   half resolution              (reopens the encoder, only for outputs without global headers)
+//   every other frame is a repeat of the previous one
+//   only every fourth frame is encoded
+struct quality
+{
+    bool fast_sws    = false;
+    bool fast_preset = false;
+    int  scale       = 1;
+    int  interval    = 1; // every interval'th frame is encoded, the others repeat it
+};
+
+struct realtime_governor
+{
+    std::vector<quality> ladder;
+
+    int    level = 0;
+    double lag   = 0.0; // smoothed encode time of encoded frames in frame durations
+
+    int lagging    = 0;
+    int recovering = 0;
+    int stable     = 0;
+
+    // Stepping down to a level that lagged waits twice as long every time it lags again, so a level that can
+    // only just not keep up isn't retried every few seconds. A level that holds for a minute is trusted again.
+    std::vector<int> backoff;
+
+    realtime_governor(bool preset, bool rescale)
+    {
+        quality q;
+        ladder.push_back(q);
+        q.fast_sws = true;
+        ladder.push_back(q);
+        if (preset) {
+            q.fast_preset = true;
+            ladder.push_back(q);
+        }
+        if (rescale) {
+            q.scale = 2;
+            ladder.push_back(q);
+        }
+        q.interval = 2;
+        ladder.push_back(q);
+        q.interval = 4;
+        ladder.push_back(q);
+
+        backoff.assign(ladder.size(), 1);
+    }
+
+    int max_level() const { return static_cast<int>(ladder.size()) - 1; }
+
+    const quality& current() const { return ladder[level]; }
+
+    bool duplicate(std::int64_t frame_number) const { return frame_number % ladder[level].interval != 0; }
+
+    // Repeats take almost no time and would hide the cost of the frames that are encoded, so only encoded frames
+    // are measured. Their budget is the repeats that follow, but the single frame buffer can't hold more than one
+    // frame while an encode overruns.
+    double load(int index) const { return lag / std::min(ladder[index].interval, 2); }
+
+    void update(double frame_time, bool encoded, bool dropped, double fps)
+    {
+        if (encoded) {
+            lag = lag * 0.9 + frame_time * 0.1;
+        }
+
+        if (dropped || load(level) > 0.9) {
+            recovering = 0;
+            stable     = 0;
+            if (++lagging >= 4 && level < max_level()) {
+                backoff[level] = std::min(backoff[level] * 2, 32);
+                level += 1;
+                lagging = 0;
+                lag     = 0.5 * std::min(ladder[level].interval, 2);
+            }
+            return;
+        }
+
+        lagging = 0;
+        if (++stable >= static_cast<int>(fps * 60.0)) {
+            backoff[level] = 1;
+            stable         = 0;
+        }
+
+        // Encoded frames cost the same with fewer repeats, so the level below must fit the current cost.
+        if (level > 0 && load(level - 1) < 0.5) {
+            if (++recovering >= static_cast<int>(fps * 2.0) * backoff[level - 1]) {
+                level -= 1;
+                recovering = 0;
+                stable     = 0;
+            }
+        } else {
+            recovering = 0;
+        }
+    }
+};
+
 struct ffmpeg_consumer : public core::frame_consumer
 {
     core::monitor::state    state_;
@@ -482,8 +1086,12 @@ struct ffmpeg_consumer : public core::frame_consumer
     std::exception_ptr exception_;
     std::mutex         exception_mutex_;
 
-    tbb::concurrent_bounded_queue<core::const_frame> frame_buffer_;
-    std::thread                                      frame_thread_;
+    // Frames with the channel tick they were sent on, counting dropped frames, so that fields keep their parity.
+    tbb::concurrent_bounded_queue<std::pair<core::const_frame, std::int64_t>> frame_buffer_;
+    std::thread                                                               frame_thread_;
+
+    std::atomic<int> dropped_frames_{0};
+    std::int64_t     ticks_ = 0;
 
   public:
     ffmpeg_consumer(std::string path, std::string args, bool realtime)
@@ -504,12 +1112,16 @@ struct ffmpeg_consumer : public core::frame_consumer
         graph_->set_color("frame-time", diagnostics::color(0.1f, 1.0f, 0.1f));
         graph_->set_color("dropped-frame", diagnostics::color(0.3f, 0.6f, 0.3f));
         graph_->set_color("input", diagnostics::color(0.7f, 0.4f, 0.4f));
+        if (realtime_) {
+            graph_->set_color("quality-level", diagnostics::color(0.9f, 0.9f, 0.3f));
+            graph_->set_color("duplicated-frame", diagnostics::color(0.6f, 0.3f, 0.9f));
+        }
     }
 
     ~ffmpeg_consumer()
     {
         if (frame_thread_.joinable()) {
-            frame_buffer_.push(core::const_frame{});
+            frame_buffer_.push(std::make_pair(core::const_frame{}, ticks_));
             frame_thread_.join();
         }
     }
@@ -540,22 +1152,32 @@ struct ffmpeg_consumer : public core::frame_consumer
                     }
                 }
 
-                boost::filesystem::path full_path = path_;
-
-                static boost::regex prot_exp("^.+:.*");
-                if (!boost::regex_match(path_, prot_exp)) {
-                    if (!full_path.is_complete()) {
-                        full_path = u8(env::media_folder()) + path_;
+                std::string proxy_path;
+                int         proxy_factor   = 4;
+                bool        proxy_bilinear = false;
+                {
+                    const auto proxy_it = options.find("proxy");
+                    if (proxy_it != options.end()) {
+                        proxy_path = std::move(proxy_it->second);
+                        options.erase(proxy_it);
                     }
-
-                    // TODO -y?
-                    if (boost::filesystem::exists(full_path)) {
-                        boost::filesystem::remove(full_path);
+                    const auto scale_it = options.find("proxy_scale");
+                    if (scale_it != options.end()) {
+                        proxy_factor = std::stoi(scale_it->second);
+                        options.erase(scale_it);
+                    }
+                    const auto filter_it = options.find("proxy_filter");
+                    if (filter_it != options.end()) {
+                        if (filter_it->second != "box" && filter_it->second != "bilinear") {
+                            CASPAR_THROW_EXCEPTION(user_error() << msg_info("Invalid proxy filter."));
+                        }
+                        proxy_bilinear = filter_it->second == "bilinear";
+                        options.erase(filter_it);
                     }
-
-                    boost::filesystem::create_directories(full_path.parent_path());
                 }
 
+                const auto full_path = resolve_path(path_);
+
                 AVFormatContext* oc = nullptr;
 
                 {
@@ -574,12 +1196,28 @@ struct ffmpeg_consumer : public core::frame_consumer
 
                 CASPAR_SCOPE_EXIT { avformat_free_context(oc); };
 
+                // Interlaced channels send a field per tick. With -field_order:v the fields are woven into frames at
+                // the frame rate, tt or bt show the top field first and bb or tb the bottom field.
+                auto video_desc = format_desc;
+                auto weave      = false;
+                auto top_first  = true;
+                {
+                    const auto it = options.find("field_order:v");
+                    if (it != options.end() && it->second != "progressive" && format_desc.field_count == 2) {
+                        weave     = true;
+                        top_first = it->second == "tt" || it->second == "bt";
+                        video_desc.duration *= 2;
+                        video_desc.framerate /= 2;
+                        video_desc.fps /= 2.0;
+                    }
+                }
+
                 boost::optional<Stream> video_stream;
                 if (oc->oformat->video_codec != AV_CODEC_ID_NONE) {
                     if (oc->oformat->video_codec == AV_CODEC_ID_H264 && options.find("preset:v") == options.end()) {
                         options["preset:v"] = "veryfast";
                     }
-                    video_stream.emplace(oc, ":v", oc->oformat->video_codec, format_desc, realtime_, options);
+                    video_stream.emplace(oc, ":v", oc->oformat->video_codec, video_desc, realtime_, options);
                     state_["file/fps"] = av_q2d(av_buffersink_get_frame_rate(video_stream->sink));
                 }
 
@@ -588,6 +1226,21 @@ struct ffmpeg_consumer : public core::frame_consumer
                     audio_stream.emplace(oc, ":a", oc->oformat->audio_codec, format_desc, realtime_, options);
                 }
 
+                std::unique_ptr<Proxy> proxy;
+                if (!proxy_path.empty()) {
+                    if (video_stream) {
+                        proxy.reset(new Proxy(proxy_path,
+                                              proxy_factor,
+                                              proxy_bilinear,
+                                              video_desc,
+                                              realtime_,
+                                              audio_stream ? &*audio_stream : nullptr));
+                        state_["file/proxy/path"] = proxy_path;
+                    } else {
+                        CASPAR_LOG(warning) << print() << " Ignoring proxy for output without video.";
+                    }
+                }
+
                 if (!(oc->oformat->flags & AVFMT_NOFILE)) {
                     // TODO (fix) interrupt_cb
                     auto dict = to_dict(std::move(options));
@@ -613,32 +1266,7 @@ struct ffmpeg_consumer : public core::frame_consumer
                 packet_buffer.set_capacity(realtime_ ? 1 : 128);
                 auto packet_thread = std::thread([&] {
                     try {
-                        CASPAR_SCOPE_EXIT
-                        {
-                            if (!(oc->oformat->flags & AVFMT_NOFILE)) {
-                                FF(avio_closep(&oc->pb));
-                            }
-                        };
-
-                        std::map<int, int64_t> count;
-
-                        std::shared_ptr<AVPacket> pkt;
-                        while (true) {
-                            packet_buffer.pop(pkt);
-                            if (!pkt) {
-                                break;
-                            }
-                            count[pkt->stream_index] += 1;
-                            FF(av_interleaved_write_frame(oc, pkt.get()));
-                        }
-
-                        auto video_st = video_stream ? video_stream->st : nullptr;
-                        auto audio_st = audio_stream ? audio_stream->st : nullptr;
-
-                        if ((!video_st || count[video_st->index]) && (!audio_st || count[audio_st->index])) {
-                            FF(av_write_trailer(oc));
-                        }
-
+                        write_packets(oc, packet_buffer);
                     } catch (...) {
                         CASPAR_LOG_CURRENT_EXCEPTION();
                         // TODO
@@ -657,25 +1285,90 @@ struct ffmpeg_consumer : public core::frame_consumer
 
                 auto packet_cb = [&](std::shared_ptr<AVPacket>&& pkt) { packet_buffer.push(std::move(pkt)); };
 
+                realtime_governor governor(video_stream && video_stream->can_change_preset(),
+                                           video_stream && video_stream->can_rescale());
+
+                core::const_frame first_field;
+
+                // The governor counts video frames, which are woven from two ticks when weaving.
                 std::int32_t frame_number = 0;
+                std::int64_t video_number = 0;
                 while (true) {
                     state_["file/frame"] = frame_number++;
 
-                    core::const_frame frame;
-                    frame_buffer_.pop(frame);
+                    std::pair<core::const_frame, std::int64_t> tick;
+                    frame_buffer_.pop(tick);
                     graph_->set_value("input", (static_cast<double>(frame_buffer_.size() + 0.001) / frame_buffer_.capacity()));
 
+                    const auto& frame = tick.first;
+
+                    // Fields are paired by the parity of their tick. A field whose partner was dropped is woven with
+                    // itself, so that the field order and the video timeline hold.
+                    auto picture    = frame;
+                    auto send_video = true;
+                    if (weave && frame) {
+                        if (tick.second % 2 == 0) {
+                            send_video  = static_cast<bool>(first_field);
+                            picture     = first_field ? weave_frame(first_field, first_field, top_first) : frame;
+                            first_field = frame;
+                        } else {
+                            picture     = weave_frame(first_field ? first_field : frame, frame, top_first);
+                            first_field = core::const_frame{};
+                        }
+                    }
+
+                    const auto duplicate = realtime_ && send_video && governor.duplicate(++video_number);
+
                     caspar::timer frame_timer;
                     tbb::parallel_invoke([&] {
-                        if (video_stream) {
-                            video_stream->send(frame, format_desc, packet_cb);
+                        if (video_stream && send_video) {
+                            auto video = picture ? video_stream->convert(picture, format_desc, duplicate) : nullptr;
+                            if (video && weave) {
+                                video->interlaced_frame = 1;
+                                video->top_field_first  = top_first ? 1 : 0;
+                            }
+                            tbb::parallel_invoke([&] {
+                                video_stream->send(video, packet_cb);
+                            }, [&] {
+                                if (proxy) {
+                                    proxy->send(video);
+                                }
+                            });
                         }
                     }, [&] {
                         if (audio_stream) {
-                            audio_stream->send(frame, format_desc, packet_cb);
+                            audio_stream->send(frame, format_desc, [&](std::shared_ptr<AVPacket>&& pkt) {
+                                if (proxy) {
+                                    proxy->send(pkt, audio_stream->st->time_base);
+                                }
+                                packet_cb(std::move(pkt));
+                            });
                         }
                     });
-                    graph_->set_value("frame-time", frame_timer.elapsed() * format_desc.fps * 0.5);
+                    const auto frame_time = frame_timer.elapsed() * format_desc.fps;
+                    graph_->set_value("frame-time", frame_time * 0.5);
+
+                    if (realtime_ && frame && send_video) {
+                        // Woven frames are measured against the duration of both their ticks.
+                        governor.update(frame_time * video_desc.fps / format_desc.fps,
+                                        !duplicate,
+                                        dropped_frames_.exchange(0) > 0,
+                                        video_desc.fps);
+
+                        const auto& settings = governor.current();
+                        if (video_stream) {
+                            video_stream->fast_sws = settings.fast_sws;
+                            video_stream->reconfigure(settings.fast_preset, settings.scale, packet_cb);
+                        }
+                        if (duplicate) {
+                            graph_->set_tag(diagnostics::tag_severity::INFO, "duplicated-frame");
+                        }
+                        graph_->set_value("quality-level",
+                                          static_cast<double>(governor.level) / governor.max_level());
+
+                        state_["file/quality-level"] = governor.level;
+                        state_["file/lag"]           = governor.lag;
+                    }
 
                     if (!frame) {
                         packet_buffer.push(nullptr);
@@ -684,6 +1377,9 @@ struct ffmpeg_consumer : public core::frame_consumer
                 }
 
                 packet_thread.join();
+                if (proxy) {
+                    proxy->close();
+                }
             } catch (...) {
                 std::lock_guard<std::mutex> lock(exception_mutex_);
                 exception_ = std::current_exception();
@@ -700,8 +1396,9 @@ struct ffmpeg_consumer : public core::frame_consumer
             }
         }
 
-        if (!frame_buffer_.try_push(frame)) {
+        if (!frame_buffer_.try_push(std::make_pair(frame, ticks_++))) {
             graph_->set_tag(diagnostics::tag_severity::WARNING, "dropped-frame");
+            dropped_frames_ += 1;
         }
         graph_->set_value("input", (static_cast<double>(frame_buffer_.size() + 0.001) / frame_buffer_.capacity()));
 
@@ -21,12 +21,138 @@
 
 #include "image_algorithms.h"
 
+#include <common/premultiply.h>
+
+#include <tbb/parallel_for.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <smmintrin.h>
+#endif
+
 #include <algorithm>
+#include <array>
 #include <cstdint>
 #include <vector>
 
 namespace caspar { namespace image {
 
+namespace {
+
+const std::size_t pixels_per_task = 16384;
+
+bool is_opaque(__m128i pixels)
+{
+    return (_mm_movemask_epi8(_mm_cmpeq_epi8(pixels, _mm_set1_epi8(-1))) & 0x8888) == 0x8888;
+}
+
+// Two pixels of 16 bit channels. The alpha lanes are multiplied by 255 and so are kept.
+__m128i premultiply_pixels(__m128i pixels)
+{
+    auto alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    alpha      = _mm_or_si128(alpha, _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255));
+    return caspar::premultiply_epi16(pixels, alpha);
+}
+
+void premultiply_span(std::uint8_t* pixels, std::size_t count)
+{
+    const auto zero = _mm_setzero_si128();
+
+    std::size_t n = 0;
+    for (; n + 4 <= count; n += 4) {
+        const auto ptr = reinterpret_cast<__m128i*>(pixels + n * 4);
+        const auto v   = _mm_loadu_si128(ptr);
+
+        if (is_opaque(v)) {
+            continue;
+        }
+
+        const auto lo = premultiply_pixels(_mm_unpacklo_epi8(v, zero));
+        const auto hi = premultiply_pixels(_mm_unpackhi_epi8(v, zero));
+        _mm_storeu_si128(ptr, _mm_packus_epi16(lo, hi));
+    }
+
+    for (; n < count; ++n) {
+        auto pixel = pixels + n * 4;
+        for (int c = 0; c < 3; ++c) {
+            pixel[c] = static_cast<std::uint8_t>(caspar::premultiply(pixel[c], pixel[3]));
+        }
+    }
+}
+
+// 255 / a in 16.16 fixed point, rounded up so that (c * r + 0x8000) >> 16 is c * 255 / a rounded to nearest for all
+// c <= a. Zero alpha maps to 1.0 to leave such pixels as they are.
+const std::array<std::uint32_t, 256>& reciprocals()
+{
+    static const auto table = [] {
+        std::array<std::uint32_t, 256> result;
+        result[0] = 1 << 16;
+        for (std::uint32_t a = 1; a < 256; ++a) {
+            result[a] = ((255u << 16) + a - 1) / a;
+        }
+        return result;
+    }();
+    return table;
+}
+
+void unmultiply_span(std::uint8_t* pixels, std::size_t count)
+{
+    const auto& table = reciprocals();
+    const auto  round = _mm_set1_epi32(0x8000);
+    const auto  max   = _mm_set1_epi32(255);
+    const auto  alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+
+    // Channels above alpha are not valid premultiplied colors and saturate.
+    auto unmultiply_epi32 = [&](__m128i pixel, std::uint8_t a) {
+        const auto r = _mm_set1_epi32(static_cast<int>(table[a]));
+        const auto c = _mm_srli_epi32(_mm_add_epi32(_mm_mullo_epi32(_mm_cvtepu8_epi32(pixel), r), round), 16);
+        return _mm_min_epi32(c, max);
+    };
+
+    std::size_t n = 0;
+    for (; n + 4 <= count; n += 4) {
+        const auto p   = pixels + n * 4;
+        const auto ptr = reinterpret_cast<__m128i*>(p);
+        const auto v   = _mm_loadu_si128(ptr);
+
+        if (is_opaque(v)) {
+            continue;
+        }
+
+        const auto p0 = unmultiply_epi32(v, p[3]);
+        const auto p1 = unmultiply_epi32(_mm_srli_si128(v, 4), p[7]);
+        const auto p2 = unmultiply_epi32(_mm_srli_si128(v, 8), p[11]);
+        const auto p3 = unmultiply_epi32(_mm_srli_si128(v, 12), p[15]);
+
+        const auto result = _mm_packus_epi16(_mm_packus_epi32(p0, p1), _mm_packus_epi32(p2, p3));
+        _mm_storeu_si128(ptr, _mm_blendv_epi8(result, v, alpha));
+    }
+
+    for (; n < count; ++n) {
+        auto pixel = pixels + n * 4;
+        for (int c = 0; c < 3; ++c) {
+            pixel[c] = static_cast<std::uint8_t>(std::min(255u, (pixel[c] * table[pixel[3]] + 0x8000) >> 16));
+        }
+    }
+}
+
+template <typename Func>
+void parallel_spans(image_view<bgra_pixel>& view, Func func)
+{
+    auto pixels = reinterpret_cast<std::uint8_t*>(view.begin());
+    auto count  = static_cast<std::size_t>(view.end() - view.begin());
+
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, count, pixels_per_task),
+                      [&](const tbb::blocked_range<std::size_t>& r) { func(pixels + r.begin() * 4, r.size()); });
+}
+
+} // namespace
+
+void premultiply(image_view<bgra_pixel>& view_to_modify) { parallel_spans(view_to_modify, premultiply_span); }
+
+void unmultiply(image_view<bgra_pixel>& view_to_modify) { parallel_spans(view_to_modify, unmultiply_span); }
+
 std::vector<std::pair<int, int>> get_line_points(int num_pixels, double angle_radians)
 {
     std::vector<std::pair<int, int>> line_points;
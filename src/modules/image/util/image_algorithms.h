@@ -21,6 +21,8 @@
 
 #pragma once
 
+#include "image_view.h"
+
 #include <common/tweener.h>
 
 #include <algorithm>
@@ -226,4 +228,23 @@ void unmultiply(SrcDstView& view_to_modify)
     });
 }
 
+/**
+ * Vectorised and parallel premultiply of a BGRA image view, chosen over the
+ * generic version for image_view<bgra_pixel>. Each channel becomes
+ * c * a / 255 rounded to nearest.
+ *
+ * @param view_to_modify The image view to premultiply in place.
+ */
+void premultiply(image_view<bgra_pixel>& view_to_modify);
+
+/**
+ * Vectorised and parallel un-multiply of a BGRA image view, chosen over the
+ * generic version for image_view<bgra_pixel>. Each channel becomes
+ * c * 255 / a rounded to nearest, using a table of reciprocals. Pixels with
+ * zero alpha are left as is.
+ *
+ * @param view_to_modify The image view to unmultiply in place.
+ */
+void unmultiply(image_view<bgra_pixel>& view_to_modify);
+
 }} // namespace caspar::image
@@ -39,6 +39,8 @@
 #include <boost/property_tree/ptree.hpp>
 
 #include <atomic>
+#include <cstdint>
+#include <vector>
 
 #include "../util/air_send.h"
 
@@ -52,6 +54,7 @@ struct newtek_ivga_consumer : public core::frame_consumer
     std::atomic<bool>                   connected_ = false;
     spl::shared_ptr<diagnostics::graph> graph_;
     timer                               tick_timer_;
+    std::vector<std::int16_t>           audio_buffer_; // Reused every frame.
 
   public:
     newtek_ivga_consumer()
@@ -99,10 +102,12 @@ struct newtek_ivga_consumer : public core::frame_consumer
         caspar::timer frame_timer;
 
         {
-            auto audio_buffer = core::audio_32_to_16(frame.audio_data());
+            const auto& audio = frame.audio_data();
+            audio_buffer_.resize(audio.size());
+            core::audio_32_to_16(audio.data(), audio_buffer_.data(), audio.size());
             airsend::add_audio(air_send_.get(),
-                               audio_buffer.data(),
-                               static_cast<int>(audio_buffer.size()) / format_desc_.audio_channels);
+                               audio_buffer_.data(),
+                               static_cast<int>(audio_buffer_.size()) / format_desc_.audio_channels);
         }
 
         {
@@ -315,6 +315,8 @@ struct oal_consumer : public core::frame_consumer
 
     bool has_synchronization_clock() const override { return false; }
 
+    bool supports_audio_only() const override { return true; }
+
     int index() const override { return 500; }
 
     const core::monitor::state& state() const override { return state_; }
@@ -42,6 +42,7 @@
 #include <core/consumer/output.h>
 #include <core/diagnostics/call_context.h>
 #include <core/diagnostics/osd_graph.h>
+#include <core/frame/audio_delay.h>
 #include <core/frame/frame_transform.h>
 #include <core/mixer/mixer.h>
 #include <core/producer/cg_proxy.h>
@@ -257,6 +258,17 @@ std::wstring loadbg_command(command_context& ctx)
             transitionInfo.direction = transition_direction::from_left;
     }
 
+    static const boost::wregex audio_expr(LR"(.*AUDIOCURVE\s*(?<CURVE>EQUALPOWER|LINEAR|LOG)\b.*)");
+    if (boost::regex_match(message, what, audio_expr)) {
+        auto curve = what["CURVE"].str();
+        if (curve == L"LINEAR")
+            transitionInfo.audio_curve = transition_curve::linear;
+        else if (curve == L"LOG")
+            transitionInfo.audio_curve = transition_curve::log;
+        else
+            transitionInfo.audio_curve = transition_curve::equal_power;
+    }
+
     // Perform loading of the clip
     core::diagnostics::scoped_call_context save;
     core::diagnostics::call_context::for_thread().video_channel = ctx.channel_index + 1;
@@ -1146,6 +1158,95 @@ std::wstring mixer_mastervolume_command(command_context& ctx)
     return L"202 MIXER OK\r\n";
 }
 
+std::wstring mixer_audiorouting_command(command_context& ctx)
+{
+    if (ctx.parameters.empty())
+        return reply_value(ctx, [](const frame_transform& t) { return t.audio_transform.matrix.print(); });
+
+    transforms_applier transforms(ctx);
+
+    // A preset or output:input[:gain] cells, followed by the optional duration and tween.
+    auto end = std::find_if(ctx.parameters.begin() + 1, ctx.parameters.end(), [](const std::wstring& param) {
+        return param.find(L':') == std::wstring::npos;
+    });
+    auto channels = ctx.channel.channel->video_format_desc().audio_channels;
+    auto matrix   = create_audio_matrix(std::vector<std::wstring>(ctx.parameters.begin(), end), channels);
+
+    std::size_t  next     = end - ctx.parameters.begin();
+    int          duration = ctx.parameters.size() > next ? boost::lexical_cast<int>(ctx.parameters[next]) : 0;
+    std::wstring tween    = ctx.parameters.size() > next + 1 ? ctx.parameters[next + 1] : L"linear";
+
+    transforms.add(stage::transform_tuple_t(ctx.layer_index(),
+                                            [=](frame_transform transform) -> frame_transform {
+                                                transform.audio_transform.matrix = matrix;
+                                                return transform;
+                                            },
+                                            duration,
+                                            tween));
+    transforms.apply();
+
+    return L"202 MIXER OK\r\n";
+}
+
+std::wstring mixer_loudness_command(command_context& ctx)
+{
+    if (!ctx.parameters.empty() && boost::iequals(ctx.parameters.at(0), L"RESET")) {
+        ctx.channel.channel->mixer().reset_loudness();
+        return L"202 MIXER OK\r\n";
+    }
+
+    auto loudness = ctx.channel.channel->mixer().get_loudness();
+
+    std::wstringstream replyString;
+    replyString << L"201 MIXER OK\r\n" << loudness.momentary << L" " << loudness.short_term << L" "
+                << loudness.integrated << L" " << loudness.range << L" " << loudness.true_peak << L"\r\n";
+    return replyString.str();
+}
+
+std::wstring mixer_limiter_command(command_context& ctx)
+{
+    auto settings = ctx.channel.channel->mixer().get_limiter();
+
+    if (ctx.parameters.empty()) {
+        std::wstringstream replyString;
+        replyString << L"201 MIXER OK\r\n"
+                    << (settings.enabled ? 1 : 0) << L" " << settings.threshold << L" " << settings.release * 1000.0
+                    << L" " << settings.look_ahead * 1000.0 << L"\r\n";
+        return replyString.str();
+    }
+
+    // Enabled, then the optional threshold in dBFS, release in ms and look-ahead in ms.
+    settings.enabled = boost::lexical_cast<int>(ctx.parameters.at(0)) != 0;
+    if (ctx.parameters.size() > 1)
+        settings.threshold = boost::lexical_cast<double>(ctx.parameters.at(1));
+    if (ctx.parameters.size() > 2)
+        settings.release = boost::lexical_cast<double>(ctx.parameters.at(2)) / 1000.0;
+    if (ctx.parameters.size() > 3)
+        settings.look_ahead = boost::lexical_cast<double>(ctx.parameters.at(3)) / 1000.0;
+
+    if (settings.release < 0.0 || settings.look_ahead < 0.0)
+        CASPAR_THROW_EXCEPTION(user_error() << msg_info(L"Limiter release and look-ahead can't be negative."));
+
+    ctx.channel.channel->mixer().set_limiter(settings);
+
+    return L"202 MIXER OK\r\n";
+}
+
+std::wstring mixer_audiodelay_command(command_context& ctx)
+{
+    auto& mixer = ctx.channel.channel->mixer();
+
+    if (ctx.parameters.empty())
+        return L"201 MIXER OK\r\n" + boost::lexical_cast<std::wstring>(mixer.get_audio_delay(ctx.layer_index())) +
+               L"\r\n";
+
+    // Milliseconds, or sample frames with the suffix SAMPLES. Negative delays make the audio early.
+    auto sample_rate = ctx.channel.channel->video_format_desc().audio_sample_rate;
+    mixer.set_audio_delay(ctx.layer_index(), parse_audio_delay(ctx.parameters.at(0), sample_rate));
+
+    return L"202 MIXER OK\r\n";
+}
+
 std::wstring mixer_grid_command(command_context& ctx)
 {
     transforms_applier transforms(ctx);
@@ -1417,6 +1518,10 @@ void register_commands(amcp_command_repository& repo)
     repo.register_channel_command(L"Mixer Commands", L"MIXER PERSPECTIVE", mixer_perspective_command, 0);
     repo.register_channel_command(L"Mixer Commands", L"MIXER VOLUME", mixer_volume_command, 0);
     repo.register_channel_command(L"Mixer Commands", L"MIXER MASTERVOLUME", mixer_mastervolume_command, 0);
+    repo.register_channel_command(L"Mixer Commands", L"MIXER AUDIOROUTING", mixer_audiorouting_command, 0);
+    repo.register_channel_command(L"Mixer Commands", L"MIXER LOUDNESS", mixer_loudness_command, 0);
+    repo.register_channel_command(L"Mixer Commands", L"MIXER LIMITER", mixer_limiter_command, 0);
+    repo.register_channel_command(L"Mixer Commands", L"MIXER AUDIODELAY", mixer_audiodelay_command, 0);
     repo.register_channel_command(L"Mixer Commands", L"MIXER GRID", mixer_grid_command, 1);
     repo.register_channel_command(L"Mixer Commands", L"MIXER COMMIT", mixer_commit_command, 0);
     repo.register_channel_command(L"Mixer Commands", L"MIXER CLEAR", mixer_clear_command, 0);
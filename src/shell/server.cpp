@@ -32,6 +32,7 @@
 #include <core/consumer/output.h>
 #include <core/diagnostics/call_context.h>
 #include <core/diagnostics/osd_graph.h>
+#include <core/frame/audio_delay.h>
 #include <core/mixer/image/image_mixer.h>
 #include <core/mixer/mixer.h>
 #include <core/producer/cg_proxy.h>
@@ -171,9 +172,20 @@ struct server::impl : boost::noncopyable
             if (format_desc.format == video_format::invalid)
                 CASPAR_THROW_EXCEPTION(user_error() << msg_info(L"Invalid video-mode: " + format_desc_str));
 
+            auto depth_value = xml_channel.second.get(L"color-depth", 8);
+            if (depth_value != 8 && depth_value != 16)
+                CASPAR_THROW_EXCEPTION(user_error() << msg_info(L"Invalid color-depth: " + boost::lexical_cast<std::wstring>(depth_value)));
+            auto depth = static_cast<core::color_depth>(depth_value);
+
             auto weak_client = std::weak_ptr<osc::client>(osc_client_);
             auto channel_id = static_cast<int>(channels_.size() + 1);
-            auto channel = spl::make_shared<video_channel>(channel_id, format_desc, accelerator_.create_image_mixer(channel_id), [channel_id, weak_client](const monitor::state& channel_state)
+
+            // Audio-only channels have no image mixer and do no GPU work.
+            std::unique_ptr<core::image_mixer> image_mixer;
+            if (!xml_channel.second.get(L"audio-only", false))
+                image_mixer = accelerator_.create_image_mixer(channel_id, depth);
+
+            auto channel = spl::make_shared<video_channel>(channel_id, format_desc, std::move(image_mixer), [channel_id, weak_client](const monitor::state& channel_state)
             {
                 monitor::state state;
                 state.insert_or_assign("/channel/" + boost::lexical_cast<std::string>(channel_id), channel_state);
@@ -195,8 +207,24 @@ struct server::impl : boost::noncopyable
                     auto name = xml_consumer.first;
 
                     try {
-                        if (name != L"<xmlcomment>")
-                            channel->output().add(consumer_registry_->create_consumer(name, xml_consumer.second, channels_));
+                        if (name != L"<xmlcomment>") {
+                            auto consumer = consumer_registry_->create_consumer(name, xml_consumer.second, channels_);
+                            channel->output().add(consumer);
+
+                            auto routing = xml_consumer.second.get(L"audio-routing", L"");
+                            if (!routing.empty()) {
+                                std::vector<std::wstring> params;
+                                boost::split(params, routing, boost::is_any_of(L" "), boost::token_compress_on);
+                                auto channels = channel->video_format_desc().audio_channels;
+                                channel->output().set_audio_matrix(consumer->index(), core::create_audio_matrix(params, channels));
+                            }
+
+                            auto delay = xml_consumer.second.get(L"audio-delay", L"");
+                            if (!delay.empty()) {
+                                auto sample_rate = channel->video_format_desc().audio_sample_rate;
+                                channel->output().set_audio_delay(consumer->index(), core::parse_audio_delay(delay, sample_rate));
+                            }
+                        }
                     } catch (...) {
                         CASPAR_LOG_CURRENT_EXCEPTION();
                     }
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "reference.h"
+
+#include <accelerator/cpu/image/blend.h>
+#include <accelerator/cpu/image/blend_kernel.h>
+#include <accelerator/cpu/util/simd.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <vector>
+
+using namespace caspar;
+using namespace caspar::accelerator;
+
+namespace {
+
+// Odd so that every vector width also runs its tail path.
+const std::size_t count = 1023;
+
+struct blend_case
+{
+    core::blend_mode mode;
+    bool             additive;
+    float            opacity;
+    bool             keys;
+};
+
+std::vector<blend_case> blend_cases()
+{
+    std::vector<blend_case> cases;
+    for (int mode = 0; mode < static_cast<int>(core::blend_mode::blend_mode_count); ++mode) {
+        cases.push_back({static_cast<core::blend_mode>(mode), false, 1.0f, false});
+        cases.push_back({static_cast<core::blend_mode>(mode), true, 0.6f, true});
+    }
+    return cases;
+}
+
+template <typename F>
+void check_blend(F&& blend)
+{
+    const auto source    = tests::random_bgra(count, 1);
+    const auto back      = tests::random_bgra(count, 2);
+    const auto local_key = tests::random_bytes(count, 3);
+    const auto layer_key = tests::random_bytes(count, 4);
+
+    for (const auto& c : blend_cases()) {
+        auto expected = back;
+        auto actual   = back;
+
+        const auto local = c.keys ? local_key.data() : nullptr;
+        const auto layer = c.keys ? layer_key.data() : nullptr;
+
+        cpu::detail::blend_span<tests::vec_scalar>(
+            expected.data(), source.data(), local, layer, count, c.mode, c.additive, c.opacity);
+        blend(actual.data(), source.data(), local, layer, count, c.mode, c.additive, c.opacity);
+
+        BOOST_TEST_CONTEXT("mode " << static_cast<int>(c.mode) << " additive " << c.additive)
+        {
+            BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+        }
+    }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(cpu_blend)
+
+BOOST_AUTO_TEST_CASE(sse_matches_scalar) { check_blend(cpu::detail::blend_span<cpu::vec_sse>); }
+
+BOOST_AUTO_TEST_CASE(avx2_matches_scalar)
+{
+    if (!cpu::detail::has_avx2()) {
+        BOOST_TEST_MESSAGE("AVX2 not supported, skipped.");
+        return;
+    }
+    check_blend(cpu::detail::blend_avx2);
+}
+
+BOOST_AUTO_TEST_CASE(key_matches_scalar)
+{
+    const auto source = tests::random_bgra(count, 5);
+    const auto key    = tests::random_bytes(count, 6);
+
+    auto expected = key;
+    auto actual   = key;
+    cpu::detail::blend_key_span<tests::vec_scalar>(expected.data(), source.data(), count);
+    cpu::blend_key(actual.data(), source.data(), count);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(image_matches_span)
+{
+    const int width  = 67;
+    const int height = 45;
+
+    const auto source = tests::random_bgra(width * height, 7);
+    const auto back   = tests::random_bgra(width * height, 8);
+
+    auto expected = back;
+    auto actual   = back;
+    cpu::blend(expected.data(), source.data(), nullptr, nullptr, expected.size() / 4, core::blend_mode::screen);
+    cpu::blend(actual.data(),
+               source.data(),
+               nullptr,
+               nullptr,
+               width,
+               height,
+               core::blend_mode::screen,
+               cpu::keyer::linear,
+               1.0f);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
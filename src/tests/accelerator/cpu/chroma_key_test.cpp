@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "reference.h"
+
+#include <accelerator/cpu/image/chroma_key.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <vector>
+
+using namespace caspar;
+using namespace caspar::accelerator;
+
+namespace {
+
+typedef tests::vec_scalar vec;
+
+// The shader's ChromaOnCustomColor, step by step in the order the kernel evaluates it.
+void reference_chroma_key(std::uint8_t* pixel, const core::chroma& chroma)
+{
+    const vec zero(0.0f);
+    const vec half(0.5f);
+    const vec one(1.0f);
+    const vec two(2.0f);
+    const vec three(3.0f);
+    const vec six(6.0f);
+
+    const vec target_hue(static_cast<float>(chroma.target_hue / 360.0));
+    const vec hue_width(static_cast<float>(chroma.hue_width));
+    const vec min_saturation(static_cast<float>(chroma.min_saturation));
+    const vec min_brightness(static_cast<float>(chroma.min_brightness));
+    const vec softness(static_cast<float>(chroma.softness));
+    const vec spill_suppress(static_cast<float>(chroma.spill_suppress / 360.0));
+    const vec spill_suppress_saturation(static_cast<float>(chroma.spill_suppress_saturation));
+
+    vec b, g, r, a;
+    vec::load_bgra(pixel, b, g, r, a);
+
+    const auto inverse = one / select(a > zero, a, one);
+    r                  = r * inverse;
+    g                  = g * inverse;
+    b                  = b * inverse;
+
+    // rgb2hsv.
+    const auto g_ge_b = g >= b;
+    const auto p_x    = select(g_ge_b, g, b);
+    const auto p_y    = select(g_ge_b, b, g);
+    const auto p_z    = select(g_ge_b, zero, vec(2.0f / 3.0f));
+    const auto p_w    = select(g_ge_b, vec(-1.0f / 3.0f), vec(-1.0f));
+    const auto r_ge_p = r >= p_x;
+    const auto q_x    = select(r_ge_p, r, p_x);
+    const auto q_z    = select(r_ge_p, p_w, p_z);
+    const auto q_w    = select(r_ge_p, p_x, r);
+    const auto d      = q_x - min(q_w, p_y);
+    const vec  e(1.0e-10f);
+
+    auto h = abs(q_z + (q_w - p_y) / (six * d + e));
+    auto s = d / (q_x + e);
+    auto v = q_x;
+
+    const auto hue_score    = (half - abs(abs(h - target_hue) - half)) * two - hue_width;
+    const auto sat_score    = min(zero, min_saturation - s);
+    const auto bright_score = min(zero, min_brightness - v);
+    const auto distance     = zero - hue_score * max(bright_score, sat_score);
+    const auto key          = distance * vec(-2.0f) + one;
+
+    const auto t     = min(max((key - one) / max(softness, vec(1.0e-6f)), zero), one);
+    const auto alpha = one - t * t * (three - two * t);
+
+    if (chroma.show_mask) {
+        const auto mask = alpha * a;
+        vec::store_bgra(pixel, mask, mask, mask, one);
+        return;
+    }
+
+    auto diff = h - target_hue;
+    diff      = select(diff < vec(-0.5f), diff + one, select(diff > half, diff - one, diff));
+
+    const auto spill    = abs(diff) / spill_suppress;
+    const auto suppress = spill < one;
+
+    h = select(suppress, select(diff < zero, target_hue - spill_suppress, target_hue + spill_suppress), h);
+    s = select(suppress, s * min(one, spill + spill_suppress_saturation), s);
+
+    // hsv2rgb.
+    auto channel = [&](vec offset) {
+        const auto x = h + offset;
+        const auto p = abs((x - floor(x)) * six - three);
+        return v * (one + (min(max(p - one, zero), one) - one) * s);
+    };
+
+    const auto scale = alpha * a;
+    vec::store_bgra(pixel,
+                    channel(vec(1.0f / 3.0f)) * scale,
+                    channel(vec(2.0f / 3.0f)) * scale,
+                    channel(zero) * scale,
+                    scale);
+}
+
+core::chroma green_key(bool show_mask)
+{
+    core::chroma chroma;
+    chroma.enable                    = true;
+    chroma.show_mask                 = show_mask;
+    chroma.target_hue                = 120.0;
+    chroma.hue_width                 = 0.1;
+    chroma.min_saturation            = 0.2;
+    chroma.min_brightness            = 0.1;
+    chroma.softness                  = 0.25;
+    chroma.spill_suppress            = 20.0;
+    chroma.spill_suppress_saturation = 0.5;
+    return chroma;
+}
+
+void check_chroma_key(const core::chroma& chroma)
+{
+    const std::size_t count = 1023;
+
+    auto expected = tests::random_bgra(count, 11);
+    auto actual   = expected;
+
+    for (std::size_t n = 0; n < count; ++n) {
+        reference_chroma_key(expected.data() + n * 4, chroma);
+    }
+    cpu::chroma_key(actual.data(), count, chroma);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(cpu_chroma_key)
+
+BOOST_AUTO_TEST_CASE(key_matches_scalar) { check_chroma_key(green_key(false)); }
+
+BOOST_AUTO_TEST_CASE(mask_matches_scalar) { check_chroma_key(green_key(true)); }
+
+BOOST_AUTO_TEST_CASE(image_matches_span)
+{
+    const int width  = 67;
+    const int height = 45;
+
+    auto expected = tests::random_bgra(width * height, 12);
+    auto actual   = expected;
+
+    cpu::chroma_key(expected.data(), expected.size() / 4, green_key(false));
+    cpu::chroma_key(actual.data(), width, height, green_key(false));
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "reference.h"
+
+#include <accelerator/cpu/image/color_correction.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+using namespace caspar;
+using namespace caspar::accelerator;
+
+namespace {
+
+const std::size_t count = 1023;
+
+// LevelsControl, brightness and contrast of the image shader on a straight color in [0, max].
+int reference_curve(int value, const core::image_transform& transform, int max)
+{
+    const auto& levels = transform.levels;
+
+    auto x = static_cast<double>(value) / max;
+    x      = std::min(std::max(x - levels.min_input, 0.0) / (levels.max_input - levels.min_input), 1.0);
+    x      = std::pow(x, 1.0 / levels.gamma);
+    x      = levels.min_output + (levels.max_output - levels.min_output) * x;
+    x      = 0.5 + (x * transform.brightness - 0.5) * transform.contrast;
+
+    return static_cast<int>(std::lround(std::min(std::max(x, 0.0), 1.0) * max));
+}
+
+template <typename T>
+void reference_levels(T* pixel, const core::image_transform& transform, int max)
+{
+    const std::int64_t alpha = pixel[3];
+    for (int c = 0; c < 3 && alpha > 0; ++c) {
+        const auto straight = std::min<std::int64_t>(max, (pixel[c] * max + alpha / 2) / alpha);
+        const auto curved   = static_cast<std::int64_t>(reference_curve(static_cast<int>(straight), transform, max));
+        pixel[c]            = static_cast<T>(alpha == max ? curved : (curved * alpha + max / 2) / max);
+    }
+}
+
+void reference_saturation(std::uint8_t* pixel, float saturation)
+{
+    typedef tests::vec_scalar vec;
+
+    vec b, g, r, a;
+    vec::load_bgra(pixel, b, g, r, a);
+
+    const auto intensity = b * vec(0.0722f) + g * vec(0.7152f) + r * vec(0.2126f);
+    vec::store_bgra(pixel,
+                    intensity + (b - intensity) * vec(saturation),
+                    intensity + (g - intensity) * vec(saturation),
+                    intensity + (r - intensity) * vec(saturation),
+                    a);
+}
+
+core::image_transform levels_transform()
+{
+    core::image_transform transform;
+    transform.levels.min_input  = 0.1;
+    transform.levels.max_input  = 0.9;
+    transform.levels.gamma      = 1.4;
+    transform.levels.min_output = 0.05;
+    transform.levels.max_output = 0.95;
+    transform.brightness        = 1.1;
+    transform.contrast          = 0.8;
+    return transform;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(cpu_color_correction)
+
+BOOST_AUTO_TEST_CASE(identity_is_disabled)
+{
+    cpu::color_correction correction;
+    correction.update(core::image_transform(), true);
+
+    BOOST_CHECK(!correction.enabled());
+}
+
+BOOST_AUTO_TEST_CASE(levels_match_reference)
+{
+    const auto transform = levels_transform();
+
+    cpu::color_correction correction;
+    correction.update(transform, true);
+
+    auto expected = tests::random_bgra(count, 21);
+    auto actual   = expected;
+
+    for (std::size_t n = 0; n < count; ++n) {
+        reference_levels(expected.data() + n * 4, transform, 255);
+    }
+    correction.apply(actual.data(), count);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(saturation_matches_scalar)
+{
+    core::image_transform transform;
+    transform.saturation = 1.7;
+
+    cpu::color_correction correction;
+    correction.update(transform, true);
+
+    auto expected = tests::random_bgra(count, 22);
+    auto actual   = expected;
+
+    for (std::size_t n = 0; n < count; ++n) {
+        reference_saturation(expected.data() + n * 4, 1.7f);
+    }
+    correction.apply(actual.data(), count);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(ten_bit_levels_match_reference)
+{
+    const auto transform = levels_transform();
+    const auto max       = 1023;
+
+    cpu::color_correction correction;
+    correction.update(transform, true, 10);
+
+    std::vector<std::uint16_t> expected;
+    for (auto value : tests::random_bgra(count, 23)) {
+        expected.push_back(static_cast<std::uint16_t>(value * max / 255));
+    }
+    auto actual = expected;
+
+    for (std::size_t n = 0; n < count; ++n) {
+        reference_levels(expected.data() + n * 4, transform, max);
+    }
+    correction.apply(actual.data(), count);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(wrong_depth_throws)
+{
+    cpu::color_correction correction;
+    correction.update(levels_transform(), true, 10);
+
+    std::vector<std::uint8_t> pixels(16);
+    BOOST_CHECK_THROW(correction.apply(pixels.data(), 4), std::exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "reference.h"
+
+#include <accelerator/cpu/image/pixel_convert.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+using namespace caspar;
+using namespace caspar::accelerator;
+
+namespace {
+
+struct picture
+{
+    core::pixel_format_desc                desc;
+    std::vector<std::vector<std::uint8_t>> planes;
+
+    std::vector<const std::uint8_t*> data() const
+    {
+        std::vector<const std::uint8_t*> result;
+        for (const auto& plane : planes) {
+            result.push_back(plane.data());
+        }
+        return result;
+    }
+};
+
+picture make_picture(core::pixel_format                  format,
+                     const std::vector<std::vector<int>>& planes,
+                     core::color_depth                   depth = core::color_depth::eight)
+{
+    picture result;
+    result.desc = core::pixel_format_desc(format, depth);
+
+    unsigned seed = 31;
+    for (const auto& plane : planes) {
+        const auto bytes = core::bytes_per_sample(depth);
+        result.desc.planes.push_back(core::pixel_format_desc::plane(plane[0], plane[1], plane[2] * bytes));
+        result.planes.push_back(tests::random_bytes(result.desc.planes.back().size, seed++));
+    }
+    return result;
+}
+
+std::uint8_t clamp_u8(int value) { return static_cast<std::uint8_t>(std::min(std::max(value, 0), 255)); }
+
+std::uint8_t premultiplied(int c, int a) { return static_cast<std::uint8_t>(std::lround(c * a / 255.0)); }
+
+int fixed(double value) { return static_cast<int>(std::lround(value * (1 << 13))); }
+
+// Y'CbCr to R'G'B' in 3.13 fixed point, each output channel rounded and clamped before premultiplication.
+std::vector<std::uint8_t> reference_ycbcr(const picture& pic, cpu::color_space space, bool full_range)
+{
+    const auto kr = space == cpu::color_space::bt601 ? 0.299 : (space == cpu::color_space::bt2020 ? 0.2627 : 0.2126);
+    const auto kb = space == cpu::color_space::bt601 ? 0.114 : (space == cpu::color_space::bt2020 ? 0.0593 : 0.0722);
+    const auto kg = 1.0 - kr - kb;
+    const auto ys = full_range ? 1.0 : 255.0 / 219.0;
+    const auto cs = full_range ? 1.0 : 255.0 / 224.0;
+
+    const auto y_offset = full_range ? 0 : 16;
+    const auto y_scale  = fixed(ys);
+    const auto cr_r     = fixed(2.0 * (1.0 - kr) * cs);
+    const auto cb_g     = fixed(-2.0 * kb * (1.0 - kb) / kg * cs);
+    const auto cr_g     = fixed(-2.0 * kr * (1.0 - kr) / kg * cs);
+    const auto cb_b     = fixed(2.0 * (1.0 - kb) * cs);
+
+    const auto& planes = pic.desc.planes;
+    const auto  width  = planes[0].width;
+    const auto  height = planes[0].height;
+
+    auto sample = [&](int n, int x, int y) {
+        const auto x_factor = (width + planes[n].width - 1) / planes[n].width;
+        const auto y_factor = (height + planes[n].height - 1) / planes[n].height;
+        return static_cast<int>(pic.planes[n][y / y_factor * planes[n].linesize + x / x_factor]);
+    };
+
+    std::vector<std::uint8_t> result(width * height * 4);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const auto l   = (sample(0, x, y) - y_offset) * y_scale + (1 << 12);
+            const auto u   = sample(1, x, y) - 128;
+            const auto v   = sample(2, x, y) - 128;
+            const auto a   = planes.size() > 3 ? sample(3, x, y) : 255;
+            const auto out = result.data() + (y * width + x) * 4;
+
+            out[0] = premultiplied(clamp_u8((l + u * cb_b) >> 13), a);
+            out[1] = premultiplied(clamp_u8((l + u * cb_g + v * cr_g) >> 13), a);
+            out[2] = premultiplied(clamp_u8((l + v * cr_r) >> 13), a);
+            out[3] = static_cast<std::uint8_t>(a);
+        }
+    }
+    return result;
+}
+
+// Byte positions of b, g, r and a in a packed source pixel, a < 0 means opaque.
+std::vector<std::uint8_t> reference_packed(const picture& pic, int b, int g, int r, int a)
+{
+    const auto& plane = pic.desc.planes[0];
+
+    std::vector<std::uint8_t> result(plane.width * plane.height * 4);
+    for (int n = 0; n < plane.width * plane.height; ++n) {
+        const auto in = pic.planes[0].data() + n * plane.stride;
+
+        result[n * 4 + 0] = in[b];
+        result[n * 4 + 1] = in[g];
+        result[n * 4 + 2] = in[r];
+        result[n * 4 + 3] = a < 0 ? 255 : in[a];
+    }
+    return result;
+}
+
+std::vector<std::uint8_t> reference_gray(const picture& pic, bool expand_range)
+{
+    const auto& plane = pic.desc.planes[0];
+    const auto  scale = fixed(255.0 / 219.0);
+
+    std::vector<std::uint8_t> result(plane.width * plane.height * 4);
+    for (int n = 0; n < plane.width * plane.height; ++n) {
+        const int  in = pic.planes[0][n];
+        const auto v  = expand_range ? clamp_u8(((in - 16) * scale + (1 << 12)) >> 13) : static_cast<std::uint8_t>(in);
+
+        std::fill(result.begin() + n * 4, result.begin() + n * 4 + 3, v);
+        result[n * 4 + 3] = 255;
+    }
+    return result;
+}
+
+std::vector<std::uint8_t> convert(const picture& pic, cpu::color_space space, bool full_range = false)
+{
+    const auto& plane = pic.desc.planes[0];
+
+    std::vector<std::uint8_t> result(plane.width * plane.height * 4);
+    cpu::to_bgra(result.data(), pic.desc, pic.data(), space, full_range);
+    return result;
+}
+
+void check_ycbcr(const std::vector<std::vector<int>>& planes)
+{
+    const auto format = planes.size() > 3 ? core::pixel_format::ycbcra : core::pixel_format::ycbcr;
+    const auto pic    = make_picture(format, planes);
+
+    for (auto space : {cpu::color_space::bt601, cpu::color_space::bt709, cpu::color_space::bt2020}) {
+        for (auto full_range : {false, true}) {
+            const auto expected = reference_ycbcr(pic, space, full_range);
+            const auto actual   = convert(pic, space, full_range);
+
+            BOOST_TEST_CONTEXT("space " << static_cast<int>(space) << " full range " << full_range)
+            {
+                BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+            }
+        }
+    }
+}
+
+void check_packed(core::pixel_format format, int stride, int b, int g, int r, int a)
+{
+    const auto pic      = make_picture(format, {{67, 9, stride}});
+    const auto expected = reference_packed(pic, b, g, r, a);
+    const auto actual   = convert(pic, cpu::color_space::bt709);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(cpu_pixel_convert)
+
+BOOST_AUTO_TEST_CASE(ycbcr_444_matches_scalar) { check_ycbcr({{67, 9, 1}, {67, 9, 1}, {67, 9, 1}}); }
+
+BOOST_AUTO_TEST_CASE(ycbcr_422_matches_scalar) { check_ycbcr({{67, 9, 1}, {34, 9, 1}, {34, 9, 1}}); }
+
+BOOST_AUTO_TEST_CASE(ycbcr_420_matches_scalar) { check_ycbcr({{67, 9, 1}, {34, 5, 1}, {34, 5, 1}}); }
+
+BOOST_AUTO_TEST_CASE(ycbcr_411_matches_scalar) { check_ycbcr({{67, 9, 1}, {17, 9, 1}, {17, 9, 1}}); }
+
+BOOST_AUTO_TEST_CASE(ycbcr_410_matches_scalar) { check_ycbcr({{67, 12, 1}, {17, 3, 1}, {17, 3, 1}}); }
+
+BOOST_AUTO_TEST_CASE(ycbcra_422_matches_scalar) { check_ycbcr({{67, 9, 1}, {34, 9, 1}, {34, 9, 1}, {67, 9, 1}}); }
+
+BOOST_AUTO_TEST_CASE(packed_match_scalar)
+{
+    check_packed(core::pixel_format::bgra, 4, 0, 1, 2, 3);
+    check_packed(core::pixel_format::rgba, 4, 2, 1, 0, 3);
+    check_packed(core::pixel_format::argb, 4, 3, 2, 1, 0);
+    check_packed(core::pixel_format::abgr, 4, 1, 2, 3, 0);
+    check_packed(core::pixel_format::bgr, 3, 0, 1, 2, -1);
+    check_packed(core::pixel_format::rgb, 3, 2, 1, 0, -1);
+}
+
+BOOST_AUTO_TEST_CASE(gray_matches_scalar)
+{
+    for (auto format : {core::pixel_format::gray, core::pixel_format::luma}) {
+        const auto pic      = make_picture(format, {{67, 9, 1}});
+        const auto expected = reference_gray(pic, format == core::pixel_format::luma);
+        const auto actual   = convert(pic, cpu::color_space::bt709);
+
+        BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(sixteen_bit_matches_rounded_eight_bit)
+{
+    const auto pic16 = make_picture(
+        core::pixel_format::ycbcra, {{67, 9, 1}, {34, 9, 1}, {34, 9, 1}, {67, 9, 1}}, core::color_depth::sixteen);
+
+    auto pic8 = make_picture(core::pixel_format::ycbcra, {{67, 9, 1}, {34, 9, 1}, {34, 9, 1}, {67, 9, 1}});
+    for (std::size_t n = 0; n < pic8.planes.size(); ++n) {
+        const auto samples = reinterpret_cast<const std::uint16_t*>(pic16.planes[n].data());
+        for (std::size_t i = 0; i < pic8.planes[n].size(); ++i) {
+            pic8.planes[n][i] = static_cast<std::uint8_t>(std::lround(samples[i] * 255.0 / 65535.0));
+        }
+    }
+
+    const auto expected = reference_ycbcr(pic8, cpu::color_space::bt709, false);
+    const auto actual   = convert(pic16, cpu::color_space::bt709);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(missing_planes_throw)
+{
+    const auto pic = make_picture(core::pixel_format::ycbcr, {{16, 4, 1}, {8, 4, 1}});
+
+    std::vector<std::uint8_t> dest(16 * 4 * 4);
+    BOOST_CHECK_THROW(cpu::to_bgra(dest.data(), pic.desc, pic.data(), cpu::color_space::bt709), std::exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace caspar { namespace tests {
+
+// One pixel per vector with the lane semantics of the SSE and AVX2 instructions the kernels use, so that the
+// templated kernels instantiated with it give the scalar reference the vector paths must match bit for bit.
+struct vec_scalar
+{
+    static const int width = 1;
+
+    float v;
+
+    vec_scalar() = default;
+    vec_scalar(float x)
+        : v(x)
+    {
+    }
+
+    static float from_u8(std::uint8_t x) { return static_cast<float>(x) * (1.0f / 255.0f); }
+
+    // maxps and minps return the second operand unless the comparison holds, cvtps rounds to nearest even.
+    static std::uint8_t to_u8(float x)
+    {
+        x = x > 0.0f ? x : 0.0f;
+        x = x < 1.0f ? x : 1.0f;
+        return static_cast<std::uint8_t>(std::nearbyint(x * 255.0f));
+    }
+
+    static void load_bgra(const std::uint8_t* src, vec_scalar& b, vec_scalar& g, vec_scalar& r, vec_scalar& a)
+    {
+        b = from_u8(src[0]);
+        g = from_u8(src[1]);
+        r = from_u8(src[2]);
+        a = from_u8(src[3]);
+    }
+
+    static void store_bgra(std::uint8_t* dest, vec_scalar b, vec_scalar g, vec_scalar r, vec_scalar a)
+    {
+        dest[0] = to_u8(b.v);
+        dest[1] = to_u8(g.v);
+        dest[2] = to_u8(r.v);
+        dest[3] = to_u8(a.v);
+    }
+
+    static vec_scalar load_key(const std::uint8_t* src) { return from_u8(*src); }
+
+    static void store_key(std::uint8_t* dest, vec_scalar k) { *dest = to_u8(k.v); }
+};
+
+// Comparisons give 1 for true and 0 for false, only ever consumed by select.
+inline vec_scalar operator+(vec_scalar a, vec_scalar b) { return a.v + b.v; }
+inline vec_scalar operator-(vec_scalar a, vec_scalar b) { return a.v - b.v; }
+inline vec_scalar operator*(vec_scalar a, vec_scalar b) { return a.v * b.v; }
+inline vec_scalar operator/(vec_scalar a, vec_scalar b) { return a.v / b.v; }
+inline vec_scalar operator<(vec_scalar a, vec_scalar b) { return a.v < b.v ? 1.0f : 0.0f; }
+inline vec_scalar operator>(vec_scalar a, vec_scalar b) { return a.v > b.v ? 1.0f : 0.0f; }
+inline vec_scalar operator>=(vec_scalar a, vec_scalar b) { return a.v >= b.v ? 1.0f : 0.0f; }
+inline vec_scalar operator==(vec_scalar a, vec_scalar b) { return a.v == b.v ? 1.0f : 0.0f; }
+inline vec_scalar min(vec_scalar a, vec_scalar b) { return a.v < b.v ? a.v : b.v; }
+inline vec_scalar max(vec_scalar a, vec_scalar b) { return a.v > b.v ? a.v : b.v; }
+inline vec_scalar abs(vec_scalar a) { return std::fabs(a.v); }
+inline vec_scalar floor(vec_scalar a) { return std::floor(a.v); }
+inline vec_scalar select(vec_scalar mask, vec_scalar a, vec_scalar b) { return mask.v != 0.0f ? a : b; }
+
+// Premultiplied BGRA noise with a mix of transparent, opaque and partly transparent pixels.
+inline std::vector<std::uint8_t> random_bgra(std::size_t count, unsigned seed)
+{
+    std::mt19937                       rng(seed);
+    std::uniform_int_distribution<int> dist(0, 255);
+
+    std::vector<std::uint8_t> pixels(count * 4);
+    for (std::size_t n = 0; n < count; ++n) {
+        auto       pixel = pixels.data() + n * 4;
+        const auto kind  = dist(rng) % 4;
+        const auto alpha = kind == 0 ? 0 : (kind == 1 ? 255 : dist(rng));
+
+        for (int c = 0; c < 3; ++c) {
+            pixel[c] = static_cast<std::uint8_t>(dist(rng) * alpha / 255);
+        }
+        pixel[3] = static_cast<std::uint8_t>(alpha);
+    }
+    return pixels;
+}
+
+inline std::vector<std::uint8_t> random_bytes(std::size_t count, unsigned seed)
+{
+    std::mt19937                       rng(seed);
+    std::uniform_int_distribution<int> dist(0, 255);
+
+    std::vector<std::uint8_t> bytes(count);
+    for (auto& byte : bytes) {
+        byte = static_cast<std::uint8_t>(dist(rng));
+    }
+    return bytes;
+}
+
+}} // namespace caspar::tests
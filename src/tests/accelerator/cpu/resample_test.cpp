@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "reference.h"
+
+#include <accelerator/cpu/image/resample.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+using namespace caspar;
+using namespace caspar::accelerator;
+
+namespace {
+
+// Power of two sizes keep the source coordinates of every destination pixel exact.
+const int source_width  = 64;
+const int source_height = 32;
+
+struct source
+{
+    std::vector<std::uint8_t> pixels = tests::random_bgra(source_width * source_height, 41);
+
+    int at(int x, int y, int c) const
+    {
+        x = std::min(std::max(x, 0), source_width - 1);
+        y = std::min(std::max(y, 0), source_height - 1);
+        return pixels[(y * source_width + x) * 4 + c];
+    }
+};
+
+// 8 bit weights, vertical pass then horizontal pass, each rounded.
+void reference_bilinear(const source& src, double u, double v, std::uint8_t* out)
+{
+    const auto fu = static_cast<int>((u + 1.0) * 256.0);
+    const auto fv = static_cast<int>((v + 1.0) * 256.0);
+    const auto x  = (fu >> 8) - 1;
+    const auto y  = (fv >> 8) - 1;
+    const auto wx = fu & 255;
+    const auto wy = fv & 255;
+
+    for (int c = 0; c < 4; ++c) {
+        const auto left  = (src.at(x, y, c) * (256 - wy) + src.at(x, y + 1, c) * wy + 128) >> 8;
+        const auto right = (src.at(x + 1, y, c) * (256 - wy) + src.at(x + 1, y + 1, c) * wy + 128) >> 8;
+        out[c]           = static_cast<std::uint8_t>((left * (256 - wx) + right * wx + 128) >> 8);
+    }
+}
+
+void reference_weights(double t, float weights[4])
+{
+    const auto s0 = (1.0 - t) * (1.0 - t) * (1.0 - t);
+    const auto s1 = (2.0 - t) * (2.0 - t) * (2.0 - t);
+    const auto s2 = (3.0 - t) * (3.0 - t) * (3.0 - t);
+    const auto x  = s0;
+    const auto y  = s1 - 4.0 * s0;
+    const auto z  = s2 - 4.0 * s1 + 6.0 * s0;
+
+    weights[0] = static_cast<float>(x / 6.0);
+    weights[1] = static_cast<float>(y / 6.0);
+    weights[2] = static_cast<float>(z / 6.0);
+    weights[3] = static_cast<float>((6.0 - x - y - z) / 6.0);
+}
+
+// Single precision sums of the B-spline taps, rows first.
+void reference_bicubic(const source& src, double u, double v, std::uint8_t* out)
+{
+    const auto x = static_cast<int>(std::floor(u));
+    const auto y = static_cast<int>(std::floor(v));
+
+    float wx[4];
+    float wy[4];
+    reference_weights(u - x, wx);
+    reference_weights(v - y, wy);
+
+    for (int c = 0; c < 4; ++c) {
+        auto sum = 0.0f;
+        for (int j = 0; j < 4; ++j) {
+            auto row = 0.0f;
+            for (int i = 0; i < 4; ++i) {
+                row = row + static_cast<float>(src.at(x - 1 + i, y - 1 + j, c)) * wx[i];
+            }
+            sum = sum + row * wy[j];
+        }
+        sum    = sum > 0.0f ? sum : 0.0f;
+        sum    = sum < 255.0f ? sum : 255.0f;
+        out[c] = static_cast<std::uint8_t>(std::nearbyint(sum));
+    }
+}
+
+// Draws the whole source scaled by two onto a destination of twice its size.
+template <typename F>
+void check_upscale(cpu::resample_filter filter, F&& reference)
+{
+    const int width  = source_width * 2;
+    const int height = source_height * 2;
+
+    const source src;
+
+    std::vector<std::uint8_t> expected(width * height * 4);
+    std::vector<std::uint8_t> actual(width * height * 4);
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            reference(src, (x + 0.5) / 2.0 - 0.5, (y + 0.5) / 2.0 - 0.5, expected.data() + (y * width + x) * 4);
+        }
+    }
+
+    const auto area = cpu::resample(actual.data(),
+                                    width,
+                                    height,
+                                    src.pixels.data(),
+                                    source_width,
+                                    source_height,
+                                    core::image_transform(),
+                                    core::frame_geometry::get_default(),
+                                    1.0,
+                                    filter);
+
+    BOOST_CHECK_EQUAL(area.x, 0);
+    BOOST_CHECK_EQUAL(area.y, 0);
+    BOOST_CHECK_EQUAL(area.width, width);
+    BOOST_CHECK_EQUAL(area.height, height);
+    BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(cpu_resample)
+
+BOOST_AUTO_TEST_CASE(bilinear_matches_scalar) { check_upscale(cpu::resample_filter::bilinear, reference_bilinear); }
+
+BOOST_AUTO_TEST_CASE(bicubic_matches_scalar) { check_upscale(cpu::resample_filter::bicubic, reference_bicubic); }
+
+BOOST_AUTO_TEST_CASE(whole_pixel_translation_copies)
+{
+    const source src;
+
+    core::image_transform transform;
+    transform.fill_translation = {8.0 / source_width, 4.0 / source_height};
+
+    std::vector<std::uint8_t> expected(src.pixels.size(), 7);
+    for (int y = 4; y < source_height; ++y) {
+        const auto row = src.pixels.begin() + (y - 4) * source_width * 4;
+        std::copy(row, row + (source_width - 8) * 4, expected.begin() + (y * source_width + 8) * 4);
+    }
+
+    std::vector<std::uint8_t> actual(src.pixels.size(), 7);
+
+    const auto area = cpu::resample(actual.data(),
+                                    source_width,
+                                    source_height,
+                                    src.pixels.data(),
+                                    source_width,
+                                    source_height,
+                                    transform,
+                                    core::frame_geometry::get_default(),
+                                    1.0);
+
+    BOOST_CHECK_EQUAL(area.x, 8);
+    BOOST_CHECK_EQUAL(area.y, 4);
+    BOOST_CHECK_EQUAL(area.width, source_width - 8);
+    BOOST_CHECK_EQUAL(area.height, source_height - 4);
+    BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(off_screen_draws_nothing)
+{
+    const source src;
+
+    core::image_transform transform;
+    transform.fill_translation = {2.0, 0.0};
+
+    std::vector<std::uint8_t> dest(src.pixels.size(), 7);
+
+    const auto area = cpu::resample(dest.data(),
+                                    source_width,
+                                    source_height,
+                                    src.pixels.data(),
+                                    source_width,
+                                    source_height,
+                                    transform,
+                                    core::frame_geometry::get_default(),
+                                    1.0);
+
+    BOOST_CHECK(area.empty());
+    BOOST_CHECK(std::all_of(dest.begin(), dest.end(), [](std::uint8_t value) { return value == 7; }));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
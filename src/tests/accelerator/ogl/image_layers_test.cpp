@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <accelerator/ogl/image/image_layers.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <vector>
+
+using namespace caspar;
+using namespace caspar::accelerator::ogl;
+
+namespace {
+
+core::const_frame make_frame(core::pixel_format format)
+{
+    std::vector<array<const std::uint8_t>> image_data;
+    image_data.emplace_back(array<const std::uint8_t>(std::vector<std::uint8_t>(16 * 9 * 4)));
+
+    core::pixel_format_desc desc(format);
+    desc.planes.push_back(core::pixel_format_desc::plane(16, 9, 4));
+
+    return core::const_frame(std::move(image_data), array<const std::int32_t>{}, desc);
+}
+
+item make_item(core::pixel_format format = core::pixel_format::bgra)
+{
+    item result;
+    result.frame    = make_frame(format);
+    result.pix_desc = result.frame.pixel_format_desc();
+    return result;
+}
+
+layer make_layer(int items, core::blend_mode blend_mode = core::blend_mode::normal)
+{
+    layer result(blend_mode);
+    for (auto n = 0; n < items; ++n) {
+        result.items.push_back(make_item());
+    }
+    return result;
+}
+
+std::vector<bool> flags(std::vector<int> values) { return std::vector<bool>(values.begin(), values.end()); }
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(image_layers)
+
+BOOST_AUTO_TEST_CASE(unchanged_layers_are_static)
+{
+    std::vector<layer> previous{make_layer(1), make_layer(2), make_layer(1), make_layer(1)};
+
+    auto layers              = previous;
+    layers[2].items[0].frame = make_frame(core::pixel_format::bgra);
+    layers.push_back(make_layer(1));
+
+    BOOST_CHECK(static_layers(layers, previous) == flags({1, 1, 0, 1, 0}));
+    BOOST_CHECK(static_layers(layers, {}) == flags({0, 0, 0, 0, 0}));
+}
+
+BOOST_AUTO_TEST_CASE(changed_transforms_are_not_static)
+{
+    std::vector<layer> previous{make_layer(1), make_layer(1)};
+
+    auto layers                          = previous;
+    layers[1].items[0].transform.opacity = 0.5;
+    layers[0].sublayers.push_back(make_layer(1));
+
+    BOOST_CHECK(static_layers(layers, previous) == flags({0, 0}));
+}
+
+BOOST_AUTO_TEST_CASE(keys_and_blend_modes_are_not_static)
+{
+    std::vector<layer> previous{make_layer(1), make_layer(1), make_layer(1), make_layer(1, core::blend_mode::screen)};
+    previous[1].items[0].transform.is_key = true;
+    previous[0].sublayers.push_back(make_layer(1, core::blend_mode::multiply));
+
+    // The key and the layer it masks are drawn every time, as are layers with a blend mode anywhere in them.
+    BOOST_CHECK(static_layers(previous, previous) == flags({0, 0, 0, 0}));
+    BOOST_CHECK(!is_cacheable(previous[0]));
+    BOOST_CHECK(!is_cacheable(previous[1]));
+    BOOST_CHECK(is_cacheable(previous[2]));
+}
+
+BOOST_AUTO_TEST_CASE(runs_of_static_layers_are_cached)
+{
+    std::vector<layer> layers{make_layer(1), make_layer(1), make_layer(3), make_layer(1), make_layer(0), make_layer(2)};
+
+    const auto runs = layer_runs(layers, flags({1, 1, 0, 1, 1, 1}));
+
+    BOOST_REQUIRE_EQUAL(runs.size(), 3U);
+    BOOST_CHECK(runs[0].begin == 0 && runs[0].end == 2 && runs[0].cached);
+    BOOST_CHECK(runs[1].begin == 2 && runs[1].end == 3 && !runs[1].cached);
+    BOOST_CHECK(runs[2].begin == 3 && runs[2].end == 6 && runs[2].cached);
+}
+
+BOOST_AUTO_TEST_CASE(single_items_are_drawn_directly)
+{
+    // A static run needs two items to be worth a texture, sublayers count too.
+    std::vector<layer> layers{make_layer(1), make_layer(0), make_layer(1), make_layer(0), make_layer(0)};
+    layers[3].sublayers.push_back(make_layer(1));
+    layers[4].sublayers.push_back(make_layer(1));
+
+    const auto runs = layer_runs(layers, flags({1, 1, 0, 1, 1}));
+
+    BOOST_REQUIRE_EQUAL(runs.size(), 4U);
+    for (std::size_t n = 0; n < 3; ++n) {
+        BOOST_CHECK(runs[n].begin == n && runs[n].end == n + 1 && !runs[n].cached);
+    }
+    BOOST_CHECK(runs[3].begin == 3 && runs[3].end == 5 && runs[3].cached);
+    BOOST_CHECK_EQUAL(count_items(layers[3]), 1);
+}
+
+BOOST_AUTO_TEST_CASE(opaque_full_screen_items_cover_the_screen)
+{
+    BOOST_CHECK(covers_screen(make_item(core::pixel_format::bgr)));
+    BOOST_CHECK(covers_screen(make_item(core::pixel_format::ycbcr)));
+    BOOST_CHECK(!covers_screen(make_item(core::pixel_format::bgra)));
+    BOOST_CHECK(!covers_screen(make_item(core::pixel_format::ycbcra)));
+
+    // Mirrored still fills the screen.
+    auto mirrored                          = make_item(core::pixel_format::bgr);
+    mirrored.transform.fill_scale[0]       = -1.0;
+    mirrored.transform.fill_translation[0] = 1.0;
+    BOOST_CHECK(covers_screen(mirrored));
+
+    auto faded              = make_item(core::pixel_format::bgr);
+    faded.transform.opacity = 0.99;
+    BOOST_CHECK(!covers_screen(faded));
+
+    auto scaled                    = make_item(core::pixel_format::bgr);
+    scaled.transform.fill_scale[1] = 0.5;
+    BOOST_CHECK(!covers_screen(scaled));
+
+    auto clipped                    = make_item(core::pixel_format::bgr);
+    clipped.transform.clip_scale[0] = 0.9;
+    BOOST_CHECK(!covers_screen(clipped));
+
+    auto cropped                 = make_item(core::pixel_format::bgr);
+    cropped.transform.crop.ul[0] = 0.1;
+    BOOST_CHECK(!covers_screen(cropped));
+
+    auto rotated            = make_item(core::pixel_format::bgr);
+    rotated.transform.angle = 0.1;
+    BOOST_CHECK(!covers_screen(rotated));
+
+    auto key             = make_item(core::pixel_format::bgr);
+    key.transform.is_key = true;
+    BOOST_CHECK(!covers_screen(key));
+}
+
+BOOST_AUTO_TEST_CASE(cull_drops_everything_below_a_cover)
+{
+    std::vector<layer> layers{make_layer(2), make_layer(1), make_layer(1), make_layer(1)};
+    layers[1].sublayers.push_back(make_layer(1));
+    layers[2].sublayers.push_back(make_layer(1));
+    layers[2].items.push_back(make_item(core::pixel_format::bgr));
+    layers[2].items.push_back(make_item());
+
+    const auto top = layers[3];
+
+    // Layers 0 and 1 with their sublayer, layer 2's sublayer and the item before its cover.
+    BOOST_CHECK_EQUAL(cull(layers), 6);
+    BOOST_REQUIRE_EQUAL(layers.size(), 2U);
+    BOOST_CHECK_EQUAL(layers[0].items.size(), 2U);
+    BOOST_CHECK(layers[0].sublayers.empty());
+    BOOST_CHECK(layers[0].items[0].pix_desc.format == core::pixel_format::bgr);
+    BOOST_CHECK(layers[1] == top);
+}
+
+BOOST_AUTO_TEST_CASE(cull_keeps_keyed_and_blended_layers)
+{
+    // A layer keyed by the one below is masked, it doesn't cover anything. The cover under the key still counts.
+    std::vector<layer> keyed{make_layer(1), make_layer(0), make_layer(1), make_layer(0)};
+    keyed[1].items.push_back(make_item(core::pixel_format::bgr));
+    keyed[2].items[0].transform.is_key = true;
+    keyed[3].items.push_back(make_item(core::pixel_format::bgr));
+
+    BOOST_CHECK_EQUAL(cull(keyed), 1);
+    BOOST_CHECK_EQUAL(keyed.size(), 3U);
+
+    // Items after a key in the same layer are masked by it.
+    std::vector<layer> masked{make_layer(1), make_layer(1)};
+    masked[1].items[0].transform.is_key = true;
+    masked[1].items.push_back(make_item(core::pixel_format::bgr));
+
+    BOOST_CHECK_EQUAL(cull(masked), 0);
+    BOOST_CHECK_EQUAL(masked.size(), 2U);
+
+    std::vector<layer> blended{make_layer(1), make_layer(0, core::blend_mode::multiply)};
+    blended[1].items.push_back(make_item(core::pixel_format::bgr));
+
+    BOOST_CHECK_EQUAL(cull(blended), 0);
+    BOOST_CHECK_EQUAL(blended.size(), 2U);
+}
+
+BOOST_AUTO_TEST_CASE(same_layers_in_the_same_format_are_the_same_image)
+{
+    const core::video_format_desc hd(L"1080i5000");
+    const core::video_format_desc sd(L"PAL");
+
+    std::vector<layer> previous{make_layer(1), make_layer(2)};
+
+    BOOST_CHECK(same_image(previous, hd, previous, hd));
+    BOOST_CHECK(same_image({}, hd, {}, hd));
+    BOOST_CHECK(!same_image(previous, sd, previous, hd));
+    BOOST_CHECK(!same_image({}, hd, previous, hd));
+
+    auto moved                        = previous;
+    moved[1].items[1].transform.angle = 0.1;
+    BOOST_CHECK(!same_image(moved, hd, previous, hd));
+
+    auto restarted              = previous;
+    restarted[0].items[0].frame = make_frame(core::pixel_format::bgra);
+    BOOST_CHECK(!same_image(restarted, hd, previous, hd));
+}
+
+BOOST_AUTO_TEST_CASE(changes_under_a_cover_keep_the_image)
+{
+    const core::video_format_desc hd(L"1080i5000");
+
+    std::vector<layer> previous{make_layer(1), make_layer(0)};
+    previous[1].items.push_back(make_item(core::pixel_format::bgr));
+
+    auto layers              = previous;
+    layers[0].items[0].frame = make_frame(core::pixel_format::bgra);
+    layers[0].items.push_back(make_item());
+
+    // The image mixer culls before it compares, so what happens under a full screen cover doesn't redraw.
+    cull(previous);
+    cull(layers);
+    BOOST_CHECK(same_image(layers, hd, previous, hd));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
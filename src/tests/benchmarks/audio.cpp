@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "benchmark.h"
+
+#include <common/diagnostics/graph.h>
+#include <common/memory.h>
+
+#include <core/frame/frame.h>
+#include <core/frame/frame_transform.h>
+#include <core/frame/pixel_format.h>
+#include <core/mixer/audio/audio_limiter.h>
+#include <core/mixer/audio/audio_mixer.h>
+#include <core/mixer/audio/audio_util.h>
+#include <core/video_format.h>
+
+#include <boost/format.hpp>
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace caspar { namespace benchmarks {
+
+namespace {
+
+core::const_frame audio_frame(int channels, int samples, int seed)
+{
+    std::vector<std::int32_t> audio(samples * channels);
+    for (std::size_t n = 0; n < audio.size(); ++n) {
+        audio[n] = static_cast<std::int32_t>((n * 2654435761u + seed) >> 4) - (1 << 27);
+    }
+
+    std::vector<array<const std::uint8_t>> image_data;
+    image_data.emplace_back(array<const std::uint8_t>{});
+
+    core::pixel_format_desc desc(core::pixel_format::bgra);
+    desc.planes.push_back(core::pixel_format_desc::plane(0, 0, 4));
+
+    return core::const_frame(std::move(image_data), array<const std::int32_t>(std::move(audio)), desc);
+}
+
+// One tick of a channel with a layer per frame. Volumes alternate so that every item ramps.
+void mix(core::audio_mixer&                    mixer,
+         const std::vector<core::const_frame>& frames,
+         const core::video_format_desc&        format_desc,
+         int                                   tick)
+{
+    for (std::size_t n = 0; n < frames.size(); ++n) {
+        core::frame_transform transform;
+        transform.audio_transform.volume = (tick + n) % 2 == 0 ? 0.5 : 0.8;
+
+        mixer.begin_layer(static_cast<int>(n));
+        mixer.push(transform);
+        mixer.visit(frames[n]);
+        mixer.pop();
+    }
+    mixer(format_desc, format_desc.audio_cadence.front(), true);
+}
+
+void audio_mixer(int channels, int items, bool limiter)
+{
+    auto format_desc           = core::video_format_desc(L"1080i5000");
+    format_desc.audio_channels = channels;
+
+    const auto samples = format_desc.audio_cadence.front();
+
+    std::vector<core::const_frame> frames;
+    for (int n = 0; n < items; ++n) {
+        frames.push_back(audio_frame(channels, samples, n));
+    }
+
+    core::audio_mixer mixer(spl::make_shared<diagnostics::graph>());
+    if (limiter) {
+        core::limiter_settings settings;
+        settings.enabled = true;
+        mixer.set_limiter(settings);
+    }
+
+    const auto name =
+        (boost::format("audio_mixer %d ch %d items%s") % channels % items % (limiter ? " limiter" : "")).str();
+
+    auto       tick     = 0;
+    const auto per_tick = measure(name, 0.0, [&] { mix(mixer, frames, format_desc, tick++); });
+
+    // How many such channels one core keeps up with in real time.
+    if (per_tick > 0.0) {
+        std::cout << boost::format("%-48s %10.1f channels per core") % "" % (1.0 / format_desc.fps / per_tick)
+                  << std::endl;
+    }
+}
+
+void limiter(int channels)
+{
+    const int samples = 1920;
+
+    std::vector<float> block(samples * channels);
+    for (std::size_t n = 0; n < block.size(); ++n) {
+        block[n] = static_cast<float>(n % 97) * 4.0e7f;
+    }
+    auto next = block;
+
+    core::limiter_settings settings;
+    settings.enabled = true;
+
+    core::audio_limiter limiter(channels, 48000, settings);
+    measure("audio_limiter " + std::to_string(channels) + " ch", 0.0, [&] {
+        auto samples = block;
+        limiter.process(samples.data(), samples.size(), next.data(), next.size());
+    });
+}
+
+void converters(int channels)
+{
+    const auto size = static_cast<std::size_t>(1920) * channels;
+
+    std::vector<std::int32_t> source(size);
+    for (std::size_t n = 0; n < size; ++n) {
+        source[n] = static_cast<std::int32_t>(n * 2654435761u);
+    }
+
+    std::vector<std::int16_t> s16(size);
+    std::vector<std::int8_t>  s24(size * 3);
+    std::vector<float>        f32(size);
+    core::tpdf_dither         dither;
+
+    const auto suffix = " " + std::to_string(channels) + " ch";
+
+    measure("audio_32_to_16" + suffix, 0.0, [&] { core::audio_32_to_16(source.data(), s16.data(), size); });
+    measure("audio_32_to_16 dither" + suffix, 0.0, [&] {
+        core::audio_32_to_16(source.data(), s16.data(), size, dither);
+    });
+    measure("audio_32_to_24" + suffix, 0.0, [&] { core::audio_32_to_24(source.data(), s24.data(), size); });
+    measure("audio_32_to_float" + suffix, 0.0, [&] { core::audio_32_to_float(source.data(), f32.data(), size); });
+}
+
+} // namespace
+
+void audio()
+{
+    for (auto channels : {2, 8, 16}) {
+        audio_mixer(channels, 50, false);
+    }
+    audio_mixer(16, 50, true);
+
+    // Audio-only channels, as many layers as a typical playout channel carries.
+    for (auto items : {1, 4, 8}) {
+        audio_mixer(8, items, false);
+    }
+
+    limiter(2);
+    limiter(8);
+
+    converters(2);
+    converters(16);
+}
+
+}} // namespace caspar::benchmarks
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "benchmark.h"
+
+#include <boost/format.hpp>
+
+#include <chrono>
+#include <iostream>
+
+namespace caspar { namespace benchmarks {
+
+namespace {
+
+std::string& filter()
+{
+    static std::string value;
+    return value;
+}
+
+} // namespace
+
+void set_filter(const std::string& value) { filter() = value; }
+
+double measure(const std::string& name, double pixels, const std::function<void()>& func)
+{
+    if (name.find(filter()) == std::string::npos) {
+        return 0.0;
+    }
+
+    typedef std::chrono::steady_clock clock;
+
+    // Warm up caches and pools.
+    func();
+
+    const auto start   = clock::now();
+    auto       calls   = 0;
+    auto       elapsed = 0.0;
+    while (elapsed < 1.0) {
+        func();
+        ++calls;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    const auto per_call = elapsed / calls;
+    if (pixels > 0.0) {
+        std::cout << boost::format("%-48s %10.3f ms %10.1f MP/s") % name % (per_call * 1000.0) %
+                         (pixels / per_call / 1000000.0)
+                  << std::endl;
+    } else {
+        std::cout << boost::format("%-48s %10.3f ms %10.1f /s") % name % (per_call * 1000.0) % (1.0 / per_call)
+                  << std::endl;
+    }
+
+    return per_call;
+}
+
+}} // namespace caspar::benchmarks
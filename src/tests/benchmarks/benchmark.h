@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <functional>
+#include <string>
+
+namespace caspar { namespace benchmarks {
+
+// Only benchmarks whose name contains filter are run.
+void set_filter(const std::string& filter);
+
+// Calls func until at least a second has passed and prints the mean time per call and the rate in megapixels per
+// second, or calls per second when pixels is zero. Returns the mean time per call in seconds, or zero when skipped.
+double measure(const std::string& name, double pixels, const std::function<void()>& func);
+
+void audio();
+void cpu_kernels();
+void frame_conversion();
+void image_algorithms();
+
+}} // namespace caspar::benchmarks
@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "benchmark.h"
+
+#include <accelerator/cpu/image/blend.h>
+#include <accelerator/cpu/image/blend_kernel.h>
+#include <accelerator/cpu/image/chroma_key.h>
+#include <accelerator/cpu/image/color_correction.h>
+#include <accelerator/cpu/image/pixel_convert.h>
+#include <accelerator/cpu/image/resample.h>
+#include <accelerator/cpu/util/simd.h>
+
+#include <common/utf.h>
+
+#include <core/frame/frame_transform.h>
+#include <core/frame/geometry.h>
+#include <core/frame/pixel_format.h>
+#include <core/mixer/image/blend_modes.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace caspar { namespace benchmarks {
+
+namespace {
+
+using namespace accelerator;
+
+const int width  = 1920;
+const int height = 1080;
+const int pixels = width * height;
+
+std::vector<std::uint8_t> pattern(std::size_t size)
+{
+    std::vector<std::uint8_t> data(size);
+    for (std::size_t n = 0; n < size; ++n) {
+        data[n] = static_cast<std::uint8_t>(n * 7 + n / 4099);
+    }
+    return data;
+}
+
+// Half transparent BGRA so that every blend takes its full path.
+std::vector<std::uint8_t> bgra()
+{
+    auto data = pattern(pixels * 4);
+    for (std::size_t n = 0; n < data.size(); n += 4) {
+        data[n + 3] = 160;
+        for (int c = 0; c < 3; ++c) {
+            data[n + c] = static_cast<std::uint8_t>(data[n + c] * 160 / 255);
+        }
+    }
+    return data;
+}
+
+void pixel_convert(const std::string& name,
+                   core::pixel_format format,
+                   int                chroma_width,
+                   int                chroma_height,
+                   core::color_depth  depth)
+{
+    const auto bytes = core::bytes_per_sample(depth);
+
+    core::pixel_format_desc desc(format, depth);
+    desc.planes.push_back(core::pixel_format_desc::plane(width, height, bytes));
+    desc.planes.push_back(core::pixel_format_desc::plane(chroma_width, chroma_height, bytes));
+    desc.planes.push_back(core::pixel_format_desc::plane(chroma_width, chroma_height, bytes));
+    if (format == core::pixel_format::ycbcra) {
+        desc.planes.push_back(core::pixel_format_desc::plane(width, height, bytes));
+    }
+
+    std::vector<std::vector<std::uint8_t>> data;
+    std::vector<const std::uint8_t*>       planes;
+    for (const auto& plane : desc.planes) {
+        data.push_back(pattern(plane.size));
+        planes.push_back(data.back().data());
+    }
+
+    std::vector<std::uint8_t> dest(pixels * 4);
+    measure("pixel_convert " + name, pixels, [&] {
+        cpu::to_bgra(dest.data(), desc, planes, cpu::color_space::bt709);
+    });
+}
+
+void blend()
+{
+    const auto source = bgra();
+    auto       dest   = bgra();
+    const auto key    = pattern(pixels);
+
+    const auto avx2 = cpu::detail::has_avx2();
+
+    for (auto mode : {core::blend_mode::normal, core::blend_mode::screen, core::blend_mode::luminosity}) {
+        const auto name = "blend " + u8(core::get_blend_mode(mode));
+
+        measure(name + " sse", pixels, [&] {
+            cpu::detail::blend_span<cpu::vec_sse>(
+                dest.data(), source.data(), nullptr, nullptr, pixels, mode, false, 1.0f);
+        });
+        if (avx2) {
+            measure(name + " avx2", pixels, [&] {
+                cpu::detail::blend_avx2(dest.data(), source.data(), nullptr, nullptr, pixels, mode, false, 1.0f);
+            });
+        }
+        measure(name + " parallel", pixels, [&] {
+            cpu::blend(dest.data(), source.data(), nullptr, nullptr, width, height, mode, cpu::keyer::linear, 1.0f);
+        });
+    }
+
+    measure("blend normal keyed opacity", pixels, [&] {
+        cpu::blend(dest.data(),
+                   source.data(),
+                   key.data(),
+                   nullptr,
+                   pixels,
+                   core::blend_mode::normal,
+                   cpu::keyer::linear,
+                   0.5f);
+    });
+
+    auto target = pattern(pixels);
+    measure("blend_key", pixels, [&] { cpu::blend_key(target.data(), source.data(), pixels); });
+}
+
+void chroma_key()
+{
+    core::chroma chroma;
+    chroma.enable         = true;
+    chroma.target_hue     = 120.0;
+    chroma.hue_width      = 0.1;
+    chroma.min_saturation = 0.2;
+    chroma.min_brightness = 0.1;
+    chroma.softness       = 0.25;
+    chroma.spill_suppress = 20.0;
+
+    const auto source = bgra();
+    auto       image  = source;
+
+    measure("chroma_key", pixels, [&] {
+        image = source;
+        cpu::chroma_key(image.data(), pixels, chroma);
+    });
+    measure("chroma_key parallel", pixels, [&] {
+        image = source;
+        cpu::chroma_key(image.data(), width, height, chroma);
+    });
+}
+
+void color_correction()
+{
+    const auto source = bgra();
+    auto       image  = source;
+
+    core::image_transform levels;
+    levels.levels.gamma = 1.4;
+    levels.brightness   = 1.1;
+
+    core::image_transform saturation;
+    saturation.saturation = 1.5;
+
+    for (const auto& transform : {levels, saturation}) {
+        cpu::color_correction correction;
+        correction.update(transform, true);
+
+        measure(transform.saturation != 1.0 ? "color_correction saturation" : "color_correction levels",
+                pixels,
+                [&] {
+                    image = source;
+                    correction.apply(image.data(), pixels);
+                });
+    }
+}
+
+void resample()
+{
+    const auto source = bgra();
+
+    std::vector<std::uint8_t> dest(pixels * 4);
+
+    core::image_transform scale;
+    scale.fill_scale = {0.75, 0.75};
+
+    core::image_transform rotate = scale;
+    rotate.angle                 = 0.3;
+
+    core::image_transform perspective;
+    perspective.perspective.ur = {0.9, 0.1};
+    perspective.perspective.lr = {0.9, 0.9};
+
+    for (auto filter : {cpu::resample_filter::bilinear, cpu::resample_filter::bicubic}) {
+        const std::string suffix = filter == cpu::resample_filter::bicubic ? " bicubic" : " bilinear";
+
+        auto draw = [&](const core::image_transform& transform) {
+            cpu::resample(dest.data(),
+                          width,
+                          height,
+                          source.data(),
+                          width,
+                          height,
+                          transform,
+                          core::frame_geometry::get_default(),
+                          1.0,
+                          filter);
+        };
+
+        measure("resample scale" + suffix, pixels * 0.75 * 0.75, [&] { draw(scale); });
+        measure("resample rotate" + suffix, pixels * 0.75 * 0.75, [&] { draw(rotate); });
+        measure("resample perspective" + suffix, pixels * 0.8, [&] { draw(perspective); });
+    }
+}
+
+} // namespace
+
+void cpu_kernels()
+{
+    pixel_convert("4:2:2", core::pixel_format::ycbcr, width / 2, height, core::color_depth::eight);
+    pixel_convert("4:2:0", core::pixel_format::ycbcr, width / 2, height / 2, core::color_depth::eight);
+    pixel_convert("4:1:1", core::pixel_format::ycbcr, width / 4, height, core::color_depth::eight);
+    pixel_convert("4:1:0", core::pixel_format::ycbcr, width / 4, height / 4, core::color_depth::eight);
+    pixel_convert("4:2:2:4", core::pixel_format::ycbcra, width / 2, height, core::color_depth::eight);
+    pixel_convert("4:2:2 16 bit", core::pixel_format::ycbcr, width / 2, height, core::color_depth::sixteen);
+
+    blend();
+    chroma_key();
+    color_correction();
+    resample();
+}
+
+}} // namespace caspar::benchmarks
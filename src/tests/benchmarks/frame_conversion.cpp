@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "benchmark.h"
+
+#include <core/frame/frame.h>
+#include <core/frame/frame_conversion.h>
+#include <core/frame/pixel_format.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace caspar { namespace benchmarks {
+
+namespace {
+
+const int width  = 1920;
+const int height = 1080;
+const int pixels = width * height;
+
+// A mixer output frame of the given depth, with a fresh cache so that every call converts.
+core::const_frame mixer_frame(core::color_depth depth, const std::shared_ptr<std::vector<std::uint8_t>>& data)
+{
+    core::pixel_format_desc desc(core::pixel_format::bgra, depth);
+    desc.planes.push_back(core::pixel_format_desc::plane(width, height, 4 * core::bytes_per_sample(depth)));
+
+    std::vector<array<const std::uint8_t>> image_data;
+    image_data.emplace_back(data->data(), desc.planes[0].size, data);
+
+    return core::const_frame(std::move(image_data), array<const std::int32_t>{}, desc);
+}
+
+void conversions(core::color_depth depth)
+{
+    const auto bytes = core::bytes_per_sample(depth);
+    const auto data  = std::make_shared<std::vector<std::uint8_t>>(pixels * 4 * bytes);
+    for (std::size_t n = 0; n < data->size(); ++n) {
+        (*data)[n] = static_cast<std::uint8_t>(n * 7 + n / 4099);
+    }
+
+    const auto suffix = depth == core::color_depth::sixteen ? " 16 bit" : " 8 bit";
+
+    // Memory traffic of the frame alone, what readback and every consumer copy pay per pixel.
+    std::vector<std::uint8_t> copy(data->size());
+    measure(std::string("frame copy") + suffix, pixels, [&] { std::copy(data->begin(), data->end(), copy.begin()); });
+
+    if (depth == core::color_depth::sixteen) {
+        // 8 bit frames are passed through.
+        measure(std::string("bgra8") + suffix, pixels, [&] { core::bgra8(mixer_frame(depth, data)); });
+    }
+    measure(std::string("uyvy") + suffix, pixels, [&] { core::uyvy(mixer_frame(depth, data)); });
+    measure(std::string("yuv422p10") + suffix, pixels, [&] { core::yuv422p10(mixer_frame(depth, data)); });
+    measure(std::string("v210") + suffix, pixels, [&] { core::v210(mixer_frame(depth, data)); });
+}
+
+} // namespace
+
+void frame_conversion()
+{
+    conversions(core::color_depth::eight);
+    conversions(core::color_depth::sixteen);
+}
+
+}} // namespace caspar::benchmarks
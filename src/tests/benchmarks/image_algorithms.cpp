@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "benchmark.h"
+
+#include <modules/image/util/image_algorithms.h>
+#include <modules/image/util/image_view.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace caspar { namespace benchmarks {
+
+void image_algorithms()
+{
+    const int width  = 1920;
+    const int height = 1080;
+
+    // Mostly partly transparent, as a title graphic over the whole frame.
+    std::vector<std::uint8_t> source(width * height * 4);
+    for (std::size_t n = 0; n < source.size(); ++n) {
+        source[n] = static_cast<std::uint8_t>(n % 4 == 3 ? (n / 4) % 7 * 40 : n * 7);
+    }
+    auto image = source;
+
+    measure("image premultiply", width * height, [&] {
+        image = source;
+        image::image_view<image::bgra_pixel> view(image.data(), width, height);
+        image::premultiply(view);
+    });
+    measure("image unmultiply", width * height, [&] {
+        image = source;
+        image::image_view<image::bgra_pixel> view(image.data(), width, height);
+        image::unmultiply(view);
+    });
+    measure("image copy only", width * height, [&] { image = source; });
+}
+
+}} // namespace caspar::benchmarks
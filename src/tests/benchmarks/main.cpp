@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "benchmark.h"
+
+#include "../test_env.h"
+
+#include <string>
+
+int main(int argc, char** argv)
+{
+    using namespace caspar;
+
+    // The audio mixer reads its settings from env.
+    tests::configure_env();
+
+    benchmarks::set_filter(argc > 1 ? argv[1] : "");
+    benchmarks::audio();
+    benchmarks::cpu_kernels();
+    benchmarks::frame_conversion();
+    benchmarks::image_algorithms();
+
+    return 0;
+}
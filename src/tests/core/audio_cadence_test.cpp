@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <core/video_format.h>
+
+#include <boost/rational.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using namespace caspar;
+
+namespace {
+
+struct day
+{
+    std::int64_t ticks;
+    std::int64_t samples;
+    int          min_samples;
+    int          max_samples;
+};
+
+// Runs the scheduler for every whole tick of 24 hours.
+day simulate_day(int sample_rate, const boost::rational<int>& rate)
+{
+    core::audio_cadence_scheduler scheduler(sample_rate, rate);
+
+    day result         = {};
+    result.ticks       = std::int64_t(86400) * rate.numerator() / rate.denominator();
+    result.min_samples = sample_rate;
+
+    for (std::int64_t n = 0; n < result.ticks; ++n) {
+        const auto samples = scheduler.next();
+        result.samples += samples;
+        result.min_samples = std::min(result.min_samples, samples);
+        result.max_samples = std::max(result.max_samples, samples);
+    }
+
+    BOOST_CHECK_EQUAL(scheduler.ticks(), result.ticks);
+    BOOST_CHECK_EQUAL(scheduler.position(), result.samples);
+    return result;
+}
+
+void check_day(int sample_rate, const boost::rational<int>& rate, std::int64_t ticks, std::int64_t samples)
+{
+    const auto result = simulate_day(sample_rate, rate);
+
+    BOOST_CHECK_EQUAL(result.ticks, ticks);
+    BOOST_CHECK_EQUAL(result.samples, samples);
+
+    // floor(ticks * sample_rate / rate), so the audio never runs ahead of or behind the video by a sample.
+    BOOST_CHECK_EQUAL(result.samples, ticks * sample_rate * rate.denominator() / rate.numerator());
+
+    // Ticks only ever differ by one sample.
+    BOOST_CHECK_LE(result.max_samples - result.min_samples, 1);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(audio_cadence)
+
+BOOST_AUTO_TEST_CASE(day_at_2997_has_no_drift)
+{
+    check_day(48000, boost::rational<int>(30000, 1001), 2589410, 4147199056);
+    check_day(44100, boost::rational<int>(30000, 1001), 2589410, 3810239132);
+}
+
+BOOST_AUTO_TEST_CASE(day_at_5994_has_no_drift)
+{
+    check_day(48000, boost::rational<int>(60000, 1001), 5178821, 4147199856);
+    check_day(44100, boost::rational<int>(60000, 1001), 5178821, 3810239868);
+}
+
+BOOST_AUTO_TEST_CASE(day_at_23976_has_no_drift)
+{
+    check_day(48000, boost::rational<int>(24000, 1001), 2071528, 4147199056);
+    check_day(44100, boost::rational<int>(24000, 1001), 2071528, 3810239132);
+}
+
+BOOST_AUTO_TEST_CASE(integer_rates_are_exact)
+{
+    check_day(48000, boost::rational<int>(50), 4320000, 4147200000);
+    check_day(44100, boost::rational<int>(25), 2160000, 3810240000);
+}
+
+BOOST_AUTO_TEST_CASE(scheduler_matches_rotating_producers)
+{
+    // Producers rotate the cadence right before every frame, the channel has to ask for the same samples each tick.
+    auto check = [](int sample_rate, const boost::rational<int>& rate, std::vector<int> cadence) {
+        core::audio_cadence_scheduler scheduler(sample_rate, rate, cadence);
+        for (std::size_t n = 0; n < cadence.size() * 3; ++n) {
+            std::rotate(cadence.begin(), cadence.end() - 1, cadence.end());
+            const auto expected = cadence.front();
+            const auto samples  = scheduler.next();
+            BOOST_REQUIRE_EQUAL(samples, expected);
+        }
+    };
+
+    for (auto format : {L"NTSC", L"720p2997", L"720p5994", L"1080i5994", L"1080p2398", L"1080p5994", L"2160p2997"}) {
+        const auto format_desc = core::video_format_desc(format);
+        BOOST_TEST_CONTEXT("format " << static_cast<int>(format_desc.format))
+        {
+            check(format_desc.audio_sample_rate, format_desc.framerate, format_desc.audio_cadence);
+        }
+    }
+
+    // Cadences found for other rates are in scheduler order.
+    check(48000, boost::rational<int>(15000, 1001), core::find_audio_cadence(boost::rational<int>(15000, 1001)));
+    check(48000, boost::rational<int>(12), core::find_audio_cadence(boost::rational<int>(12)));
+}
+
+BOOST_AUTO_TEST_CASE(cadence_cycles_have_no_drift)
+{
+    // Every cycle of a cadence holds exactly its share of samples, interlaced formats included.
+    for (auto format : {L"NTSC", L"1080i5994", L"720p2997", L"1080p5994"}) {
+        const auto format_desc = core::video_format_desc(format);
+
+        std::int64_t samples = 0;
+        for (auto n : format_desc.audio_cadence) {
+            samples += n;
+        }
+        BOOST_CHECK_EQUAL(samples * format_desc.framerate.numerator(),
+                          static_cast<std::int64_t>(format_desc.audio_sample_rate) * format_desc.audio_cadence.size() *
+                              format_desc.framerate.denominator());
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <core/frame/audio_delay.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+using namespace caspar;
+
+BOOST_AUTO_TEST_SUITE(audio_delay)
+
+BOOST_AUTO_TEST_CASE(parses_ms_and_samples)
+{
+    BOOST_CHECK_EQUAL(core::parse_audio_delay(L"40", 48000), 1920);
+    BOOST_CHECK_EQUAL(core::parse_audio_delay(L" -20ms ", 48000), -960);
+    BOOST_CHECK_EQUAL(core::parse_audio_delay(L"100 SAMPLES", 48000), 100);
+    BOOST_CHECK_EQUAL(core::parse_audio_delay(L"10000", 44100), 441000);
+    BOOST_CHECK_EQUAL(core::parse_audio_delay(L"-480000samples", 48000), -480000);
+}
+
+BOOST_AUTO_TEST_CASE(rejects_delays_out_of_range)
+{
+    BOOST_CHECK_THROW(core::parse_audio_delay(L"10001", 48000), std::exception);
+    BOOST_CHECK_THROW(core::parse_audio_delay(L"-10001ms", 48000), std::exception);
+    BOOST_CHECK_THROW(core::parse_audio_delay(L"480001 samples", 48000), std::exception);
+    BOOST_CHECK_THROW(core::parse_audio_delay(L"100000000", 48000), std::exception);
+    BOOST_CHECK_THROW(core::parse_audio_delay(L"1e300", 48000), std::exception);
+    BOOST_CHECK_THROW(core::parse_audio_delay(L"nan", 48000), std::exception);
+    BOOST_CHECK_THROW(core::parse_audio_delay(L"soon", 48000), std::exception);
+}
+
+BOOST_AUTO_TEST_CASE(delays_by_whole_sample_frames)
+{
+    core::audio_delay<int> delay(2, 3);
+
+    std::vector<int> samples{1, 2, 3, 4, 5, 6, 7, 8};
+    delay.process(samples.data(), samples.size());
+
+    BOOST_CHECK((samples == std::vector<int>{0, 0, 0, 0, 0, 0, 1, 2}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
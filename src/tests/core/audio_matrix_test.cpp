@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <core/frame/audio_matrix.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace caspar;
+
+BOOST_AUTO_TEST_SUITE(audio_matrix)
+
+BOOST_AUTO_TEST_CASE(presets_ignore_case)
+{
+    for (auto name : {L"mono", L"MONO", L"Mono"}) {
+        const auto matrix = core::create_audio_matrix({name}, 2);
+
+        BOOST_CHECK_EQUAL(matrix.gain(0, 0), 0.5f);
+        BOOST_CHECK_EQUAL(matrix.gain(0, 1), 0.5f);
+    }
+
+    BOOST_CHECK(core::create_audio_matrix({L"SWAP"}, 2) == core::create_audio_matrix({L"swap"}, 2));
+    BOOST_CHECK(core::create_audio_matrix({L"Stereo-To-5.1"}, 8) == core::create_audio_matrix({L"stereo-to-5.1"}, 8));
+    BOOST_CHECK(core::create_audio_matrix({L"IDENTITY"}, 2).empty());
+}
+
+BOOST_AUTO_TEST_CASE(cells_route_channels)
+{
+    const auto matrix = core::create_audio_matrix({L"1:2", L"2:1:0.5"}, 2);
+
+    BOOST_CHECK_EQUAL(matrix.gain(0, 0), 0.0f);
+    BOOST_CHECK_EQUAL(matrix.gain(0, 1), 1.0f);
+    BOOST_CHECK_EQUAL(matrix.gain(1, 0), 0.5f);
+}
+
+BOOST_AUTO_TEST_CASE(invalid_routing_throws)
+{
+    BOOST_CHECK_THROW(core::create_audio_matrix({L"3:1"}, 2), std::exception);
+    BOOST_CHECK_THROW(core::create_audio_matrix({L"stereo"}, 2), std::exception);
+    BOOST_CHECK_THROW(core::create_audio_matrix({L"5.1-to-stereo"}, 2), std::exception);
+}
+
+BOOST_AUTO_TEST_CASE(apply_follows_changed_gains)
+{
+    // Six channels end in a partial vector, channel 4 reaches no output until it is routed.
+    auto matrix = core::audio_matrix::identity(6);
+    matrix.set_gain(3, 3, 0.0f);
+    matrix.set_gain(0, 1, 0.5f);
+
+    std::vector<std::int32_t> src{1000, 2000, 3000, 4000, 5000, 6000, -1000, -2000, -3000, -4000, -5000, -6000};
+    std::vector<std::int32_t> dest(src.size() + 1, 7);
+
+    matrix.apply(src.data(), dest.data(), 2);
+    BOOST_CHECK(dest == (std::vector<std::int32_t>{
+                            2000, 2000, 3000, 0, 5000, 6000, -2000, -2000, -3000, 0, -5000, -6000, 7}));
+
+    auto louder = core::audio_matrix::identity(6);
+    louder.set_gain(0, 0, 2.0f);
+
+    matrix.set_gain(3, 4, 1.0f);
+    matrix *= louder;
+    matrix.apply(src.data(), dest.data(), 2);
+    BOOST_CHECK(dest == (std::vector<std::int32_t>{
+                            3000, 2000, 3000, 5000, 5000, 6000, -3000, -2000, -3000, -5000, -5000, -6000, 7}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <core/mixer/audio/audio_meter.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+using namespace caspar;
+
+namespace {
+
+const float full_scale = 2147483648.0f;
+
+core::meter_ballistics true_peak_ballistics()
+{
+    core::meter_ballistics result;
+    result.true_peak = true;
+    return result;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(audio_meter)
+
+BOOST_AUTO_TEST_CASE(interleaved_blocks_match_mono_meters)
+{
+    std::mt19937                          rng(42);
+    std::uniform_real_distribution<float> dist(-0.9f, 0.9f);
+
+    for (auto channels : {1, 2, 3, 6, 8, 16}) {
+        const auto frames = 1000;
+
+        std::vector<float> samples(frames * channels);
+        for (auto& s : samples) {
+            s = dist(rng) * full_scale;
+        }
+
+        // Irregular blocks, some shorter than the interpolation history.
+        core::audio_meter meter(channels, 48000, true_peak_ballistics());
+        auto              offset = 0;
+        for (auto block : {7, 1, 300, 3, 5, 500, 184}) {
+            meter.process(samples.data() + offset * channels, block * channels);
+            offset += block;
+        }
+        BOOST_REQUIRE_EQUAL(offset, frames);
+        meter.update(frames);
+
+        for (auto ch = 0; ch < channels; ++ch) {
+            std::vector<float> mono(frames);
+            for (auto n = 0; n < frames; ++n) {
+                mono[n] = samples[n * channels + ch];
+            }
+
+            core::audio_meter reference(1, 48000, true_peak_ballistics());
+            reference.process(mono.data(), mono.size());
+            reference.update(frames);
+
+            BOOST_CHECK_CLOSE(meter.peak()[ch], reference.peak()[0], 0.001);
+            BOOST_CHECK_CLOSE(meter.rms()[ch], reference.rms()[0], 0.01);
+            BOOST_CHECK_CLOSE(meter.true_peak()[ch], reference.true_peak()[0], 0.001);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(true_peak_finds_peaks_between_samples)
+{
+    // A sine at a quarter of the sample rate sampled 45 degrees off its peaks is 3 dB under its true peak.
+    const auto         channels = 2;
+    const auto         frames   = 4800;
+    std::vector<float> samples(frames * channels);
+    for (auto n = 0; n < frames; ++n) {
+        const auto value = static_cast<float>(0.5 * std::sin(3.14159265358979323846 * (n / 2.0 + 0.25)));
+        samples[n * channels + 0] = value * full_scale;
+        samples[n * channels + 1] = value * full_scale;
+    }
+
+    core::audio_meter meter(channels, 48000, true_peak_ballistics());
+    meter.process(samples.data(), samples.size());
+    meter.update(frames);
+
+    core::audio_meter sample_peak(channels, 48000, core::meter_ballistics());
+    sample_peak.process(samples.data(), samples.size());
+    sample_peak.update(frames);
+
+    for (auto ch = 0; ch < channels; ++ch) {
+        BOOST_CHECK_CLOSE(meter.peak()[ch], -9.03f, 0.5);
+        BOOST_CHECK_CLOSE(meter.true_peak()[ch], -6.02f, 2.0);
+    }
+    BOOST_CHECK(sample_peak.true_peak().empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
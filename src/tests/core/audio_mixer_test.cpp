@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <common/diagnostics/graph.h>
+#include <common/memory.h>
+
+#include <core/frame/frame.h>
+#include <core/frame/pixel_format.h>
+#include <core/mixer/audio/audio_limiter.h>
+#include <core/mixer/audio/audio_mixer.h>
+#include <core/video_format.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <vector>
+
+using namespace caspar;
+
+namespace {
+
+core::const_frame audio_frame(int channels, int samples, std::int32_t value)
+{
+    std::vector<array<const std::uint8_t>> image_data;
+    image_data.emplace_back(array<const std::uint8_t>{});
+
+    core::pixel_format_desc desc(core::pixel_format::bgra);
+    desc.planes.push_back(core::pixel_format_desc::plane(0, 0, 4));
+
+    return core::const_frame(std::move(image_data),
+                             array<const std::int32_t>(std::vector<std::int32_t>(samples * channels, value)),
+                             desc);
+}
+
+// Mixes one frame of a constant value and returns the last sample, which is past any de-click fade.
+struct tick_result
+{
+    std::size_t  size;
+    std::int32_t last;
+    bool         holding;
+};
+
+tick_result tick(core::audio_mixer& mixer, const core::video_format_desc& format_desc, std::int32_t value, bool ahead)
+{
+    const auto samples = format_desc.audio_cadence.front();
+    const auto frame   = audio_frame(format_desc.audio_channels, samples, value);
+
+    mixer.begin_layer(0);
+    mixer.visit(frame);
+    const auto audio = mixer(format_desc, samples, ahead);
+
+    return {audio.size(), audio.size() > 0 ? audio.data()[audio.size() - 1] : 0, mixer.holding()};
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(audio_mixer)
+
+BOOST_AUTO_TEST_CASE(mix_is_returned_in_its_tick_without_limiter)
+{
+    const auto format_desc = core::video_format_desc(L"1080i5000");
+
+    core::audio_mixer mixer(spl::make_shared<diagnostics::graph>());
+
+    for (auto value : {1 << 20, 1 << 21, 1 << 22}) {
+        const auto result = tick(mixer, format_desc, value, true);
+
+        BOOST_CHECK(!result.holding);
+        BOOST_CHECK_EQUAL(result.size, format_desc.audio_cadence.front() * format_desc.audio_channels);
+        BOOST_CHECK_EQUAL(result.last, value);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(limiter_holds_mix_for_a_tick_when_looking_ahead)
+{
+    const auto format_desc = core::video_format_desc(L"1080i5000");
+
+    core::audio_mixer      mixer(spl::make_shared<diagnostics::graph>());
+    core::limiter_settings settings;
+    settings.enabled = true;
+    mixer.set_limiter(settings);
+
+    const auto first = tick(mixer, format_desc, 1 << 20, true);
+    BOOST_CHECK(first.holding);
+    BOOST_CHECK_EQUAL(first.size, 0u);
+
+    const auto second = tick(mixer, format_desc, 1 << 21, true);
+    BOOST_CHECK(second.holding);
+    BOOST_CHECK_EQUAL(second.last, 1 << 20);
+
+    // Ending the hold releases the held mix for the previous tick, this tick's mix goes out in its tick.
+    const auto third = tick(mixer, format_desc, 1 << 22, false);
+    BOOST_CHECK(!third.holding);
+    BOOST_CHECK_EQUAL(third.last, 1 << 22);
+
+    const auto released = mixer.released();
+    BOOST_REQUIRE_EQUAL(released.size(), format_desc.audio_cadence.front() * format_desc.audio_channels);
+    BOOST_CHECK_EQUAL(released.data()[released.size() - 1], 1 << 21);
+
+    tick(mixer, format_desc, 1 << 22, false);
+    BOOST_CHECK_EQUAL(mixer.released().size(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <core/mixer/audio/audio_util.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace caspar;
+
+namespace {
+
+const std::size_t guard = 32;
+
+// Random samples with the extremes at the start and end, where the vector loops and the tails meet.
+std::vector<std::int32_t> samples(std::size_t size)
+{
+    std::mt19937                                rng(static_cast<std::uint32_t>(size));
+    std::uniform_int_distribution<std::int32_t> dist(std::numeric_limits<std::int32_t>::min(),
+                                                     std::numeric_limits<std::int32_t>::max());
+
+    std::vector<std::int32_t> result(size);
+    for (auto& s : result) {
+        s = dist(rng);
+    }
+    const std::int32_t extremes[] = {std::numeric_limits<std::int32_t>::min(),
+                                     std::numeric_limits<std::int32_t>::max(),
+                                     0,
+                                     -1,
+                                     0x7FFF8000};
+    for (std::size_t n = 0; n < size && n < 5; ++n) {
+        result[n]            = extremes[n];
+        result[size - 1 - n] = extremes[n];
+    }
+    return result;
+}
+
+// A destination with guard bytes after size elements, which converters must leave alone.
+template <typename T>
+std::vector<T> guarded(std::size_t size)
+{
+    return std::vector<T>(size + guard, static_cast<T>(0x5A));
+}
+
+template <typename T>
+bool guard_intact(const std::vector<T>& dest, std::size_t size)
+{
+    for (auto n = size; n < dest.size(); ++n) {
+        if (dest[n] != static_cast<T>(0x5A)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(audio_util)
+
+BOOST_AUTO_TEST_CASE(int16_matches_scalar)
+{
+    for (std::size_t size = 0; size <= 40; ++size) {
+        const auto src  = samples(size);
+        auto       dest = guarded<std::int16_t>(size);
+        core::audio_32_to_16(src.data(), dest.data(), size);
+
+        for (std::size_t n = 0; n < size; ++n) {
+            BOOST_REQUIRE_EQUAL(dest[n], static_cast<std::int16_t>(src[n] >> 16));
+        }
+        BOOST_CHECK(guard_intact(dest, size));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(dithered_int16_stays_within_the_dither)
+{
+    core::tpdf_dither dither;
+    for (std::size_t size = 0; size <= 40; ++size) {
+        const auto src  = samples(size);
+        auto       dest = guarded<std::int16_t>(size);
+        core::audio_32_to_16(src.data(), dest.data(), size, dither);
+
+        for (std::size_t n = 0; n < size; ++n) {
+            const auto exact = src[n] / 65536.0;
+            BOOST_REQUIRE_LE(std::abs(dest[n] - exact), 1.5);
+        }
+        BOOST_CHECK(guard_intact(dest, size));
+    }
+
+    // Full scale saturates rather than wrapping.
+    const std::vector<std::int32_t> extremes(37, std::numeric_limits<std::int32_t>::max());
+    std::vector<std::int16_t>       dest(extremes.size());
+    core::audio_32_to_16(extremes.data(), dest.data(), extremes.size(), dither);
+    for (auto value : dest) {
+        BOOST_REQUIRE_GE(value, 32766);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(dithered_int16_is_unbiased)
+{
+    // Half a step between two values averages to the middle, in the vector loop and the tail alike.
+    const std::vector<std::int32_t> src(100003, 0x8000);
+    std::vector<std::int16_t>       dest(src.size());
+    core::tpdf_dither               dither;
+    core::audio_32_to_16(src.data(), dest.data(), src.size(), dither);
+
+    double sum = 0.0;
+    for (auto value : dest) {
+        BOOST_REQUIRE(value == 0 || value == 1);
+        sum += value;
+    }
+    BOOST_CHECK_SMALL(sum / dest.size() - 0.5, 0.01);
+}
+
+BOOST_AUTO_TEST_CASE(packed_int24_matches_scalar_without_overrun)
+{
+    // The vector loop stores 16 bytes for every 12 it keeps, the guard catches stores past 3 * size.
+    for (std::size_t size = 0; size <= 40; ++size) {
+        const auto src  = samples(size);
+        auto       dest = guarded<std::int8_t>(size * 3);
+        core::audio_32_to_24(src.data(), dest.data(), size);
+
+        for (std::size_t n = 0; n < size; ++n) {
+            std::int8_t bytes[4];
+            std::memcpy(bytes, &src[n], 4);
+            BOOST_REQUIRE_EQUAL(dest[n * 3 + 0], bytes[1]);
+            BOOST_REQUIRE_EQUAL(dest[n * 3 + 1], bytes[2]);
+            BOOST_REQUIRE_EQUAL(dest[n * 3 + 2], bytes[3]);
+        }
+        BOOST_CHECK(guard_intact(dest, size * 3));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(float_matches_scalar)
+{
+    for (std::size_t size = 0; size <= 40; ++size) {
+        const auto src  = samples(size);
+        auto       dest = guarded<float>(size);
+        core::audio_32_to_float(src.data(), dest.data(), size);
+
+        for (std::size_t n = 0; n < size; ++n) {
+            BOOST_REQUIRE_EQUAL(dest[n], static_cast<float>(src[n]) * (1.0f / 2147483648.0f));
+            BOOST_REQUIRE(dest[n] >= -1.0f && dest[n] <= 1.0f);
+        }
+        BOOST_CHECK(guard_intact(dest, size));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <core/frame/field_weave.h>
+#include <core/frame/frame.h>
+#include <core/frame/pixel_format.h>
+
+#include <common/array.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace caspar;
+
+namespace {
+
+std::vector<std::uint8_t> make_picture(std::size_t size, std::uint8_t seed)
+{
+    std::vector<std::uint8_t> picture(size);
+    for (std::size_t n = 0; n < size; ++n) {
+        picture[n] = static_cast<std::uint8_t>(n * 31 + seed);
+    }
+    return picture;
+}
+
+std::vector<std::uint8_t> reference_weave(const std::vector<std::uint8_t>& upper,
+                                          const std::vector<std::uint8_t>& lower,
+                                          std::size_t                      linesize,
+                                          std::size_t                      height)
+{
+    std::vector<std::uint8_t> dest(linesize * height);
+    for (std::size_t y = 0; y < height; ++y) {
+        for (std::size_t x = 0; x < linesize; ++x) {
+            dest[y * linesize + x] = (y % 2 == 0 ? upper : lower)[y * linesize + x];
+        }
+    }
+    return dest;
+}
+
+void check_weave(std::size_t linesize, std::size_t height, std::size_t offset)
+{
+    auto upper = make_picture(linesize * height, 1);
+    auto lower = make_picture(linesize * height, 128);
+
+    // Over-allocate so that dest can be placed at an aligned or unaligned address.
+    std::vector<std::uint8_t> storage(linesize * height + 32);
+    auto dest = storage.data() + (16 - reinterpret_cast<std::uintptr_t>(storage.data()) % 16) + offset;
+
+    core::weave_fields(dest, upper.data(), lower.data(), linesize, height);
+
+    auto expected = reference_weave(upper, lower, linesize, height);
+    BOOST_CHECK_EQUAL_COLLECTIONS(dest, dest + expected.size(), expected.begin(), expected.end());
+}
+
+core::const_frame make_frame(int width, int height, std::uint8_t seed)
+{
+    core::pixel_format_desc desc(core::pixel_format::bgra);
+    desc.planes.push_back(core::pixel_format_desc::plane(width, height, 4));
+
+    auto picture = std::make_shared<std::vector<std::uint8_t>>(make_picture(desc.planes[0].size, seed));
+
+    std::vector<array<const std::uint8_t>> image_data;
+    image_data.emplace_back(picture->data(), picture->size(), picture);
+    return core::const_frame(std::move(image_data), array<const std::int32_t>{}, desc);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(field_weave)
+
+BOOST_AUTO_TEST_CASE(aligned_matches_reference) { check_weave(1920 * 4, 1080, 0); }
+
+BOOST_AUTO_TEST_CASE(unaligned_dest_matches_reference) { check_weave(1920 * 4, 1080, 3); }
+
+BOOST_AUTO_TEST_CASE(odd_linesize_matches_reference) { check_weave(721 * 3, 487, 0); }
+
+BOOST_AUTO_TEST_CASE(single_row_matches_reference) { check_weave(64, 1, 0); }
+
+BOOST_AUTO_TEST_CASE(frames_match_reference)
+{
+    auto upper = make_frame(720, 576, 1);
+    auto lower = make_frame(720, 576, 128);
+
+    auto data = core::weave_fields(upper, lower);
+    auto dest = static_cast<const std::uint8_t*>(data.get());
+
+    auto expected = reference_weave(make_picture(720 * 576 * 4, 1), make_picture(720 * 576 * 4, 128), 720 * 4, 576);
+    BOOST_CHECK_EQUAL_COLLECTIONS(dest, dest + expected.size(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(frames_of_different_size_throw)
+{
+    auto upper = make_frame(720, 576, 1);
+    auto lower = make_frame(720, 480, 1);
+
+    BOOST_CHECK_THROW(core::weave_fields(upper, lower), std::exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,313 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <core/frame/frame.h>
+#include <core/frame/frame_conversion.h>
+#include <core/frame/pixel_format.h>
+
+#include <common/array.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+using namespace caspar;
+
+namespace {
+
+// Odd, not a multiple of the 6 pixel v210 group and not a multiple of 16 bytes, so that every tail is exercised.
+const int width  = 27;
+const int height = 5;
+
+core::const_frame bgra_frame(const std::vector<std::uint8_t>& image)
+{
+    std::vector<array<const std::uint8_t>> image_data;
+    image_data.emplace_back(array<const std::uint8_t>(image));
+
+    core::pixel_format_desc desc(core::pixel_format::bgra);
+    desc.planes.push_back(core::pixel_format_desc::plane(width, height, 4));
+
+    return core::const_frame(std::move(image_data), array<const std::int32_t>{}, desc);
+}
+
+core::const_frame bgra_frame(const std::vector<std::uint16_t>& image)
+{
+    const auto bytes = reinterpret_cast<const std::uint8_t*>(image.data());
+
+    std::vector<array<const std::uint8_t>> image_data;
+    image_data.emplace_back(array<const std::uint8_t>(std::vector<std::uint8_t>(bytes, bytes + image.size() * 2)));
+
+    core::pixel_format_desc desc(core::pixel_format::bgra, core::color_depth::sixteen);
+    desc.planes.push_back(core::pixel_format_desc::plane(width, height, 8));
+
+    return core::const_frame(std::move(image_data), array<const std::int32_t>{}, desc);
+}
+
+std::vector<std::uint8_t> make_image()
+{
+    std::vector<std::uint8_t> image(width * height * 4);
+    for (std::size_t n = 0; n < image.size(); ++n) {
+        image[n] = static_cast<std::uint8_t>(n * 37 + n / 7);
+    }
+    return image;
+}
+
+std::vector<std::uint16_t> make_image16()
+{
+    std::vector<std::uint16_t> image(width * height * 4);
+    for (std::size_t n = 0; n < image.size(); ++n) {
+        image[n] = static_cast<std::uint16_t>(n * 9973 + n / 7);
+    }
+    return image;
+}
+
+struct ycbcr10
+{
+    std::vector<int> y;
+    std::vector<int> cb;
+    std::vector<int> cr;
+};
+
+// BT.709 limited range 10 bit 4:2:2 in double precision, chroma sited between each pair of pixels. max is the
+// largest value of the input channels.
+template <typename T>
+ycbcr10 reference_ycbcr10(const std::vector<T>& image, double max)
+{
+    const auto kr = 0.2126;
+    const auto kb = 0.0722;
+    const auto kg = 1.0 - kr - kb;
+
+    const auto c_width = (width + 1) / 2;
+
+    ycbcr10 result;
+    for (int row = 0; row < height; ++row) {
+        auto pixel = [&](int x, int c) { return image[(row * width + std::min(x, width - 1)) * 4 + c] / max; };
+
+        for (int x = 0; x < width; ++x) {
+            const auto luma = kr * pixel(x, 2) + kg * pixel(x, 1) + kb * pixel(x, 0);
+            result.y.push_back(static_cast<int>(std::lround(64.0 + 876.0 * luma)));
+        }
+        for (int x = 0; x < c_width; ++x) {
+            const auto r    = (pixel(x * 2, 2) + pixel(x * 2 + 1, 2)) / 2.0;
+            const auto g    = (pixel(x * 2, 1) + pixel(x * 2 + 1, 1)) / 2.0;
+            const auto b    = (pixel(x * 2, 0) + pixel(x * 2 + 1, 0)) / 2.0;
+            const auto luma = kr * r + kg * g + kb * b;
+            result.cb.push_back(static_cast<int>(std::lround(512.0 + 896.0 * (b - luma) / (2.0 * (1.0 - kb)))));
+            result.cr.push_back(static_cast<int>(std::lround(512.0 + 896.0 * (r - luma) / (2.0 * (1.0 - kr)))));
+        }
+    }
+    return result;
+}
+
+// The fixed point conversion may round differently from the double precision reference, but by at most one.
+void check_close(const std::uint16_t* actual, const std::vector<int>& expected)
+{
+    for (std::size_t n = 0; n < expected.size(); ++n) {
+        BOOST_TEST_CONTEXT("sample " << n)
+        {
+            BOOST_CHECK_LE(std::abs(static_cast<int>(actual[n]) - expected[n]), 1);
+        }
+    }
+}
+
+void check_yuv422p10(const core::const_frame& frame, const ycbcr10& expected)
+{
+    const auto c_width = (width + 1) / 2;
+    const auto planes  = core::yuv422p10(frame);
+
+    BOOST_REQUIRE_EQUAL(planes.size(), static_cast<std::size_t>(width * height + c_width * height * 2));
+    check_close(planes.data(), expected.y);
+    check_close(planes.data() + width * height, expected.cb);
+    check_close(planes.data() + width * height + c_width * height, expected.cr);
+}
+
+// Packs yuv422p10 output as UYVY, so that the packing is checked exactly.
+std::vector<std::uint8_t> reference_uyvy(const array<const std::uint16_t>& planes)
+{
+    const auto c_width = (width + 1) / 2;
+    const auto y       = planes.data();
+    const auto cb      = y + width * height;
+    const auto cr      = cb + c_width * height;
+
+    auto to8 = [](int v) { return static_cast<std::uint8_t>((v + 2) / 4); };
+
+    std::vector<std::uint8_t> result;
+    for (int row = 0; row < height; ++row) {
+        for (int x = 0; x < c_width; ++x) {
+            result.push_back(to8(cb[row * c_width + x]));
+            result.push_back(to8(y[row * width + x * 2]));
+            result.push_back(to8(cr[row * c_width + x]));
+            result.push_back(to8(y[row * width + std::min(x * 2 + 1, width - 1)]));
+        }
+    }
+    return result;
+}
+
+// Packs yuv422p10 output as v210, three components per word in Cb Y Cr Y order, the last pixel repeated to fill a
+// group of six and rows padded with zeros to 128 bytes.
+std::vector<std::uint32_t> reference_v210(const array<const std::uint16_t>& planes)
+{
+    const auto c_width  = (width + 1) / 2;
+    const auto groups   = (width + 5) / 6;
+    const auto linesize = (width + 47) / 48 * 32;
+    const auto y        = planes.data();
+    const auto cb       = y + width * height;
+    const auto cr       = cb + c_width * height;
+
+    std::vector<std::uint32_t> result(linesize * height, 0);
+    for (int row = 0; row < height; ++row) {
+        std::vector<std::uint32_t> components;
+        for (int x = 0; x < groups * 6; x += 2) {
+            const auto c = std::min(x / 2, c_width - 1);
+            components.push_back(cb[row * c_width + c]);
+            components.push_back(y[row * width + std::min(x, width - 1)]);
+            components.push_back(cr[row * c_width + c]);
+            components.push_back(y[row * width + std::min(x + 1, width - 1)]);
+        }
+        for (std::size_t n = 0; n < components.size(); n += 3) {
+            result[row * linesize + n / 3] = components[n] | components[n + 1] << 10 | components[n + 2] << 20;
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(frame_conversion)
+
+BOOST_AUTO_TEST_CASE(bgra8_of_eight_bit_frame_is_the_frame)
+{
+    const auto frame = bgra_frame(make_image());
+
+    BOOST_CHECK(core::bgra8(frame).data() == frame.image_data(0).data());
+}
+
+BOOST_AUTO_TEST_CASE(key_only_spreads_alpha)
+{
+    const auto image = make_image();
+    const auto frame = bgra_frame(image);
+    const auto key   = core::key_only(frame);
+
+    std::vector<std::uint8_t> expected(image.size());
+    for (std::size_t n = 0; n < image.size(); ++n) {
+        expected[n] = image[n / 4 * 4 + 3];
+    }
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(key.begin(), key.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(yuv422p10_matches_reference)
+{
+    const auto image = make_image();
+
+    check_yuv422p10(bgra_frame(image), reference_ycbcr10(image, 255.0));
+}
+
+BOOST_AUTO_TEST_CASE(uyvy_packs_yuv422p10)
+{
+    const auto frame    = bgra_frame(make_image());
+    const auto actual   = core::uyvy(frame);
+    const auto expected = reference_uyvy(core::yuv422p10(frame));
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(v210_packs_yuv422p10)
+{
+    const auto frame    = bgra_frame(make_image());
+    const auto actual   = core::v210(frame);
+    const auto expected = reference_v210(core::yuv422p10(frame));
+
+    BOOST_CHECK_EQUAL(core::v210_linesize(width), 128);
+    BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(bgra8_rounds_sixteen_bit_frames)
+{
+    // Every 16 bit value, a frame at a time.
+    for (auto first = 0; first < 65536; first += width * height * 4) {
+        std::vector<std::uint16_t> image(width * height * 4);
+        for (std::size_t n = 0; n < image.size(); ++n) {
+            image[n] = static_cast<std::uint16_t>(first + n);
+        }
+
+        const auto actual = core::bgra8(bgra_frame(image));
+
+        std::vector<std::uint8_t> expected(image.size());
+        for (std::size_t n = 0; n < image.size(); ++n) {
+            expected[n] = static_cast<std::uint8_t>(std::lround(image[n] / 257.0));
+        }
+
+        BOOST_REQUIRE_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(yuv422p10_of_sixteen_bit_frame_matches_reference)
+{
+    const auto image = make_image16();
+
+    check_yuv422p10(bgra_frame(image), reference_ycbcr10(image, 65535.0));
+}
+
+BOOST_AUTO_TEST_CASE(v210_of_sixteen_bit_frame_packs_yuv422p10)
+{
+    const auto frame    = bgra_frame(make_image16());
+    const auto actual   = core::v210(frame);
+    const auto expected = reference_v210(core::yuv422p10(frame));
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(uyvy_of_sixteen_bit_frame_packs_yuv422p10)
+{
+    const auto frame    = bgra_frame(make_image16());
+    const auto actual   = core::uyvy(frame);
+    const auto expected = reference_uyvy(core::yuv422p10(frame));
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(representations_are_cached_per_frame)
+{
+    const auto frame = bgra_frame(make_image());
+
+    BOOST_CHECK(core::uyvy(frame).data() == core::uyvy(frame).data());
+    BOOST_CHECK(core::v210(frame).data() == core::v210(frame).data());
+    BOOST_CHECK(core::uyvy(frame).data() != core::uyvy(bgra_frame(make_image())).data());
+}
+
+BOOST_AUTO_TEST_CASE(non_bgra_frames_throw)
+{
+    std::vector<array<const std::uint8_t>> image_data;
+    image_data.emplace_back(array<const std::uint8_t>(std::vector<std::uint8_t>(width * height * 2)));
+
+    core::pixel_format_desc desc(core::pixel_format::ycbcr);
+    desc.planes.push_back(core::pixel_format_desc::plane(width, height, 2));
+
+    const auto frame = core::const_frame(std::move(image_data), array<const std::int32_t>{}, desc);
+
+    BOOST_CHECK_THROW(core::yuv422p10(frame), std::exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <core/mixer/audio/loudness_meter.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+using namespace caspar;
+
+namespace {
+
+const int sample_rate = 48000;
+
+// Feeds seconds of a stereo 1 kHz sine at level dBFS, in blocks of one 50p frame.
+void sine(core::loudness_meter& meter, double level, double seconds, std::int64_t& position)
+{
+    const auto amplitude = std::pow(10.0, level / 20.0) * 2147483648.0;
+    const auto frames    = static_cast<std::int64_t>(seconds * sample_rate);
+    const auto pi        = 3.14159265358979323846;
+
+    std::vector<float> samples;
+    for (std::int64_t n = 0; n < frames; n += 960) {
+        const auto count = std::min<std::int64_t>(960, frames - n);
+        samples.resize(count * 2);
+        for (std::int64_t m = 0; m < count; ++m) {
+            const auto value   = static_cast<float>(amplitude * std::sin(2.0 * pi * 1000.0 * position++ / sample_rate));
+            samples[m * 2 + 0] = value;
+            samples[m * 2 + 1] = value;
+        }
+        meter.process(samples.data(), samples.size());
+    }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(loudness_meter)
+
+// EBU Tech 3341, case 1 and 2.
+BOOST_AUTO_TEST_CASE(sine_at_minus_23_dbfs_is_minus_23_lufs)
+{
+    core::loudness_meter meter(core::loudness_weights(L"stereo", 2), sample_rate);
+    std::int64_t         position = 0;
+    sine(meter, -23.0, 20.0, position);
+
+    const auto loudness = meter.get();
+    BOOST_CHECK_SMALL(loudness.momentary + 23.0, 0.1);
+    BOOST_CHECK_SMALL(loudness.short_term + 23.0, 0.1);
+    BOOST_CHECK_SMALL(loudness.integrated + 23.0, 0.1);
+    BOOST_CHECK_SMALL(loudness.true_peak + 23.0, 0.2);
+}
+
+// EBU Tech 3341, case 3.
+BOOST_AUTO_TEST_CASE(relative_gate_ignores_quiet_parts)
+{
+    core::loudness_meter meter(core::loudness_weights(L"stereo", 2), sample_rate);
+    std::int64_t         position = 0;
+    sine(meter, -36.0, 10.0, position);
+    sine(meter, -23.0, 60.0, position);
+    sine(meter, -36.0, 10.0, position);
+
+    BOOST_CHECK_SMALL(meter.get().integrated + 23.0, 0.1);
+}
+
+// EBU Tech 3342, case 1.
+BOOST_AUTO_TEST_CASE(loudness_range_of_two_levels)
+{
+    core::loudness_meter meter(core::loudness_weights(L"stereo", 2), sample_rate);
+    std::int64_t         position = 0;
+    sine(meter, -20.0, 20.0, position);
+    sine(meter, -30.0, 20.0, position);
+
+    BOOST_CHECK_SMALL(meter.get().range - 10.0, 1.0);
+}
+
+BOOST_AUTO_TEST_CASE(reset_restarts_true_peak)
+{
+    core::loudness_meter meter(core::loudness_weights(L"stereo", 2), sample_rate);
+    std::int64_t         position = 0;
+    sine(meter, -10.0, 5.0, position);
+    meter.reset();
+    sine(meter, -30.0, 5.0, position);
+
+    BOOST_CHECK_SMALL(meter.get().true_peak + 30.0, 0.2);
+}
+
+BOOST_AUTO_TEST_CASE(rejects_unknown_layouts)
+{
+    BOOST_CHECK_THROW(core::loudness_weights(L"quad", 4), std::exception);
+    BOOST_CHECK((core::loudness_weights(L"stereo", 4) == std::vector<double>{1.0, 1.0, 0.0, 0.0}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <common/diagnostics/graph.h>
+#include <common/memory.h>
+
+#include <core/frame/draw_frame.h>
+#include <core/frame/frame.h>
+#include <core/frame/pixel_format.h>
+#include <core/mixer/image/image_mixer.h>
+#include <core/mixer/mixer.h>
+#include <core/video_format.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+using namespace caspar;
+
+namespace {
+
+core::const_frame audio_frame(int channels, int samples, std::int32_t value)
+{
+    std::vector<array<const std::uint8_t>> image_data;
+    image_data.emplace_back(array<const std::uint8_t>{});
+
+    core::pixel_format_desc desc(core::pixel_format::bgra);
+    desc.planes.push_back(core::pixel_format_desc::plane(0, 0, 4));
+
+    return core::const_frame(std::move(image_data),
+                             array<const std::int32_t>(std::vector<std::int32_t>(samples * channels, value)),
+                             desc);
+}
+
+// Mixes a tick of a constant value on layer 10 and returns the first sample frame's value.
+std::int32_t tick(core::mixer& mixer, const core::video_format_desc& format_desc, std::int32_t value)
+{
+    const auto samples = format_desc.audio_cadence.front();
+
+    std::map<int, core::draw_frame> frames;
+    frames.emplace(10, core::draw_frame(audio_frame(format_desc.audio_channels, samples, value)));
+
+    const auto frame = mixer(std::move(frames), format_desc, samples);
+    BOOST_REQUIRE_EQUAL(frame.audio_data().size(), static_cast<std::size_t>(samples * format_desc.audio_channels));
+    return frame.audio_data().data()[0];
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(mixer)
+
+BOOST_AUTO_TEST_CASE(audio_delay_changes_apply_on_the_next_tick)
+{
+    const auto format_desc = core::video_format_desc(L"1080i5000");
+
+    core::mixer mixer(1, spl::make_shared<diagnostics::graph>(), nullptr);
+
+    // Ticks carry the values 1, 2, 3... and each check looks at the tick after three to settle.
+    auto value  = 0;
+    auto settle = [&] {
+        for (auto n = 0; n < 3; ++n) {
+            tick(mixer, format_desc, ++value << 20);
+        }
+        ++value;
+        return tick(mixer, format_desc, value << 20);
+    };
+
+    const auto undelayed = settle();
+    BOOST_CHECK_EQUAL(undelayed, value << 20);
+
+    // A whole tick of delay starts every tick with the previous tick's audio.
+    mixer.set_audio_delay(10, format_desc.audio_cadence.front());
+    BOOST_CHECK_EQUAL(mixer.get_audio_delay(10), format_desc.audio_cadence.front());
+    const auto delayed = settle();
+    BOOST_CHECK_EQUAL(delayed, (value - 1) << 20);
+
+    mixer.set_audio_delay(10, 0);
+    const auto removed = settle();
+    BOOST_CHECK_EQUAL(removed, value << 20);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <core/consumer/frame_consumer.h>
+#include <core/consumer/null/null_consumer.h>
+#include <core/frame/frame.h>
+#include <core/frame/pixel_format.h>
+#include <core/monitor/monitor.h>
+#include <core/video_format.h>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/variant/get.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace caspar;
+
+namespace {
+
+core::const_frame fixed_frame()
+{
+    std::vector<std::uint8_t> image(16 * 9 * 4);
+    for (std::size_t n = 0; n < image.size(); ++n) {
+        image[n] = static_cast<std::uint8_t>(n * 7);
+    }
+
+    std::vector<std::int32_t> audio(32);
+    for (std::size_t n = 0; n < audio.size(); ++n) {
+        audio[n] = static_cast<std::int32_t>(n) * 100003 - 800000;
+    }
+
+    std::vector<array<const std::uint8_t>> image_data;
+    image_data.emplace_back(array<const std::uint8_t>(std::move(image)));
+
+    core::pixel_format_desc desc(core::pixel_format::bgra);
+    desc.planes.push_back(core::pixel_format_desc::plane(16, 9, 4));
+
+    return core::const_frame(std::move(image_data), array<const std::int32_t>(std::move(audio)), desc);
+}
+
+spl::shared_ptr<core::frame_consumer> make_consumer(std::vector<std::wstring> params)
+{
+    auto consumer = core::create_null_consumer(params, {});
+    consumer->initialize(core::video_format_desc(L"1080i5000"), 1);
+    return consumer;
+}
+
+template <typename T>
+T value(const core::frame_consumer& consumer, const std::string& key)
+{
+    const auto data = consumer.state().get();
+    const auto it   = data.find(key);
+    BOOST_REQUIRE_MESSAGE(it != data.end() && !it->second.empty(), key);
+    return boost::get<T>(it->second.front());
+}
+
+std::uint64_t xxh64(const std::string& str) { return core::xxh64(str.data(), str.size(), 0); }
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(null_consumer)
+
+BOOST_AUTO_TEST_CASE(xxh64_matches_reference)
+{
+    BOOST_CHECK_EQUAL(xxh64(""), 0xef46db3751d8e999ULL);
+    BOOST_CHECK_EQUAL(xxh64("abc"), 0x44bc2cf5ad770999ULL);
+
+    // Long enough for the four lanes, with 8 byte, 4 byte and single byte tails.
+    BOOST_CHECK_EQUAL(xxh64("Nobody inspects the spammish repetition"), 0xfbcea83c8a378bf1ULL);
+}
+
+BOOST_AUTO_TEST_CASE(checksums_are_stable)
+{
+    auto consumer = make_consumer({L"NULL", L"CHECKSUM"});
+
+    consumer->send(fixed_frame()).get();
+    BOOST_CHECK_EQUAL(value<std::string>(*consumer, "null/checksum/image"), "b638b47362f479dd");
+    BOOST_CHECK_EQUAL(value<std::string>(*consumer, "null/checksum/audio"), "5d70385acdcefb2f");
+    BOOST_CHECK_EQUAL(value<std::string>(*consumer, "null/checksum/stream"), "02e249ea38f21309");
+
+    // The stream checksum chains every frame, the same frame again hashes the same.
+    consumer->send(fixed_frame()).get();
+    BOOST_CHECK_EQUAL(value<std::string>(*consumer, "null/checksum/image"), "b638b47362f479dd");
+    BOOST_CHECK_EQUAL(value<std::string>(*consumer, "null/checksum/stream"), "2041665804c96965");
+
+    // Initializing starts a new stream.
+    consumer->initialize(core::video_format_desc(L"1080i5000"), 1);
+    consumer->send(fixed_frame()).get();
+    BOOST_CHECK_EQUAL(value<std::string>(*consumer, "null/checksum/stream"), "02e249ea38f21309");
+}
+
+BOOST_AUTO_TEST_CASE(checksums_are_optional)
+{
+    auto consumer = make_consumer({L"NULL"});
+    consumer->send(fixed_frame()).get();
+
+    const auto data = consumer->state().get();
+    BOOST_CHECK(data.find("null/checksum/stream") == data.end());
+    BOOST_CHECK_EQUAL(value<std::int64_t>(*consumer, "null/frame"), 0);
+}
+
+BOOST_AUTO_TEST_CASE(fps_counts_frames_per_second)
+{
+    auto consumer = make_consumer({L"NULL"});
+
+    // Roughly 50 frames a second for a little over the one second window.
+    const auto start = std::chrono::steady_clock::now();
+    auto       sent  = 0;
+    while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(1200)) {
+        consumer->send(fixed_frame()).get();
+        ++sent;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    BOOST_CHECK_EQUAL(value<std::int64_t>(*consumer, "null/frame"), sent - 1);
+
+    const auto fps = value<double>(*consumer, "null/fps");
+    BOOST_CHECK_GT(fps, 20.0);
+    BOOST_CHECK_LE(fps, 51.0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
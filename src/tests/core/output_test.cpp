@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <common/diagnostics/graph.h>
+#include <common/future.h>
+#include <common/memory.h>
+
+#include <core/consumer/frame_consumer.h>
+#include <core/consumer/output.h>
+#include <core/frame/frame.h>
+#include <core/frame/pixel_format.h>
+#include <core/video_format.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <vector>
+
+using namespace caspar;
+
+namespace {
+
+core::const_frame audio_frame(const core::video_format_desc& format_desc, std::int32_t value)
+{
+    std::vector<array<const std::uint8_t>> image_data;
+    image_data.emplace_back(array<const std::uint8_t>{});
+
+    core::pixel_format_desc desc(core::pixel_format::bgra);
+    desc.planes.push_back(core::pixel_format_desc::plane(0, 0, 4));
+
+    const auto samples = format_desc.audio_cadence.front() * format_desc.audio_channels;
+    return core::const_frame(
+        std::move(image_data), array<const std::int32_t>(std::vector<std::int32_t>(samples, value)), desc);
+}
+
+// Keeps the first sample of every frame it is sent. Claims the clock so that ticks don't wait.
+struct recording_consumer : public core::frame_consumer
+{
+    std::vector<std::int32_t> samples;
+    bool                      fail = false;
+
+    std::future<bool> send(core::const_frame frame) override
+    {
+        samples.push_back(frame.audio_data().data()[0]);
+        return make_ready_future(!fail);
+    }
+
+    void         initialize(const core::video_format_desc&, int) override {}
+    std::wstring print() const override { return L"recording"; }
+    std::wstring name() const override { return L"recording"; }
+    bool         has_synchronization_clock() const override { return true; }
+    int          index() const override { return 1; }
+    bool         supports_audio_only() const override { return true; }
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(output)
+
+BOOST_AUTO_TEST_CASE(audio_delays_apply_on_the_next_tick)
+{
+    const auto format_desc = core::video_format_desc(L"1080i5000");
+
+    core::output output(spl::make_shared<diagnostics::graph>(), format_desc, 1);
+    auto         consumer = spl::make_shared<recording_consumer>();
+    output.add(consumer);
+
+    output(audio_frame(format_desc, 1), format_desc);
+    output.set_audio_delay(1, format_desc.audio_cadence.front());
+    output(audio_frame(format_desc, 2), format_desc);
+    output(audio_frame(format_desc, 3), format_desc);
+
+    // Delays keep what they hold when other delays change, and start over with a new format.
+    output.set_audio_delay(2, 10);
+    output(audio_frame(format_desc, 4), format_desc);
+
+    const auto other = core::video_format_desc(L"720p5000");
+    output(audio_frame(other, 5), other);
+    output(audio_frame(other, 6), other);
+    output(audio_frame(other, 7), other);
+
+    output.set_audio_delay(1, 0);
+    output(audio_frame(other, 8), other);
+
+    BOOST_CHECK(consumer->samples == (std::vector<std::int32_t>{1, 0, 2, 3, 0, 6, 8}));
+}
+
+BOOST_AUTO_TEST_CASE(failed_consumers_are_removed)
+{
+    const auto format_desc = core::video_format_desc(L"1080i5000");
+
+    core::output output(spl::make_shared<diagnostics::graph>(), format_desc, 1);
+    auto         failing = spl::make_shared<recording_consumer>();
+    failing->fail        = true;
+    output.add(failing);
+
+    output(audio_frame(format_desc, 1), format_desc);
+    output(audio_frame(format_desc, 2), format_desc);
+    BOOST_CHECK(failing->samples == (std::vector<std::int32_t>{1}));
+
+    auto replacement = spl::make_shared<recording_consumer>();
+    output.add(replacement);
+    output(audio_frame(format_desc, 3), format_desc);
+    BOOST_CHECK(replacement->samples == (std::vector<std::int32_t>{3}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
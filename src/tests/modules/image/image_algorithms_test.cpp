@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <modules/image/util/image_algorithms.h>
+#include <modules/image/util/image_view.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace caspar;
+
+namespace {
+
+// 111 pixels, so that the scalar tail after the vector loop handles the last three.
+const int width  = 37;
+const int height = 3;
+
+// Random pixels with alpha 0, 255 or anything in between. Colors are kept at or below alpha when premultiplied.
+std::vector<std::uint8_t> random_pixels(unsigned seed, bool premultiplied)
+{
+    std::mt19937                       rng(seed);
+    std::uniform_int_distribution<int> dist(0, 255);
+
+    std::vector<std::uint8_t> pixels(width * height * 4);
+    for (std::size_t n = 0; n < pixels.size(); n += 4) {
+        const auto kind  = dist(rng) % 4;
+        const auto alpha = kind == 0 ? 0 : (kind == 1 ? 255 : dist(rng));
+        for (int c = 0; c < 3; ++c) {
+            pixels[n + c] = static_cast<std::uint8_t>(premultiplied ? dist(rng) * alpha / 255 : dist(rng));
+        }
+        pixels[n + 3] = static_cast<std::uint8_t>(alpha);
+    }
+    return pixels;
+}
+
+// A run of four opaque pixels, which the vector loop skips, and a transparent, an opaque and a partly transparent
+// pixel in the scalar tail.
+void set_edge_cases(std::vector<std::uint8_t>& pixels)
+{
+    std::fill(pixels.begin(), pixels.begin() + 16, 255);
+
+    const std::uint8_t tail[] = {90, 60, 30, 0, 90, 60, 30, 255, 90, 60, 30, 128};
+    std::copy(std::begin(tail), std::end(tail), pixels.end() - 12);
+}
+
+void premultiply(std::vector<std::uint8_t>& pixels)
+{
+    image::image_view<image::bgra_pixel> view(pixels.data(), width, height);
+    image::premultiply(view);
+}
+
+void unmultiply(std::vector<std::uint8_t>& pixels)
+{
+    image::image_view<image::bgra_pixel> view(pixels.data(), width, height);
+    image::unmultiply(view);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(image_algorithms)
+
+BOOST_AUTO_TEST_CASE(premultiply_matches_scalar)
+{
+    auto actual = random_pixels(1, false);
+    set_edge_cases(actual);
+
+    auto expected = actual;
+    for (std::size_t n = 0; n < expected.size(); n += 4) {
+        for (int c = 0; c < 3; ++c) {
+            expected[n + c] = static_cast<std::uint8_t>(std::lround(expected[n + c] * expected[n + 3] / 255.0));
+        }
+    }
+
+    premultiply(actual);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(unmultiply_matches_scalar)
+{
+    auto actual = random_pixels(2, true);
+    set_edge_cases(actual);
+
+    // Colors above alpha saturate, colors with zero alpha are left as they are.
+    const std::uint8_t invalid[] = {200, 60, 30, 100, 90, 60, 30, 0};
+    std::copy(std::begin(invalid), std::end(invalid), actual.begin() + 16);
+
+    auto expected = actual;
+    for (std::size_t n = 0; n < expected.size(); n += 4) {
+        const int alpha = expected[n + 3];
+        for (int c = 0; c < 3 && alpha > 0; ++c) {
+            const int color = expected[n + c];
+            expected[n + c] =
+                static_cast<std::uint8_t>(color > alpha ? 255 : std::lround(color * 255.0 / alpha));
+        }
+    }
+
+    unmultiply(actual);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(unmultiply_inverts_premultiply_of_opaque_and_transparent_pixels)
+{
+    auto pixels = random_pixels(3, false);
+    for (std::size_t n = 0; n < pixels.size(); n += 4) {
+        pixels[n + 3] = n % 8 == 0 ? 255 : 0;
+        if (pixels[n + 3] == 0) {
+            std::fill_n(pixels.begin() + n, 3, 0);
+        }
+    }
+
+    auto result = pixels;
+    premultiply(result);
+    unmultiply(result);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), pixels.begin(), pixels.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "test_env.h"
+
+#include <common/env.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+namespace caspar { namespace tests {
+
+namespace {
+
+// The folder the configuration and its paths live in, removed on exit.
+struct temp_folder
+{
+    boost::filesystem::path path =
+        boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("casparcg-%%%%%%%%");
+
+    ~temp_folder()
+    {
+        boost::system::error_code ec;
+        boost::filesystem::remove_all(path, ec);
+    }
+};
+
+} // namespace
+
+void configure_env()
+{
+    static bool configured = false;
+    if (configured) {
+        return;
+    }
+
+    static temp_folder temp;
+    const auto&        folder = temp.path;
+    boost::filesystem::create_directories(folder);
+
+    const auto paths = folder.wstring();
+    {
+        boost::filesystem::wofstream file(folder / L"casparcg.config");
+        file << L"<configuration><paths>"
+             << L"<media-path>" << paths << L"/media/</media-path>"
+             << L"<log-path>" << paths << L"/log/</log-path>"
+             << L"<template-path>" << paths << L"/template/</template-path>"
+             << L"<data-path>" << paths << L"/data/</data-path>"
+             << L"<font-path>" << paths << L"/font/</font-path>"
+             << L"</paths></configuration>";
+    }
+
+    // env::configure reads the file relative to the initial folder.
+    env::configure(boost::filesystem::relative(folder / L"casparcg.config", boost::filesystem::initial_path()).wstring());
+    configured = true;
+}
+
+}} // namespace caspar::tests